@@ -0,0 +1,91 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Frames/s of the scalar frame builder against the bit-sliced batch encoder.
+ *
+ * Usage: ais_frame_benchmark [payload bits] [frames]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "batch_encoder.h"
+#include "frame_builder.h"
+
+using namespace gr::ais_simulator::framing;
+
+int main(int argc, char **argv)
+{
+    const int len_bits = argc > 1 ? std::atoi(argv[1]) : LEN_SLOT_PAYLOAD;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 1000000;
+    if (len_bits <= 0 || len_bits > LEN_PAYLOAD_MAX || frames <= 0)
+    {
+        std::fprintf(stderr, "usage: %s [payload bits] [frames]\n", argv[0]);
+        return 1;
+    }
+    const int len = (len_bits + 7) / 8;
+    const int out_stride = frame_bytes_max(len * 8);
+
+    std::vector<uint8_t> payloads((size_t)frames * len);
+    std::vector<uint8_t> out_scalar((size_t)frames * out_stride);
+    std::vector<uint8_t> out_batch((size_t)frames * out_stride);
+    std::vector<int> out_len(frames);
+    std::mt19937 rng(1);
+    for (auto &b : payloads)
+    {
+        b = (uint8_t)rng();
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto t0 = clock::now();
+    for (int i = 0; i < frames; i++)
+    {
+        const uint8_t *p = &payloads[(size_t)i * len];
+        uint8_t *o = &out_scalar[(size_t)i * out_stride];
+        if (len * 8 <= LEN_SLOT_PAYLOAD)
+        {
+            build_frame<true, true>(p, len, o);
+        }
+        else
+        {
+            build_frame<true, false>(p, len, o);
+        }
+    }
+    auto t1 = clock::now();
+    batch_encoder::encode(
+        payloads.data(), len, frames, len, true, out_batch.data(), out_stride, out_len.data());
+    auto t2 = clock::now();
+
+    const double scalar = std::chrono::duration<double>(t1 - t0).count();
+    const double batch = std::chrono::duration<double>(t2 - t1).count();
+    std::printf("payload %d bits, %d frames\n", len * 8, frames);
+    std::printf("scalar: %.0f frames/s\n", frames / scalar);
+    std::printf("batch:  %.0f frames/s\n", frames / batch);
+    if (out_scalar != out_batch)
+    {
+        std::fprintf(stderr, "batch output differs from scalar output\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,328 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Build and inspect prebuilt frame libraries for the Frame Library Source
+ * block, see gnuradio/ais_simulator/frame_library.h for the format.
+ *
+ * Usage: ais_frame_library build [--no-nrzi] OUT [IN]
+ *        ais_frame_library info FILE
+ *        ais_frame_library dump [--mmsi N] [--type T] [--from SECONDS] FILE
+ *
+ * build reads one message per line, scheduled time in seconds and payload
+ * as ASCII bit string, from IN or stdin:
+ *
+ *   12.5 000001000000111010111110110001100100...
+ *
+ * Blank lines and lines starting with # are skipped. MMSI and message type
+ * are taken from the payload. The output is written to OUT.tmp and renamed
+ * when complete.
+ */
+
+#include <gnuradio/ais_simulator/frame_library.h>
+#include <gnuradio/ais_simulator/framing.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int usage(const char *name)
+    {
+        std::fprintf(stderr,
+                     "usage: %s build [--no-nrzi] OUT [IN]\n"
+                     "       %s info FILE\n"
+                     "       %s dump [--mmsi N] [--type T] [--from SECONDS] FILE\n",
+                     name, name, name);
+        return 2;
+    }
+
+    uint32_t payload_field(const char *bits, int first, int len)
+    {
+        uint32_t v = 0;
+        for (int i = first; i < first + len; i++)
+        {
+            v = (v << 1) | (bits[i] & 1);
+        }
+        return v;
+    }
+
+    bool write_all(FILE *f, const void *data, size_t len, uint64_t &pos)
+    {
+        static const uint8_t zeros[8] = {};
+        const size_t pad = AIS_FLIB_ALIGN(pos + len) - (pos + len);
+        pos += len + pad;
+        return std::fwrite(data, 1, len, f) == len && std::fwrite(zeros, 1, pad, f) == pad;
+    }
+
+    int build(const char *out_name, const char *in_name, bool nrzi)
+    {
+        FILE *in = in_name ? std::fopen(in_name, "r") : stdin;
+        if (!in)
+        {
+            std::fprintf(stderr, "%s: %s\n", in_name, std::strerror(errno));
+            return 1;
+        }
+
+        std::vector<ais_flib_entry> entries;
+        std::vector<uint8_t> frames;
+        uint8_t frame[AIS_FRAMING_PAYLOAD_MAX / 4];
+        char *line = nullptr;
+        size_t cap = 0;
+        ssize_t n;
+        long line_no = 0;
+        while ((n = getline(&line, &cap, in)) >= 0)
+        {
+            line_no++;
+            char *p = line;
+            while (*p == ' ' || *p == '\t')
+            {
+                p++;
+            }
+            if (*p == '#' || *p == '\n' || *p == '\0')
+            {
+                continue;
+            }
+            char *end;
+            const double time = std::strtod(p, &end);
+            const char *bits = end + std::strspn(end, " \t");
+            const long len_bits = (long)std::strspn(bits, "01");
+            if (end == p || bits == end || len_bits < 38)
+            {
+                std::fprintf(stderr, "line %ld: expected time and payload bits\n", line_no);
+                continue;
+            }
+            const int len = ais_encode_bits(bits, len_bits, nrzi, frame, sizeof(frame));
+            if (len <= 0)
+            {
+                std::fprintf(stderr, "line %ld: %s\n", line_no, std::strerror(-len));
+                continue;
+            }
+
+            ais_flib_entry e = {};
+            e.time = time;
+            e.offset = frames.size();
+            e.mmsi = payload_field(bits, 8, 30);
+            e.type = (uint8_t)payload_field(bits, 0, 6);
+            e.len = (uint16_t)len;
+            entries.push_back(e);
+            frames.insert(frames.end(), frame, frame + len);
+        }
+        std::free(line);
+        if (in != stdin)
+        {
+            std::fclose(in);
+        }
+
+        // Time order for streaming, input order among equal times.
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const ais_flib_entry &a, const ais_flib_entry &b) { return a.time < b.time; });
+        std::vector<uint32_t> by_mmsi(entries.size());
+        std::iota(by_mmsi.begin(), by_mmsi.end(), 0);
+        std::stable_sort(by_mmsi.begin(), by_mmsi.end(), [&entries](uint32_t a, uint32_t b) {
+            const ais_flib_entry &ea = entries[a];
+            const ais_flib_entry &eb = entries[b];
+            return ea.mmsi != eb.mmsi ? ea.mmsi < eb.mmsi : ea.type < eb.type;
+        });
+
+        // Frame data in streaming order for sequential read-ahead.
+        std::vector<uint8_t> data(frames.size());
+        uint64_t offset = 0;
+        for (auto &e : entries)
+        {
+            std::memcpy(&data[offset], &frames[e.offset], e.len);
+            e.offset = offset;
+            offset += e.len;
+        }
+        std::vector<uint8_t>().swap(frames);
+
+        ais_flib_header h = {};
+        h.magic = AIS_FLIB_MAGIC;
+        h.version = AIS_FLIB_VERSION;
+        h.flags = nrzi ? AIS_FLIB_NRZI : 0;
+        h.entry_size = sizeof(ais_flib_entry);
+        h.count = entries.size();
+        h.entries = AIS_FLIB_ALIGN(sizeof(h));
+        h.by_mmsi = AIS_FLIB_ALIGN(h.entries + entries.size() * sizeof(ais_flib_entry));
+        h.data = AIS_FLIB_ALIGN(h.by_mmsi + by_mmsi.size() * sizeof(uint32_t));
+        h.data_size = data.size();
+
+        const std::string tmp = std::string(out_name) + ".tmp";
+        FILE *out = std::fopen(tmp.c_str(), "wb");
+        if (!out)
+        {
+            std::fprintf(stderr, "%s: %s\n", tmp.c_str(), std::strerror(errno));
+            return 1;
+        }
+        uint64_t pos = 0;
+        bool ok = write_all(out, &h, sizeof(h), pos) &&
+                  write_all(out, entries.data(), entries.size() * sizeof(ais_flib_entry), pos) &&
+                  write_all(out, by_mmsi.data(), by_mmsi.size() * sizeof(uint32_t), pos) &&
+                  write_all(out, data.data(), data.size(), pos);
+        ok = (std::fclose(out) == 0) && ok;
+        if (!ok || std::rename(tmp.c_str(), out_name) < 0)
+        {
+            std::fprintf(stderr, "%s: %s\n", out_name, std::strerror(errno));
+            std::remove(tmp.c_str());
+            return 1;
+        }
+        std::printf("%zu frames, %zu data bytes\n", entries.size(), data.size());
+        return 0;
+    }
+
+    int open_library(ais_flib &lib, const char *name)
+    {
+        const int rc = ais_flib_open(&lib, name);
+        if (rc < 0)
+        {
+            std::fprintf(stderr, "%s: %s\n", name, std::strerror(-rc));
+        }
+        return rc;
+    }
+
+    int info(const char *name)
+    {
+        ais_flib lib;
+        if (open_library(lib, name) < 0)
+        {
+            return 1;
+        }
+        const uint64_t count = lib.header->count;
+        uint64_t stations = 0;
+        for (uint64_t i = 0; i < count; i++)
+        {
+            stations += i == 0 || lib.entries[lib.by_mmsi[i]].mmsi != lib.entries[lib.by_mmsi[i - 1]].mmsi;
+        }
+        std::printf("frames:     %llu\n", (unsigned long long)count);
+        std::printf("stations:   %llu\n", (unsigned long long)stations);
+        std::printf("nrzi:       %s\n", lib.header->flags & AIS_FLIB_NRZI ? "yes" : "no");
+        std::printf("data bytes: %llu\n", (unsigned long long)lib.header->data_size);
+        if (count)
+        {
+            std::printf("time:       %.3f to %.3f s\n", lib.entries[0].time, lib.entries[count - 1].time);
+        }
+        ais_flib_close(&lib);
+        return 0;
+    }
+
+    void print_entry(const ais_flib &lib, const ais_flib_entry &e)
+    {
+        std::printf("%.3f %09u %2u %3u ", e.time, e.mmsi, e.type, e.len);
+        const uint8_t *frame = ais_flib_frame(&lib, &e);
+        for (int i = 0; frame && i < e.len; i++)
+        {
+            std::printf("%02x", frame[i]);
+        }
+        std::printf("\n");
+    }
+
+    int dump(const char *name, long mmsi, int type, double from)
+    {
+        ais_flib lib;
+        if (open_library(lib, name) < 0)
+        {
+            return 1;
+        }
+        if (mmsi >= 0)
+        {
+            uint64_t first;
+            const uint64_t n = ais_flib_find(&lib, (uint32_t)mmsi, type, &first);
+            for (uint64_t i = first; i < first + n; i++)
+            {
+                const ais_flib_entry &e = lib.entries[lib.by_mmsi[i]];
+                if (e.time >= from)
+                {
+                    print_entry(lib, e);
+                }
+            }
+        }
+        else
+        {
+            for (uint64_t i = ais_flib_seek(&lib, from); i < lib.header->count; i++)
+            {
+                if (type < 0 || lib.entries[i].type == type)
+                {
+                    print_entry(lib, lib.entries[i]);
+                }
+            }
+        }
+        ais_flib_close(&lib);
+        return 0;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        return usage(argv[0]);
+    }
+    const std::string cmd = argv[1];
+    bool nrzi = true;
+    long mmsi = -1;
+    int type = -1;
+    double from = -1e300;
+    int i = 2;
+    for (; i < argc && argv[i][0] == '-' && argv[i][1] == '-'; i++)
+    {
+        const std::string opt = argv[i];
+        if (cmd == "build" && opt == "--no-nrzi")
+        {
+            nrzi = false;
+        }
+        else if (cmd == "dump" && i + 1 < argc && opt == "--mmsi")
+        {
+            mmsi = std::strtol(argv[++i], nullptr, 10);
+        }
+        else if (cmd == "dump" && i + 1 < argc && opt == "--type")
+        {
+            type = (int)std::strtol(argv[++i], nullptr, 10);
+        }
+        else if (cmd == "dump" && i + 1 < argc && opt == "--from")
+        {
+            from = std::strtod(argv[++i], nullptr);
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    const int args = argc - i;
+    if (cmd == "build" && (args == 1 || args == 2))
+    {
+        return build(argv[i], args == 2 ? argv[i + 1] : nullptr, nrzi);
+    }
+    if (cmd == "info" && args == 1)
+    {
+        return info(argv[i]);
+    }
+    if (cmd == "dump" && args == 1)
+    {
+        return dump(argv[i], mmsi, type, from);
+    }
+    return usage(argv[0]);
+}
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+#
+# Copyright 2020 Michael Wolf, Mictronics.
+#
+# SPDX-License-Identifier: GPL-3.0-or-later
+#
+# Closed loop test of the transmit chain. Random payloads run headless through
+# Bitstring to Frame, GMSK Mod and optional noise into Frame Decoder, the
+# decoded payloads are compared with the sent ones.
+#
+# Usage: ais_loopback.py [--frames N] [--bits N] [--samp-rate SR] [--snr DB]
+#                        [--format packed|unpacked|nrz]
+#
+# Exits non zero when frames are lost without noise.
+
+import argparse
+import random
+import sys
+import time
+
+import numpy
+import pmt
+from gnuradio import analog, blocks, digital, filter, gr
+from gnuradio import ais_simulator
+
+FORMATS = {
+    'packed': ais_simulator.FRAME_PACKED,
+    'unpacked': ais_simulator.FRAME_UNPACKED,
+    'nrz': ais_simulator.FRAME_NRZ,
+}
+
+
+class gmsk_nrz_mod(gr.hier_block2):
+    """GMSK Mod without its symbol mapping, for NRZ float input."""
+
+    def __init__(self, sps, bt):
+        gr.hier_block2.__init__(self, 'gmsk_nrz_mod',
+                                gr.io_signature(1, 1, gr.sizeof_float),
+                                gr.io_signature(1, 1, gr.sizeof_gr_complex))
+        # Same pulse and modulation index as digital.gmsk_mod.
+        taps = numpy.convolve(filter.firdes.gaussian(1, sps, bt, 4 * sps), numpy.ones(sps))
+        self.shaping = filter.interp_fir_filter_fff(sps, taps)
+        self.fmod = analog.frequency_modulator_fc((numpy.pi / 2) / sps)
+        self.connect(self, self.shaping, self.fmod, self)
+
+
+class loopback(gr.top_block):
+
+    def __init__(self, payloads, samp_rate, baud_rate, snr, seed, fmt):
+        gr.top_block.__init__(self, 'AIS Loopback')
+        sps = int(samp_rate / baud_rate)
+
+        data = []
+        tags = []
+        for p in payloads:
+            tag = gr.tag_t()
+            tag.offset = len(data)
+            tag.key = pmt.intern('packet_len')
+            tag.value = pmt.from_long(len(p))
+            tags.append(tag)
+            data.extend(p.encode())
+
+        source = blocks.vector_source_b(data, False, 1, tags)
+        build_frame = ais_simulator.bitstring_to_frame(True, 'packet_len', 0, FORMATS[fmt])
+        if fmt == 'nrz':
+            gmsk_mod = gmsk_nrz_mod(sps, 0.4)
+        else:
+            gmsk_mod = digital.gmsk_mod(samples_per_symbol=sps, bt=0.4, verbose=False, log=False,
+                                        do_unpack=(fmt == 'packed'))
+        self.decoder = ais_simulator.frame_decoder(samp_rate, samp_rate / sps)
+        self.debug = blocks.message_debug()
+
+        self.connect(source, build_frame, gmsk_mod)
+        if snr is None:
+            self.connect(gmsk_mod, self.decoder)
+        else:
+            noise = analog.noise_source_c(analog.GR_GAUSSIAN, 10 ** (-snr / 20.0), seed)
+            add = blocks.add_cc()
+            self.connect(gmsk_mod, (add, 0))
+            self.connect(noise, (add, 1))
+            self.connect(add, self.decoder)
+        self.msg_connect((self.decoder, 'out'), (self.debug, 'store'))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='AIS transmit chain loopback test.')
+    parser.add_argument('--frames', type=int, default=1000, help='number of frames')
+    parser.add_argument('--bits', type=int, default=168, help='payload bits per frame')
+    parser.add_argument('--samp-rate', type=float, default=8e6, help='sample rate')
+    parser.add_argument('--baud-rate', type=float, default=9600, help='symbol rate')
+    parser.add_argument('--snr', type=float, default=None,
+                        help='SNR in dB over the full sample rate, no noise by default')
+    parser.add_argument('--seed', type=int, default=1, help='random seed')
+    parser.add_argument('--format', choices=sorted(FORMATS), default='unpacked',
+                        help='Bitstring to Frame output format')
+    args = parser.parse_args()
+
+    # The decoder hands back payloads padded to full bytes.
+    bits = (args.bits + 7) // 8 * 8
+    rng = random.Random(args.seed)
+    payloads = [''.join(rng.choice('01') for _ in range(bits)) for _ in range(args.frames)]
+
+    tb = loopback(payloads, args.samp_rate, args.baud_rate, args.snr, args.seed, args.format)
+    start = time.monotonic()
+    tb.run()
+    elapsed = time.monotonic() - start
+
+    sent = set(payloads)
+    correct = 0
+    for i in range(tb.debug.num_messages()):
+        r = bytes(pmt.u8vector_elements(pmt.cdr(tb.debug.get_message(i)))).decode()
+        correct += r in sent
+
+    air_time = tb.decoder.nitems_read(0) / args.samp_rate
+    print('frames sent:     %d' % len(payloads))
+    print('frames decoded:  %d (%.2f %%)' % (correct, 100.0 * correct / len(payloads)))
+    print('crc errors:      %d' % tb.decoder.crc_errors())
+    print('wall time:       %.2f s for %.2f s on air, %.1fx real time' %
+          (elapsed, air_time, air_time / elapsed))
+
+    if args.snr is None and correct != len(payloads):
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,700 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+/*
+ * Coordinator for sharded operation over several simulator instances.
+ *
+ * Usage: ais_shard_coordinator [--listen ADDR:PORT] [--vnodes N] SHARD...
+ *
+ * Each SHARD, given as host:port, is a simulator instance with its own
+ * Websocket PDU -> Bit String to Frame chain and radio. The shard index is
+ * its position on the command line, MMSIs are partitioned by consistent
+ * hashing over the indexes (lib/shard_map.h). Keep the order and add new
+ * shards last, then only about 1/N of the MMSIs move.
+ *
+ * A client connects to the coordinator as to a single Websocket PDU block,
+ * one client at a time like the block itself. Each message is split by the
+ * owning shard of its lines:
+ *
+ *   bit strings         MMSI from bits 8 to 37
+ *   "@priority" batch   header repeated to every shard with lines
+ *   "@schedule" upload  by the bit string of each line, "@schedule clear"
+ *                       and status requests without lines go to all shards
+ *   "MMSI <mmsi>: ..."  vessel state deltas by their MMSI
+ *
+ * Lines without an MMSI go to shard 0. The replies of a scheduled upload are
+ * merged into one "scheduled:" status. Shards publishing VDL Stats on their
+ * "send" port report "stats:" lines, once every shard has reported these are
+ * merged into one "stats:shards=<n>,..." line, counts summed. Other replies
+ * are passed through.
+ *
+ * Reading from the client pauses while a shard is slow to take messages,
+ * so flow control of the shards reaches the client. The coordinator exits
+ * when a shard connection fails.
+ */
+
+#include "shard_map.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+#include <strings.h>
+#include <vector>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+
+namespace beast = boost::beast;
+namespace websocket = beast::websocket;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+using gr::ais_simulator::shard_map;
+
+namespace
+{
+    // Messages queued for one shard before client reads pause.
+    const size_t LINK_QUEUE_MAX = 64;
+
+    class coordinator;
+
+    /*
+     * Websocket connection to the client or a shard. Reads one message per
+     * read() call, writes are queued with one in flight.
+     */
+    class connection : public std::enable_shared_from_this<connection>
+    {
+    public:
+        // Shard index, -1 for the client.
+        const int d_shard;
+
+        connection(tcp::socket &&socket, coordinator &c, int shard)
+            : d_shard(shard), d_ws(std::move(socket)), d_coordinator(c)
+        {
+        }
+
+        websocket::stream<beast::tcp_stream> &ws() { return d_ws; }
+        size_t queued() const { return d_queue.size() + d_writing; }
+
+        void read()
+        {
+            d_ws.async_read(d_buffer,
+                            beast::bind_front_handler(&connection::on_read, shared_from_this()));
+        }
+
+        void write(std::string data, bool binary)
+        {
+            d_queue.push_back({ std::move(data), binary });
+            if (!d_writing)
+            {
+                write_front();
+            }
+        }
+
+        void close()
+        {
+            if (d_ws.is_open())
+            {
+                d_ws.async_close(websocket::close_code::normal, [self = shared_from_this()](beast::error_code) {});
+            }
+        }
+
+    private:
+        struct outgoing {
+            std::string data;
+            bool binary;
+        };
+
+        websocket::stream<beast::tcp_stream> d_ws;
+        coordinator &d_coordinator;
+        beast::flat_buffer d_buffer;
+        std::deque<outgoing> d_queue;
+        outgoing d_sending;
+        bool d_writing = false;
+
+        void on_read(beast::error_code ec, std::size_t bytes_transferred);
+        void on_write(beast::error_code ec, std::size_t bytes_transferred);
+
+        void write_front()
+        {
+            d_sending = std::move(d_queue.front());
+            d_queue.pop_front();
+            d_writing = true;
+            d_ws.binary(d_sending.binary);
+            d_ws.async_write(net::buffer(d_sending.data),
+                             beast::bind_front_handler(&connection::on_write, shared_from_this()));
+        }
+    };
+
+    /*
+     * Routes client messages to the shards and merges their replies. Runs
+     * on a single threaded io_context.
+     */
+    class coordinator
+    {
+    public:
+        coordinator(net::io_context &ioc, const shard_map &map)
+            : d_ioc(ioc),
+              d_acceptor(ioc),
+              d_map(map),
+              d_parts(map.shards()),
+              d_link_schedules(map.shards()),
+              d_stats(map.shards())
+        {
+        }
+
+        int status() const { return d_status; }
+
+        bool connect(const std::vector<std::string> &shards);
+        bool listen(const std::string &addr, const std::string &port);
+        void received(connection &c, const std::string &msg, bool binary);
+        void closed(connection &c, beast::error_code ec);
+        void written(connection &c);
+
+    private:
+        struct schedule_status {
+            int remaining = 0;
+            long accepted = 0;
+            long rejected = 0;
+            long pending = 0;
+            double horizon = 0;
+        };
+
+        net::io_context &d_ioc;
+        tcp::acceptor d_acceptor;
+        const shard_map &d_map;
+        std::vector<std::shared_ptr<connection>> d_links;
+        std::shared_ptr<connection> d_client;
+        bool d_client_paused = false;
+        int d_status = 0;
+        std::vector<std::string> d_parts;
+        // Scheduled uploads waiting for shard replies, in upload order.
+        std::deque<std::shared_ptr<schedule_status>> d_schedules;
+        std::vector<std::deque<std::shared_ptr<schedule_status>>> d_link_schedules;
+        // Latest stats line per shard since the last merge.
+        std::vector<std::string> d_stats;
+
+        void accept();
+        void on_accept(beast::error_code ec, tcp::socket socket);
+        void on_handshake(std::shared_ptr<connection> c, beast::error_code ec);
+        void route(const std::string &msg);
+        void shard_reply(int shard, const std::string &msg, bool binary);
+        void merge_schedule(int shard, const std::string &msg);
+        void merge_stats(int shard, const std::string &msg);
+        bool links_busy() const;
+
+        void reply(std::string msg, bool binary = false)
+        {
+            if (d_client)
+            {
+                d_client->write(std::move(msg), binary);
+            }
+        }
+    };
+
+    void connection::on_read(beast::error_code ec, std::size_t bytes_transferred)
+    {
+        boost::ignore_unused(bytes_transferred);
+        if (ec)
+        {
+            d_coordinator.closed(*this, ec);
+            return;
+        }
+        const std::string msg = beast::buffers_to_string(d_buffer.data());
+        d_buffer.consume(d_buffer.size());
+        d_coordinator.received(*this, msg, !d_ws.got_text());
+    }
+
+    void connection::on_write(beast::error_code ec, std::size_t bytes_transferred)
+    {
+        boost::ignore_unused(bytes_transferred);
+        d_writing = false;
+        if (ec)
+        {
+            d_coordinator.closed(*this, ec);
+            return;
+        }
+        if (!d_queue.empty())
+        {
+            write_front();
+        }
+        d_coordinator.written(*this);
+    }
+
+    /*
+     * Connect to all shards, blocking. Shards must be up before clients are
+     * accepted.
+     */
+    bool coordinator::connect(const std::vector<std::string> &shards)
+    {
+        tcp::resolver resolver(d_ioc);
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            const size_t colon = shards[i].rfind(':');
+            const std::string host = shards[i].substr(0, colon);
+            const std::string port = colon == std::string::npos ? "52002" : shards[i].substr(colon + 1);
+            auto link = std::make_shared<connection>(tcp::socket(d_ioc), *this, (int)i);
+            try
+            {
+                beast::get_lowest_layer(link->ws()).connect(resolver.resolve(host, port));
+                link->ws().handshake(host + ":" + port, "/");
+            }
+            catch (const beast::system_error &e)
+            {
+                std::fprintf(stderr, "shard %zu %s: %s\n", i, shards[i].c_str(), e.code().message().c_str());
+                return false;
+            }
+            beast::get_lowest_layer(link->ws()).expires_never();
+            link->ws().set_option(websocket::stream_base::timeout::suggested(beast::role_type::client));
+            d_links.push_back(link);
+            link->read();
+        }
+
+        // Share of the MMSI space per shard, from a sample.
+        std::vector<int> owned(shards.size());
+        const int SAMPLE = 100000;
+        for (int i = 0; i < SAMPLE; i++)
+        {
+            owned[d_map.owner(200000000 + i * 7919u)]++;
+        }
+        for (size_t i = 0; i < shards.size(); i++)
+        {
+            std::printf("shard %zu %s, %.1f %% of MMSIs\n", i, shards[i].c_str(), 100.0 * owned[i] / SAMPLE);
+        }
+        std::fflush(stdout);
+        return true;
+    }
+
+    bool coordinator::listen(const std::string &addr, const std::string &port)
+    {
+        beast::error_code ec;
+        const tcp::endpoint endpoint(net::ip::make_address(addr.empty() ? "0.0.0.0" : addr, ec),
+                                     (unsigned short)std::atoi(port.c_str()));
+        if (!ec)
+        {
+            d_acceptor.open(endpoint.protocol(), ec);
+        }
+        if (!ec)
+        {
+            d_acceptor.set_option(net::socket_base::reuse_address(true), ec);
+            d_acceptor.bind(endpoint, ec);
+        }
+        if (!ec)
+        {
+            d_acceptor.listen(net::socket_base::max_listen_connections, ec);
+        }
+        if (ec)
+        {
+            std::fprintf(stderr, "listen %s:%s: %s\n", addr.c_str(), port.c_str(), ec.message().c_str());
+            return false;
+        }
+        accept();
+        return true;
+    }
+
+    void coordinator::accept()
+    {
+        d_acceptor.async_accept(beast::bind_front_handler(&coordinator::on_accept, this));
+    }
+
+    void coordinator::on_accept(beast::error_code ec, tcp::socket socket)
+    {
+        if (ec)
+        {
+            std::fprintf(stderr, "accept: %s\n", ec.message().c_str());
+        }
+        else
+        {
+            auto c = std::make_shared<connection>(std::move(socket), *this, -1);
+            c->ws().set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+            c->ws().async_accept(beast::bind_front_handler(&coordinator::on_handshake, this, c));
+        }
+        accept();
+    }
+
+    /*
+     * A new client replaces the current one, like Websocket PDU does.
+     */
+    void coordinator::on_handshake(std::shared_ptr<connection> c, beast::error_code ec)
+    {
+        if (ec)
+        {
+            std::fprintf(stderr, "accept: %s\n", ec.message().c_str());
+            return;
+        }
+        if (d_client)
+        {
+            d_client->close();
+        }
+        d_client = c;
+        d_client_paused = links_busy();
+        if (!d_client_paused)
+        {
+            c->read();
+        }
+    }
+
+    void coordinator::received(connection &c, const std::string &msg, bool binary)
+    {
+        if (c.d_shard >= 0)
+        {
+            shard_reply(c.d_shard, msg, binary);
+            c.read();
+            return;
+        }
+        if (&c != d_client.get())
+        {
+            return;
+        }
+        route(msg);
+        // Hold further client messages while a shard lags behind.
+        d_client_paused = links_busy();
+        if (!d_client_paused)
+        {
+            c.read();
+        }
+    }
+
+    void coordinator::closed(connection &c, beast::error_code ec)
+    {
+        if (c.d_shard >= 0)
+        {
+            std::fprintf(stderr, "shard %d: %s\n", c.d_shard, ec.message().c_str());
+            d_status = 1;
+            d_ioc.stop();
+            return;
+        }
+        if (&c == d_client.get())
+        {
+            d_client.reset();
+            d_client_paused = false;
+        }
+    }
+
+    void coordinator::written(connection &c)
+    {
+        if (c.d_shard >= 0 && d_client_paused && !links_busy())
+        {
+            d_client_paused = false;
+            d_client->read();
+        }
+    }
+
+    bool coordinator::links_busy() const
+    {
+        return std::any_of(d_links.begin(), d_links.end(), [](const std::shared_ptr<connection> &l) {
+            return l->queued() > LINK_QUEUE_MAX;
+        });
+    }
+
+    /*
+     * Split a client message by owning shard and send each shard its part.
+     */
+    void coordinator::route(const std::string &msg)
+    {
+        const char *p = msg.data();
+        const char *end = p + msg.size();
+        const bool schedule = msg.compare(0, 9, "@schedule") == 0;
+        const bool delta = !schedule && msg.size() > 5 && strncasecmp(p, "MMSI ", 5) == 0;
+        std::string header;
+        if (schedule || msg.compare(0, 10, "@priority ") == 0)
+        {
+            const char *eol = std::find(p, end, '\n');
+            header.assign(p, eol);
+            p = eol < end ? eol + 1 : end;
+        }
+
+        bool invalid = false;
+        while (p < end)
+        {
+            const char *line = p;
+            const char *last = std::find(p, end, '\n');
+            p = last < end ? last + 1 : end;
+            while (last > line && (last[-1] == '\r' || last[-1] == ' '))
+            {
+                last--;
+            }
+            while (line < last && (*line == ' ' || *line == '\t'))
+            {
+                line++;
+            }
+            if (line == last)
+            {
+                continue;
+            }
+
+            uint32_t mmsi;
+            int shard = 0;
+            if (delta)
+            {
+                if (!gr::ais_simulator::delta_mmsi(line, last - line, mmsi))
+                {
+                    invalid = true;
+                    continue;
+                }
+                shard = d_map.owner(mmsi);
+            }
+            else
+            {
+                // Scheduled lines are "<time> <repeat> <bit string>".
+                const char *bits = line;
+                for (int field = 0; schedule && field < 2; field++)
+                {
+                    bits = std::find(bits, last, ' ');
+                    bits = std::find_if(bits, last, [](char ch) { return ch != ' '; });
+                }
+                if (gr::ais_simulator::sentence_mmsi(bits, last - bits, mmsi))
+                {
+                    shard = d_map.owner(mmsi);
+                }
+            }
+
+            std::string &part = d_parts[shard];
+            if (part.empty() && !header.empty())
+            {
+                part = header;
+            }
+            if (!part.empty())
+            {
+                part += '\n';
+            }
+            part.append(line, last);
+        }
+
+        const bool all = schedule && (header.find("clear") != std::string::npos ||
+                                      std::all_of(d_parts.begin(), d_parts.end(),
+                                                  [](const std::string &s) { return s.empty(); }));
+        auto status = schedule ? std::make_shared<schedule_status>() : nullptr;
+        for (int s = 0; s < d_map.shards(); s++)
+        {
+            std::string &part = d_parts[s];
+            if (part.empty())
+            {
+                if (!all)
+                {
+                    continue;
+                }
+                part = header;
+            }
+            if (status)
+            {
+                status->remaining++;
+                d_link_schedules[s].push_back(status);
+            }
+            d_links[s]->write(std::move(part), false);
+            part.clear();
+        }
+        if (status)
+        {
+            d_schedules.push_back(status);
+        }
+        if (invalid)
+        {
+            reply("vessel:error=invalid MMSI");
+        }
+    }
+
+    void coordinator::shard_reply(int shard, const std::string &msg, bool binary)
+    {
+        if (!binary && msg.compare(0, 10, "scheduled:") == 0 && !d_link_schedules[shard].empty())
+        {
+            merge_schedule(shard, msg);
+        }
+        else if (!binary && msg.compare(0, 6, "stats:") == 0)
+        {
+            merge_stats(shard, msg);
+        }
+        else
+        {
+            reply(msg, binary);
+        }
+    }
+
+    /*
+     * Add a shard's status to its upload, reply for uploads complete in
+     * upload order.
+     */
+    void coordinator::merge_schedule(int shard, const std::string &msg)
+    {
+        schedule_status &s = *d_link_schedules[shard].front();
+        d_link_schedules[shard].pop_front();
+        long accepted = 0;
+        long rejected = 0;
+        long pending = 0;
+        double horizon = 0;
+        std::sscanf(msg.c_str(), "scheduled:accepted=%ld,rejected=%ld,pending=%ld,horizon=%lf",
+                    &accepted, &rejected, &pending, &horizon);
+        s.accepted += accepted;
+        s.rejected += rejected;
+        s.pending += pending;
+        s.horizon = std::max(s.horizon, horizon);
+        s.remaining--;
+
+        while (!d_schedules.empty() && d_schedules.front()->remaining == 0)
+        {
+            const schedule_status &done = *d_schedules.front();
+            char status[128];
+            std::snprintf(status, sizeof(status), "scheduled:accepted=%ld,rejected=%ld,pending=%ld,horizon=%.3f",
+                          done.accepted, done.rejected, done.pending, done.horizon);
+            reply(status);
+            d_schedules.pop_front();
+        }
+    }
+
+    /*
+     * Keep the latest stats of each shard, once all have reported merge them:
+     * time and window take the maximum, other numbers and the histogram are
+     * summed, text values are taken from shard 0.
+     */
+    void coordinator::merge_stats(int shard, const std::string &msg)
+    {
+        d_stats[shard] = msg;
+        if (std::any_of(d_stats.begin(), d_stats.end(), [](const std::string &s) { return s.empty(); }))
+        {
+            return;
+        }
+
+        auto fields = [](const std::string &s) {
+            std::vector<std::pair<std::string, std::string>> kv;
+            size_t p = 6;
+            while (p < s.size())
+            {
+                size_t comma = s.find(',', p);
+                comma = comma == std::string::npos ? s.size() : comma;
+                const size_t eq = s.find('=', p);
+                if (eq < comma)
+                {
+                    kv.emplace_back(s.substr(p, eq - p), s.substr(eq + 1, comma - eq - 1));
+                }
+                p = comma + 1;
+            }
+            return kv;
+        };
+        auto merged = fields(d_stats[0]);
+        for (size_t i = 1; i < d_stats.size(); i++)
+        {
+            for (const auto &f : fields(d_stats[i]))
+            {
+                auto it = std::find_if(merged.begin(), merged.end(), [&f](const auto &m) { return m.first == f.first; });
+                if (it == merged.end())
+                {
+                    merged.push_back(f);
+                    continue;
+                }
+                std::string &value = it->second;
+                char *q;
+                if (f.first == "histogram")
+                {
+                    std::string sum;
+                    const char *a = value.c_str();
+                    const char *b = f.second.c_str();
+                    while (*a || *b)
+                    {
+                        char *qb;
+                        const unsigned long long n = std::strtoull(a, &q, 10) + std::strtoull(b, &qb, 10);
+                        a = *q == '/' ? q + 1 : q;
+                        b = *qb == '/' ? qb + 1 : qb;
+                        sum += (sum.empty() ? "" : "/") + std::to_string(n);
+                    }
+                    value = sum;
+                    continue;
+                }
+                const double x = std::strtod(value.c_str(), &q);
+                if (*q != '\0' || value.empty())
+                {
+                    continue;
+                }
+                const double y = std::strtod(f.second.c_str(), &q);
+                if (*q != '\0' || f.second.empty())
+                {
+                    continue;
+                }
+                char number[32];
+                std::snprintf(number, sizeof(number), "%.15g",
+                              f.first == "time" || f.first == "window" ? std::max(x, y) : x + y);
+                value = number;
+            }
+        }
+
+        std::string out = "stats:shards=" + std::to_string(d_stats.size());
+        for (const auto &f : merged)
+        {
+            out += "," + f.first + "=" + f.second;
+        }
+        reply(out);
+        for (auto &s : d_stats)
+        {
+            s.clear();
+        }
+    }
+
+    int usage(const char *name)
+    {
+        std::fprintf(stderr, "usage: %s [--listen ADDR:PORT] [--vnodes N] SHARD...\n", name);
+        return 2;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string listen = "127.0.0.1:52000";
+    int vnodes = 64;
+    std::vector<std::string> shards;
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--listen") == 0 && i + 1 < argc)
+        {
+            listen = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--vnodes") == 0 && i + 1 < argc)
+        {
+            vnodes = std::atoi(argv[++i]);
+        }
+        else if (argv[i][0] == '-')
+        {
+            return usage(argv[0]);
+        }
+        else
+        {
+            shards.push_back(argv[i]);
+        }
+    }
+    const size_t colon = listen.rfind(':');
+    if (shards.empty() || vnodes < 1 || colon == std::string::npos)
+    {
+        return usage(argv[0]);
+    }
+
+    const shard_map map((int)shards.size(), vnodes);
+    net::io_context ioc{ 1 };
+    coordinator c(ioc, map);
+    if (!c.connect(shards) || !c.listen(listen.substr(0, colon), listen.substr(colon + 1)))
+    {
+        return 1;
+    }
+    ioc.run();
+    return c.status();
+}
@@ -0,0 +1,166 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Heap allocations per message of the websocket_pdu block, by thread.
+ *
+ * A flow graph connects the block's "out" port to its "send" port, so every
+ * sentence from a client comes back as a binary frame. A synchronous client
+ * sends batches of sentences and reads the echoes. Allocations are counted
+ * by a replaced global operator new, per thread, after a warm up.
+ *
+ * Usage: ais_ws_alloc_benchmark [messages] [batch] [port]
+ */
+
+#include <pthread.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/websocket.hpp>
+#include <gnuradio/ais_simulator/websocket_pdu.h>
+#include <gnuradio/top_block.h>
+
+namespace beast = boost::beast;
+namespace net = boost::asio;
+using tcp = net::ip::tcp;
+
+namespace
+{
+    // Fixed table, registering a thread must not allocate itself.
+    const int MAX_THREADS = 256;
+    struct thread_count {
+        pthread_t thread;
+        std::atomic<long> count{ 0 };
+    };
+    thread_count g_threads[MAX_THREADS];
+    std::atomic<int> g_nthreads{ 0 };
+    std::atomic<bool> g_counting{ false };
+    thread_local thread_count *t_count = nullptr;
+
+    void count_alloc()
+    {
+        if (!g_counting.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        if (t_count == nullptr)
+        {
+            const int i = g_nthreads.fetch_add(1);
+            if (i >= MAX_THREADS)
+            {
+                return;
+            }
+            g_threads[i].thread = pthread_self();
+            t_count = &g_threads[i];
+        }
+        t_count->count.fetch_add(1, std::memory_order_relaxed);
+    }
+} // namespace
+
+void *operator new(std::size_t n)
+{
+    count_alloc();
+    if (void *p = std::malloc(n ? n : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char **argv)
+{
+    const long messages = argc > 1 ? std::atol(argv[1]) : 200000;
+    const int batch = argc > 2 ? std::atoi(argv[2]) : 64;
+    const std::string port = argc > 3 ? argv[3] : "52101";
+    if (messages <= 0 || batch <= 0)
+    {
+        std::fprintf(stderr, "usage: %s [messages] [batch] [port]\n", argv[0]);
+        return 1;
+    }
+
+    auto ws = gr::ais_simulator::websocket_pdu::make("127.0.0.1", port);
+    auto tb = gr::make_top_block("ws_alloc_benchmark");
+    tb->msg_connect(ws, "out", ws, "send");
+    tb->start();
+
+    net::io_context ioc;
+    tcp::resolver resolver(ioc);
+    beast::websocket::stream<tcp::socket> client(ioc);
+    net::connect(client.next_layer(), resolver.resolve("127.0.0.1", port));
+    client.handshake("127.0.0.1:" + port, "/");
+
+    std::string sentences;
+    for (int i = 0; i < batch; i++)
+    {
+        sentences += "!AIVDM,1,1,,A,15M67FC000G?ufbE`FepT@3n00Sa,0*5C\n";
+    }
+    beast::flat_buffer buffer;
+    auto round = [&]() {
+        client.write(net::buffer(sentences));
+        for (int i = 0; i < batch; i++)
+        {
+            client.read(buffer);
+            buffer.consume(buffer.size());
+        }
+    };
+
+    // Warm up, grows the recycled buffers and queues to their working size.
+    for (int i = 0; i < 1000; i++)
+    {
+        round();
+    }
+    const long rounds = (messages + batch - 1) / batch;
+    const auto t0 = std::chrono::steady_clock::now();
+    g_counting = true;
+    for (long i = 0; i < rounds; i++)
+    {
+        round();
+    }
+    g_counting = false;
+    const double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const double n = (double)rounds * batch;
+    std::printf("%.0f messages in batches of %d, %.0f messages/s\n", n, batch, n / t);
+    std::printf("%-16s %12s %10s\n", "thread", "allocations", "per msg");
+    const int threads = std::min(g_nthreads.load(), MAX_THREADS);
+    for (int i = 0; i < threads; i++)
+    {
+        char name[16] = "?";
+        pthread_getname_np(g_threads[i].thread, name, sizeof(name));
+        const long count = g_threads[i].count.load();
+        std::printf("%-16s %12ld %10.2f\n", name, count, count / n);
+    }
+
+    client.close(beast::websocket::close_code::normal);
+    tb->stop();
+    tb->wait();
+    return 0;
+}
@@ -22,11 +22,22 @@
 #define INCLUDED_AIS_SIMULATOR_BITSTRING_TO_FRAME_H
 
 #include <gnuradio/ais_simulator/api.h>
+#include <gnuradio/ais_simulator/framing.h>
 #include <gnuradio/tagged_stream_block.h>
 
 namespace gr {
   namespace ais_simulator {
 
+    /*!
+     * \brief Output item format of bitstring_to_frame.
+     * \ingroup ais_simulator
+     */
+    enum frame_format {
+      FRAME_PACKED = 0, //!< Bytes, 8 bits MSB first, for GMSK Mod with unpacking
+      FRAME_UNPACKED,   //!< One 0/1 byte per bit, for GMSK Mod without unpacking
+      FRAME_NRZ,        //!< One +/-1.0 float per bit, for a pulse shaping filter
+    };
+
     /*!
      * \brief <+description of block+>
      * \ingroup ais_simulator
@@ -44,8 +55,27 @@ namespace gr {
        * constructor is in a private implementation
        * class. ais_simulator::bitstring_to_frame::make is the public interface for
        * creating new instances.
+       *
+       * \param enable_nrzi Switch NRZI encoding on or off.
+       * \param len_tag_key Name of the tagged stream length tag.
+       * \param threads Number of frame building worker threads. Zero builds
+       *        frames inline in the block thread.
+       * \param format Output item format, length tags count output items.
+       * \param priority Take all packets waiting in the input into one lane
+       *        per priority class and build urgent frames first. The class
+       *        comes from a "priority" tag ("urgent", "normal" or "bulk", as
+       *        set by websocket_pdu) or the message type, 12 and 14 are
+       *        urgent. Credit is sent when a frame is built. Frames are built
+       *        inline, threads must be zero.
+       * \param starvation_limit Normal or bulk packets passed over this many
+       *        times in a row get the next turn. Zero for strict priority.
        */
-      static sptr make(bool enable_nrzi, const std::string &len_tag_key);
+      static sptr make(bool enable_nrzi,
+                       const std::string &len_tag_key,
+                       int threads = 0,
+                       frame_format format = FRAME_PACKED,
+                       bool priority = false,
+                       int starvation_limit = 8);
     };
 
   } // namespace ais_simulator
@@ -0,0 +1,77 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_BURST_IMPAIRMENT_H
+#define INCLUDED_AIS_SIMULATOR_BURST_IMPAIRMENT_H
+
+#include <gnuradio/ais_simulator/api.h>
+#include <gnuradio/block.h>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*!
+         * \brief Apply per vessel propagation effects to modulated bursts.
+         * \ingroup ais_simulator
+         *
+         * Bursts arrive as PDUs of complex samples on the "in" port and leave
+         * on the "out" port. PDU meta data describes the path of each burst:
+         * "range" in meters, "velocity" in m/s (positive approaching) and
+         * "multipath", complex FIR taps relative to the direct path. Each
+         * burst gets multipath, path loss, Doppler shift and AWGN applied.
+         * Path loss is relative to the reference range, where the SNR is
+         * ref_snr_db. The applied loss is added to the meta data as
+         * "path_loss_db".
+         */
+        class AIS_SIMULATOR_API burst_impairment : virtual public gr::block
+        {
+        public:
+            typedef std::shared_ptr<burst_impairment> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of ais_simulator::burst_impairment.
+             *
+             * \param samp_rate Sample rate.
+             * \param carrier_freq Carrier frequency for Doppler shift and
+             *        path loss.
+             * \param ref_range Range in meters of zero path loss.
+             * \param ref_snr_db SNR at the reference range, infinite for no noise.
+             * \param two_ray Use the two-ray ground reflection model beyond its
+             *        crossover distance instead of free space only.
+             * \param tx_height Transmit antenna height in meters, for two-ray.
+             * \param rx_height Receive antenna height in meters, for two-ray.
+             * \param seed Seed of the noise generator.
+             */
+            static sptr make(double samp_rate,
+                             double carrier_freq = 162e6,
+                             double ref_range = 1000,
+                             double ref_snr_db = 30,
+                             bool two_ray = false,
+                             double tx_height = 10,
+                             double rx_height = 10,
+                             int seed = 0);
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_BURST_IMPAIRMENT_H */
@@ -0,0 +1,75 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_BURST_MIXER_H
+#define INCLUDED_AIS_SIMULATOR_BURST_MIXER_H
+
+#include <gnuradio/ais_simulator/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*!
+         * \brief Sum concurrent modulated bursts into one sample stream.
+         * \ingroup ais_simulator
+         *
+         * Bursts arrive as PDUs of complex samples on the "bursts" port. Each
+         * burst gets its own power, frequency offset and start delay, drawn at
+         * random from the given ranges unless the PDU meta data holds
+         * "power_db", "freq_offset" (Hz) or "delay" (samples). Overlapping
+         * bursts add up, so collisions with realistic level and carrier
+         * differences appear on the output. Without bursts the output is zero.
+         */
+        class AIS_SIMULATOR_API burst_mixer : virtual public gr::sync_block
+        {
+        public:
+            typedef std::shared_ptr<burst_mixer> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of ais_simulator::burst_mixer.
+             *
+             * \param samp_rate Sample rate, for frequency offsets in Hz.
+             * \param power_min_db Lowest random burst power in dB.
+             * \param power_max_db Highest random burst power in dB.
+             * \param freq_offset_max Largest random frequency offset in Hz,
+             *        either sign.
+             * \param delay_max Largest random start delay in samples.
+             * \param max_active Bursts kept at once, further bursts are dropped.
+             * \param seed Seed of the random generator.
+             */
+            static sptr make(double samp_rate,
+                             float power_min_db = 0,
+                             float power_max_db = 0,
+                             double freq_offset_max = 0,
+                             int delay_max = 0,
+                             int max_active = 64,
+                             int seed = 0);
+
+            //! Bursts dropped because max_active bursts were pending.
+            virtual uint64_t dropped() const = 0;
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_BURST_MIXER_H */
@@ -0,0 +1,84 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_BURST_MODULATOR_H
+#define INCLUDED_AIS_SIMULATOR_BURST_MODULATOR_H
+
+#include <gnuradio/ais_simulator/api.h>
+#include <gnuradio/ais_simulator/bitstring_to_frame.h>
+#include <gnuradio/block.h>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*!
+         * \brief GMSK modulate frames into bursts, with a cache of finished bursts.
+         * \ingroup ais_simulator
+         *
+         * Takes frames from bitstring_to_frame as tagged stream and outputs
+         * one burst of complex baseband samples per frame, starting with a
+         * length tag counting samples. Pulse shape and modulation index are
+         * those of GMSK Mod, but each burst is modulated on its own: the
+         * Gaussian filter starts from zero state, the burst includes the
+         * filter ramp up and down and the phase starts at zero. Tags at the
+         * frame start are moved to the burst start.
+         *
+         * Finished bursts are kept in an LRU cache keyed by the frame bits,
+         * with samples per symbol and BT fixed per block. A repeated frame
+         * costs a copy of its cached burst instead of filtering and
+         * integrating again.
+         */
+        class AIS_SIMULATOR_API burst_modulator : virtual public gr::block
+        {
+        public:
+            typedef std::shared_ptr<burst_modulator> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of ais_simulator::burst_modulator.
+             *
+             * \param samples_per_symbol Samples per bit, sample rate divided
+             *        by the baud rate.
+             * \param bt Bandwidth time product of the Gaussian filter.
+             * \param format Input format, FRAME_PACKED or FRAME_UNPACKED.
+             * \param cache_mb Memory budget of the burst cache in MB, zero
+             *        disables caching.
+             * \param len_tag_key Name of the tagged stream length tag.
+             */
+            static sptr make(int samples_per_symbol,
+                             double bt = 0.4,
+                             frame_format format = FRAME_PACKED,
+                             int cache_mb = 64,
+                             const std::string &len_tag_key = "packet_len");
+
+            //! Frames taken from the cache.
+            virtual uint64_t hits() const = 0;
+            //! Frames modulated.
+            virtual uint64_t misses() const = 0;
+            //! Bytes held by the cache.
+            virtual uint64_t cached_bytes() const = 0;
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_BURST_MODULATOR_H */
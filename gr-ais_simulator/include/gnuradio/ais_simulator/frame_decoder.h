@@ -0,0 +1,64 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_FRAME_DECODER_H
+#define INCLUDED_AIS_SIMULATOR_FRAME_DECODER_H
+
+#include <gnuradio/ais_simulator/api.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*!
+         * \brief AIS receiver for loopback verification of generated frames.
+         * \ingroup ais_simulator
+         *
+         * Demodulates GMSK at complex baseband, decodes NRZI, searches the
+         * HDLC start mark, removes stuffing bits and checks the CRC. Each
+         * valid frame is published on the "out" port as PDU of its payload as
+         * ASCII bit string, the same format websocket_pdu puts out. Meta data
+         * "offset" is the input sample at the end of the frame.
+         */
+        class AIS_SIMULATOR_API frame_decoder : virtual public gr::sync_block
+        {
+        public:
+            typedef std::shared_ptr<frame_decoder> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of ais_simulator::frame_decoder.
+             *
+             * \param samp_rate Input sample rate.
+             * \param baud_rate Symbol rate.
+             */
+            static sptr make(double samp_rate, double baud_rate = 9600);
+
+            //! Frames with valid CRC.
+            virtual uint64_t frames() const = 0;
+            //! Frames failing the CRC check.
+            virtual uint64_t crc_errors() const = 0;
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_FRAME_DECODER_H */
@@ -0,0 +1,203 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_FRAME_LIBRARY_H
+#define INCLUDED_AIS_SIMULATOR_FRAME_LIBRARY_H
+
+/*
+ * Prebuilt frame library, header only C API for reading the files written
+ * by ais_frame_library and streamed by the frame_library_source block.
+ *
+ * Layout, all offsets from the start of the file and 8 byte aligned:
+ *
+ *   header    struct ais_flib_header
+ *   entries   struct ais_flib_entry[count], by scheduled time
+ *   by_mmsi   uint32_t[count], entry numbers by MMSI, type and time
+ *   data      packed frames in entry order
+ *
+ * Frames are stored as bitstring_to_frame builds them, packed MSB first.
+ * The file is mapped as it is, opening it reads nothing but the header.
+ * Host byte order.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AIS_FLIB_MAGIC 0x42494c46u /* "FLIB" */
+#define AIS_FLIB_VERSION 1u
+#define AIS_FLIB_NRZI 0x1u /* Frames are NRZI encoded */
+#define AIS_FLIB_ALIGN(n) (((n) + 7u) & ~(uint64_t)7u)
+
+struct ais_flib_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t entry_size; /* sizeof(struct ais_flib_entry) */
+    uint64_t count;      /* Frames */
+    uint64_t entries;
+    uint64_t by_mmsi;
+    uint64_t data;
+    uint64_t data_size;
+    uint64_t reserved;
+};
+
+struct ais_flib_entry {
+    double time;     /* Scheduled time in seconds from scenario start */
+    uint64_t offset; /* Frame offset in the data area */
+    uint32_t mmsi;
+    uint8_t type;    /* AIS message type */
+    uint8_t reserved;
+    uint16_t len;    /* Frame bytes */
+};
+
+typedef struct {
+    const struct ais_flib_header *header;
+    const struct ais_flib_entry *entries;
+    const uint32_t *by_mmsi;
+    const uint8_t *data;
+    size_t size;
+} ais_flib;
+
+/* Map a frame library read only. Returns 0 or -errno. */
+static inline int ais_flib_open(ais_flib *lib, const char *path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return -errno;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(struct ais_flib_header))
+    {
+        close(fd);
+        return -EINVAL;
+    }
+    void *m = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED)
+    {
+        return -errno;
+    }
+
+    const struct ais_flib_header *h = (const struct ais_flib_header *)m;
+    const uint64_t size = st.st_size;
+    if (h->magic != AIS_FLIB_MAGIC || h->version != AIS_FLIB_VERSION ||
+        h->entry_size != sizeof(struct ais_flib_entry) || h->count > UINT32_MAX ||
+        h->entries > size || h->count * sizeof(struct ais_flib_entry) > size - h->entries ||
+        h->by_mmsi > size || h->count * sizeof(uint32_t) > size - h->by_mmsi ||
+        h->data > size || h->data_size > size - h->data)
+    {
+        munmap(m, st.st_size);
+        return -EPROTO;
+    }
+    lib->header = h;
+    lib->entries = (const struct ais_flib_entry *)((const uint8_t *)m + h->entries);
+    lib->by_mmsi = (const uint32_t *)((const uint8_t *)m + h->by_mmsi);
+    lib->data = (const uint8_t *)m + h->data;
+    lib->size = st.st_size;
+    return 0;
+}
+
+static inline void ais_flib_close(ais_flib *lib)
+{
+    if (lib->header)
+    {
+        munmap((void *)lib->header, lib->size);
+        lib->header = NULL;
+    }
+}
+
+/* Frame of entry e, NULL when it points outside the data area. */
+static inline const uint8_t *ais_flib_frame(const ais_flib *lib, const struct ais_flib_entry *e)
+{
+    const uint64_t data_size = lib->header->data_size;
+    if (e->offset > data_size || e->len > data_size - e->offset)
+    {
+        return NULL;
+    }
+    return lib->data + e->offset;
+}
+
+/* First entry scheduled at or after time. */
+static inline uint64_t ais_flib_seek(const ais_flib *lib, double time)
+{
+    uint64_t lo = 0, hi = lib->header->count;
+    while (lo < hi)
+    {
+        const uint64_t mid = lo + (hi - lo) / 2;
+        if (lib->entries[mid].time < time)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/*
+ * Frames of one station, of message type only unless type is negative.
+ * Returns the number of frames, their entry numbers are by_mmsi[*first]
+ * onwards in time order.
+ */
+static inline uint64_t ais_flib_find(const ais_flib *lib, uint32_t mmsi, int type, uint64_t *first)
+{
+    const uint64_t key = ((uint64_t)mmsi << 8) | (uint64_t)(type < 0 ? 0 : type);
+    const uint64_t end_key = type < 0 ? key + 256 : key + 1;
+    uint64_t bounds[2];
+    for (int b = 0; b < 2; b++)
+    {
+        const uint64_t k = b ? end_key : key;
+        uint64_t lo = 0, hi = lib->header->count;
+        while (lo < hi)
+        {
+            const uint64_t mid = lo + (hi - lo) / 2;
+            const struct ais_flib_entry *e = &lib->entries[lib->by_mmsi[mid]];
+            if ((((uint64_t)e->mmsi << 8) | e->type) < k)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        bounds[b] = lo;
+    }
+    *first = bounds[0];
+    return bounds[1] - bounds[0];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDED_AIS_SIMULATOR_FRAME_LIBRARY_H */
@@ -0,0 +1,72 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_FRAME_LIBRARY_SOURCE_H
+#define INCLUDED_AIS_SIMULATOR_FRAME_LIBRARY_SOURCE_H
+
+#include <gnuradio/ais_simulator/api.h>
+#include <gnuradio/ais_simulator/bitstring_to_frame.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*!
+         * \brief Stream prebuilt frames from a frame library file.
+         * \ingroup ais_simulator
+         *
+         * Maps a library written by ais_frame_library and streams its
+         * frames in scheduled time order, without encoding at run time.
+         * Each frame starts with a length tag counting output items and a
+         * "time" tag with its scheduled time in seconds. Startup reads only
+         * the file header, frames are paged in with sequential read-ahead
+         * and dropped from the mapping behind the read position.
+         */
+        class AIS_SIMULATOR_API frame_library_source : virtual public gr::sync_block
+        {
+        public:
+            typedef std::shared_ptr<frame_library_source> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of ais_simulator::frame_library_source.
+             *
+             * \param filename Frame library file.
+             * \param len_tag_key Name of the tagged stream length tag.
+             * \param repeat Start over at the end of the library.
+             * \param format Output item format, as for bitstring_to_frame.
+             */
+            static sptr make(const std::string &filename,
+                             const std::string &len_tag_key = "packet_len",
+                             bool repeat = false,
+                             frame_format format = FRAME_PACKED);
+
+            //! Frames in the library.
+            virtual uint64_t frames() const = 0;
+            //! Frames streamed so far.
+            virtual uint64_t sent() const = 0;
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_FRAME_LIBRARY_SOURCE_H */
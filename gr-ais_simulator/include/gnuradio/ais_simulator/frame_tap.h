@@ -0,0 +1,86 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_FRAME_TAP_H
+#define INCLUDED_AIS_SIMULATOR_FRAME_TAP_H
+
+#include <gnuradio/ais_simulator/api.h>
+#include <gnuradio/ais_simulator/bitstring_to_frame.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*!
+         * \brief Monitoring tap on the frame builder output.
+         * \ingroup ais_simulator
+         *
+         * Passes the tagged stream of built frames through unchanged and
+         * publishes a copy of each frame on the "frames" port, to be sent
+         * to websocket clients as binary frame. The stream thread only copies
+         * the frame into a lock-free queue and drops it when the queue is
+         * full. A publisher thread recovers the payload and builds the
+         * equivalent !AIVDM sentences.
+         *
+         * PDU meta data holds "time" (UNIX seconds), "slot" (0-2249 within
+         * the UTC minute) and "aivdm". Time counts from the first frame at
+         * the given baud rate. Unpacked frames are packed for the record.
+         * The PDU data is a little endian record:
+         *
+         *   double   time
+         *   uint16_t slot
+         *   uint16_t frame length n in bytes
+         *   uint8_t  frame[n], packed MSB first as built
+         *   char     !AIVDM sentences, CR LF terminated, to the end
+         */
+        class AIS_SIMULATOR_API frame_tap : virtual public gr::sync_block
+        {
+        public:
+            typedef std::shared_ptr<frame_tap> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of ais_simulator::frame_tap.
+             *
+             * \param enable_nrzi Frames are NRZI encoded.
+             * \param len_tag_key Name of the tagged stream length tag.
+             * \param baud_rate Symbol rate for frame time and slot.
+             * \param channel AIS channel in the sentences, 'A' or 'B'.
+             * \param queue_size Frames queued for the publisher thread.
+             * \param format Input format, FRAME_PACKED or FRAME_UNPACKED.
+             */
+            static sptr make(bool enable_nrzi,
+                             const std::string &len_tag_key,
+                             double baud_rate = 9600,
+                             char channel = 'A',
+                             int queue_size = 1024,
+                             frame_format format = FRAME_PACKED);
+
+            //! Frames published.
+            virtual uint64_t frames() const = 0;
+            //! Frames dropped on a full queue.
+            virtual uint64_t dropped() const = 0;
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_FRAME_TAP_H */
@@ -0,0 +1,133 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_FRAMING_H
+#define INCLUDED_AIS_SIMULATOR_FRAMING_H
+
+/*
+ * AIS framing core, libais_framing. CRC, bit stuffing, NRZI and packing
+ * without GNU Radio or Boost, usable from C and C++. The GNU Radio blocks
+ * are built on top of it.
+ *
+ * Frames are packed MSB first: training sequence, start mark, stuffed
+ * payload and CRC, end mark. Functions return a length or -errno.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define AIS_FRAMING_API __attribute__((visibility("default")))
+#else
+#define AIS_FRAMING_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AIS_FRAMING_PAYLOAD_MAX 4048 /* Payload bits */
+
+/* Buffer size in bytes for one frame of a payload of len_bits. */
+AIS_FRAMING_API int ais_frame_bytes_max(int len_bits);
+
+/* CRC-16-ITU of the packed payload, sent LSB first after it. */
+AIS_FRAMING_API uint16_t ais_crc16(const uint8_t *data, int len);
+
+/*
+ * Encode an ASCII bit string ("0101...") into a frame. Input ends at the
+ * first new line or null character and is zero padded to whole bytes. Returns the frame
+ * length, 0 on empty input, -EMSGSIZE when longer than
+ * AIS_FRAMING_PAYLOAD_MAX or -ENOSPC when out_size is too small.
+ */
+AIS_FRAMING_API int ais_encode_bits(
+    const char *bits, long len_bits, int nrzi, uint8_t *out, size_t out_size);
+
+/* Same for a packed payload of len bytes. */
+AIS_FRAMING_API int ais_encode_payload(
+    const uint8_t *payload, int len, int nrzi, uint8_t *out, size_t out_size);
+
+/*
+ * Encode n payloads, see encode_frames() below. Returns 0, -EINVAL on bad
+ * lengths or a too small out_stride, -ENOMEM or -EAGAIN when out of memory
+ * or threads, -EIO on any other failure.
+ */
+AIS_FRAMING_API int ais_encode_batch(const uint8_t *bits,
+                                     long bits_stride,
+                                     const int32_t *lengths,
+                                     long n,
+                                     int nrzi,
+                                     uint8_t *out,
+                                     long out_stride,
+                                     int32_t *out_len,
+                                     int threads);
+
+/*
+ * Find the first frame with a valid CRC in len packed bytes and copy its
+ * payload. Returns the payload length in bytes, -ENOMSG when there is none
+ * or -ENOSPC when payload_size is too small.
+ */
+AIS_FRAMING_API int ais_decode_frame(
+    const uint8_t *frame, int len, int nrzi, uint8_t *payload, size_t payload_size);
+
+#ifdef __cplusplus
+}
+
+namespace gr
+{
+  namespace ais_simulator
+  {
+
+    /*!
+     * \brief Buffer size in bytes for one frame of a payload of len_bits.
+     * \ingroup ais_simulator
+     */
+    AIS_FRAMING_API int max_frame_bytes(int len_bits);
+
+    /*!
+     * \brief Encode a batch of payloads into frames without a flowgraph.
+     * \ingroup ais_simulator
+     *
+     * Builds the same frames as bitstring_to_frame. Payload i holds
+     * lengths[i] bits, one bit per byte (0/1 or '0'/'1'), starting at
+     * bits + i * bits_stride. Frame i is written packed MSB first to
+     * out + i * out_stride, its length in bytes to out_len[i]. out_stride
+     * must be at least max_frame_bytes() of the longest payload. Runs of
+     * equal length payloads use the bit-sliced batch encoder.
+     *
+     * \param threads Worker threads, zero for one per CPU.
+     * \throws std::invalid_argument on bad lengths or a too small out_stride.
+     */
+    AIS_FRAMING_API void encode_frames(const uint8_t *bits,
+                                       long bits_stride,
+                                       const int32_t *lengths,
+                                       long n,
+                                       bool enable_nrzi,
+                                       uint8_t *out,
+                                       long out_stride,
+                                       int32_t *out_len,
+                                       int threads = 0);
+
+  } // namespace ais_simulator
+} // namespace gr
+#endif
+
+#endif /* INCLUDED_AIS_SIMULATOR_FRAMING_H */
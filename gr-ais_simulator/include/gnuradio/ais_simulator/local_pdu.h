@@ -0,0 +1,62 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_LOCAL_PDU_H
+#define INCLUDED_AIS_SIMULATOR_LOCAL_PDU_H
+
+#include <gnuradio/ais_simulator/api.h>
+#include <gnuradio/block.h>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*!
+         * \brief Ingest sentences from producers on the same host.
+         * \ingroup ais_simulator
+         *
+         * Accepts sentences on a Unix domain socket (SOCK_SEQPACKET, one
+         * message per packet) and from a POSIX shared memory ring written
+         * through the C API in shm_ring.h. Published PDUs are identical to
+         * the out port of websocket_pdu, including newline batching.
+         */
+        class AIS_SIMULATOR_API local_pdu : virtual public gr::block
+        {
+        public:
+            typedef std::shared_ptr<local_pdu> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of ais_simulator::local_pdu.
+             *
+             * \param socket_path Path of the Unix domain socket, empty disables
+             *        the socket.
+             * \param shm_name Name of the shared memory ring as for shm_open(),
+             *        e.g. "/ais_simulator". Empty disables the ring.
+             * \param shm_size Data size of the ring in bytes, a power of two of
+             *        at least 4096.
+             */
+            static sptr make(std::string socket_path, std::string shm_name, int shm_size = 1 << 20);
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_LOCAL_PDU_H */
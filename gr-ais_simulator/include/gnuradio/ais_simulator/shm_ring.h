@@ -0,0 +1,180 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_SHM_RING_H
+#define INCLUDED_AIS_SIMULATOR_SHM_RING_H
+
+/*
+ * Shared memory ring for the local_pdu block, header only C API for
+ * producers running on the same host.
+ *
+ * The block creates the POSIX shared memory object, producers attach to it
+ * and write sentences with ais_shm_write(), or reserve space, fill it in
+ * place and commit. Single producer, single consumer. Records are a 32 bit
+ * length followed by the payload, aligned to 8 bytes. A record never wraps,
+ * the tail of the data area is skipped with a pad record instead.
+ *
+ * Producers need _GNU_SOURCE (the default with -std=gnu11) and -lrt on
+ * older glibc.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define AIS_SHM_MAGIC 0x41495352u /* "AISR" */
+#define AIS_SHM_VERSION 1u
+#define AIS_SHM_PAD 0xffffffffu
+#define AIS_SHM_ALIGN(n) (((n) + 7u) & ~(uint64_t)7u)
+
+struct ais_shm_ring {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity; /* Data bytes, power of two */
+    /* Consumer position and sleep flag */
+    uint64_t head __attribute__((aligned(64)));
+    uint32_t waiting;
+    /* Producer position and wake up counter */
+    uint64_t tail __attribute__((aligned(64)));
+    uint32_t wake;
+    uint8_t data[] __attribute__((aligned(64)));
+};
+
+typedef struct {
+    struct ais_shm_ring *ring;
+    size_t size;
+    uint64_t reserved; /* Bytes of the pending reservation */
+} ais_shm_producer;
+
+/* Attach to the ring created by the block. Returns 0 or -errno. */
+static inline int ais_shm_open(ais_shm_producer *p, const char *name)
+{
+    struct stat st;
+    int fd = shm_open(name, O_RDWR, 0);
+    if (fd < 0)
+    {
+        return -errno;
+    }
+    if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(struct ais_shm_ring))
+    {
+        close(fd);
+        return -EINVAL;
+    }
+    void *m = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED)
+    {
+        return -errno;
+    }
+    p->ring = (struct ais_shm_ring *)m;
+    p->size = st.st_size;
+    p->reserved = 0;
+    if (p->ring->magic != AIS_SHM_MAGIC || p->ring->version != AIS_SHM_VERSION)
+    {
+        munmap(m, st.st_size);
+        return -EPROTO;
+    }
+    return 0;
+}
+
+static inline void ais_shm_close(ais_shm_producer *p)
+{
+    if (p->ring)
+    {
+        munmap(p->ring, p->size);
+        p->ring = NULL;
+    }
+}
+
+/*
+ * Reserve len payload bytes. Returns the write pointer, or NULL when the
+ * ring is full (retry later) or len can never fit.
+ */
+static inline char *ais_shm_reserve(ais_shm_producer *p, uint32_t len)
+{
+    struct ais_shm_ring *r = p->ring;
+    const uint64_t cap = r->capacity;
+    const uint64_t need = AIS_SHM_ALIGN(4 + (uint64_t)len);
+    uint64_t tail = r->tail;
+    uint64_t skip = cap - (tail & (cap - 1));
+    skip = skip < need ? skip : 0;
+    if (need > cap / 2 ||
+        tail + skip + need - __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) > cap)
+    {
+        return NULL;
+    }
+    if (skip)
+    {
+        /* Not enough room before the end, pad and start over at zero. */
+        const uint32_t pad = AIS_SHM_PAD;
+        memcpy(r->data + (tail & (cap - 1)), &pad, 4);
+        tail += skip;
+        __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+    }
+    memcpy(r->data + (tail & (cap - 1)), &len, 4);
+    p->reserved = need;
+    return (char *)r->data + (tail & (cap - 1)) + 4;
+}
+
+/* Publish the reserved record and wake the consumer if it sleeps. */
+static inline void ais_shm_commit(ais_shm_producer *p)
+{
+    struct ais_shm_ring *r = p->ring;
+    __atomic_store_n(&r->tail, r->tail + p->reserved, __ATOMIC_SEQ_CST);
+    p->reserved = 0;
+    if (__atomic_load_n(&r->waiting, __ATOMIC_SEQ_CST))
+    {
+        __atomic_add_fetch(&r->wake, 1, __ATOMIC_SEQ_CST);
+        syscall(SYS_futex, &r->wake, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+}
+
+/*
+ * Copy one sentence into the ring. Returns 0, -EAGAIN when full, or
+ * -EMSGSIZE when the record can never fit.
+ */
+static inline int ais_shm_write(ais_shm_producer *p, const char *s, uint32_t len)
+{
+    char *w = ais_shm_reserve(p, len);
+    if (!w)
+    {
+        return AIS_SHM_ALIGN(4 + (uint64_t)len) > p->ring->capacity / 2 ? -EMSGSIZE : -EAGAIN;
+    }
+    memcpy(w, s, len);
+    ais_shm_commit(p);
+    return 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INCLUDED_AIS_SIMULATOR_SHM_RING_H */
@@ -0,0 +1,65 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_UDP_NMEA_PDU_H
+#define INCLUDED_AIS_SIMULATOR_UDP_NMEA_PDU_H
+
+#include <gnuradio/ais_simulator/api.h>
+#include <gnuradio/block.h>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*!
+         * \brief Ingest AIS NMEA sentences from UDP.
+         * \ingroup ais_simulator
+         *
+         * Receives datagrams in batches, decodes !AIVDM and !AIVDO sentences,
+         * reassembles multipart messages and publishes the payload bit
+         * strings as PDUs identical to the out port of websocket_pdu.
+         */
+        class AIS_SIMULATOR_API udp_nmea_pdu : virtual public gr::block
+        {
+        public:
+            typedef std::shared_ptr<udp_nmea_pdu> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of ais_simulator::udp_nmea_pdu.
+             *
+             * \param addr Listen address, empty for all interfaces.
+             * \param port Listen port.
+             * \param verify_checksum Drop sentences with a wrong checksum.
+             */
+            static sptr make(std::string addr, std::string port, bool verify_checksum = true);
+
+            //! Payloads published.
+            virtual uint64_t sentences() const = 0;
+            //! Datagrams dropped by the kernel because the socket buffer was full.
+            virtual uint64_t dropped() const = 0;
+            //! Sentences dropped for bad checksum, format or truncation.
+            virtual uint64_t errors() const = 0;
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_UDP_NMEA_PDU_H */
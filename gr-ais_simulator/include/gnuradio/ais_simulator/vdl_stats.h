@@ -0,0 +1,105 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_VDL_STATS_H
+#define INCLUDED_AIS_SIMULATOR_VDL_STATS_H
+
+#include <gnuradio/ais_simulator/api.h>
+#include <gnuradio/ais_simulator/bitstring_to_frame.h>
+#include <gnuradio/sync_block.h>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*!
+         * \brief VHF data link load statistics of built frames.
+         * \ingroup ais_simulator
+         *
+         * Watches the tagged stream of built frames of one channel and keeps
+         * statistics over a sliding window of whole seconds: slots used per
+         * minute, frames by number of slots, the share of air time taken by
+         * frames including their stuffing bits, and the number of stations
+         * (MMSI) heard. Counters live in a ring of per second buckets, each
+         * frame updates them in constant time.
+         *
+         * Frame time is the "time" tag at the frame start (UNIX seconds, as
+         * from frame_library_source), otherwise the wall clock at the time
+         * the frame passes.
+         *
+         * Every report interval a PDU is published on the "stats" port. The
+         * meta data holds "channel", "time", "window", "frames",
+         * "slots_per_minute", "slot_occupancy", "air_time", "stuffing_bits",
+         * "stations" and "stations_dropped". The data is a u64vector with the
+         * number of frames taking 1 to 5 slots.
+         *
+         * The stream passes through unchanged when the output is connected.
+         */
+        class AIS_SIMULATOR_API vdl_stats : virtual public gr::sync_block
+        {
+        public:
+            typedef std::shared_ptr<vdl_stats> sptr;
+
+            /*!
+             * \brief Return a shared_ptr to a new instance of ais_simulator::vdl_stats.
+             *
+             * \param enable_nrzi Frames are NRZI encoded.
+             * \param len_tag_key Name of the tagged stream length tag.
+             * \param channel AIS channel for the reports, 'A' or 'B'.
+             * \param baud_rate Channel bit rate for the air time share.
+             * \param window Sliding window in seconds, 1 to 3600.
+             * \param report_interval Seconds between "stats" PDUs, zero for
+             *        none.
+             * \param max_stations Stations tracked within the window, more
+             *        are counted by stations_dropped().
+             * \param format Input format, FRAME_PACKED or FRAME_UNPACKED.
+             */
+            static sptr make(bool enable_nrzi,
+                             const std::string &len_tag_key,
+                             char channel = 'A',
+                             double baud_rate = 9600,
+                             int window = 60,
+                             double report_interval = 10,
+                             int max_stations = 4096,
+                             frame_format format = FRAME_PACKED);
+
+            //! Frames seen since start.
+            virtual uint64_t frames() const = 0;
+            //! Frames without a valid CRC, not counted in the statistics.
+            virtual uint64_t errors() const = 0;
+            //! Slots used within the window, scaled to one minute.
+            virtual double slots_per_minute() const = 0;
+            //! Share of the 2250 slots per minute in use.
+            virtual double slot_occupancy() const = 0;
+            //! Share of air time within the window taken by frames.
+            virtual double air_time() const = 0;
+            //! Stations heard within the window.
+            virtual int stations() const = 0;
+            //! Frames of stations not tracked for lack of room.
+            virtual uint64_t stations_dropped() const = 0;
+            //! Frames within the window taking 1 to 5 slots.
+            virtual std::vector<uint64_t> slot_histogram() const = 0;
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_VDL_STATS_H */
@@ -46,8 +46,57 @@ namespace gr
              * constructor is in a private implementation
              * class. ais_simulator::websocket_pdu::make is the public interface for
              * creating new instances.
+             *
+             * \param addr Listen address, empty for all interfaces.
+             * \param port Listen port.
+             * \param high_watermark Pause reading from clients when this many
+             *        published messages are not yet credited on the "credit"
+             *        port. Zero disables flow control.
+             * \param low_watermark Resume reading at or below this many
+             *        uncredited messages.
+             * \param report_credit Send "credit:<n>" to clients when reading
+             *        pauses or resumes.
+             * \param deflate_window_bits Offer permessage-deflate with this
+             *        LZ77 window size, 9 to 15 bits. Zero disables compression.
+             * \param deflate_mem_level zlib memory level for compression,
+             *        1 to 9.
+             * \param max_in_flight Publish at most this many messages not yet
+             *        credited on the "credit" port, the rest waits in one lane
+             *        per priority class. Urgent messages are published
+             *        regardless. Zero publishes at once.
+             * \param starvation_limit Normal or bulk messages passed over this
+             *        many times in a row get the next turn. Zero for strict
+             *        priority.
+             * \param capture_file Record every message received from clients
+             *        with a nanosecond time stamp into this file, written by a
+             *        background thread. Empty disables capture.
+             * \param replay_file Feed a capture back as if a client sent it,
+             *        starting with the flow graph. Sentences are published in
+             *        capture order without the priority lanes, every run
+             *        publishes the same PDUs. Empty disables replay.
+             * \param replay_speed Replay pacing relative to the capture, 1 for
+             *        the original timing, 0 as fast as possible.
+             *
+             * Sentences of types 12 and 14 are urgent, others normal. A batch
+             * starting with the line "@priority urgent", "normal" or "bulk"
+             * sets the class of all its sentences. Published PDUs carry the
+             * class as "priority" symbol in the meta data.
              */
-            static sptr make(std::string addr, std::string port);
+            static sptr make(std::string addr,
+                             std::string port,
+                             int high_watermark = 0,
+                             int low_watermark = 0,
+                             bool report_credit = false,
+                             int deflate_window_bits = 0,
+                             int deflate_mem_level = 8,
+                             int max_in_flight = 0,
+                             int starvation_limit = 8,
+                             std::string capture_file = "",
+                             std::string replay_file = "",
+                             double replay_speed = 1.0);
+
+            //! Messages on the "send" port dropped while the send queue was full.
+            virtual uint64_t send_dropped() const = 0;
         };
 
     } // namespace ais_simulator
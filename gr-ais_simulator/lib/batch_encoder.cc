@@ -0,0 +1,274 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "batch_encoder.h"
+#include "frame_builder.h"
+#include <cstring>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        namespace framing
+        {
+            /*
+             * Transpose a 64x64 bit matrix in place. Word i bit j moves to word j
+             * bit i.
+             */
+            static void transpose64(uint64_t *w)
+            {
+                uint64_t m = 0x00000000FFFFFFFFULL;
+                for (int s = 32; s != 0; s >>= 1, m ^= m << s)
+                {
+#pragma GCC unroll 32
+                    for (int i = 0; i < 64; i = (i + s + 1) & ~s)
+                    {
+                        const uint64_t t = ((w[i] >> s) ^ w[i + s]) & m;
+                        w[i] ^= t << s;
+                        w[i + s] ^= t;
+                    }
+                }
+            }
+
+            /*
+             * Transpose the four 16x16 bit blocks held in 16 words in place.
+             * Word i bit 16 * b + j moves to word j bit 16 * b + i. The last
+             * four stages of transpose64() with 16 words.
+             */
+            static void transpose16x4(uint64_t *w)
+            {
+                uint64_t m = 0x00FF00FF00FF00FFULL;
+                for (int s = 8; s != 0; s >>= 1, m ^= m << s)
+                {
+#pragma GCC unroll 8
+                    for (int i = 0; i < 16; i = (i + s + 1) & ~s)
+                    {
+                        const uint64_t t = ((w[i] >> s) ^ w[i + s]) & m;
+                        w[i] ^= t << s;
+                        w[i + s] ^= t;
+                    }
+                }
+            }
+
+            /*
+             * Load eight bytes, first byte in the least significant bits.
+             */
+            static inline uint64_t load_le(const uint8_t *p)
+            {
+                uint64_t x;
+                std::memcpy(&x, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+                x = __builtin_bswap64(x);
+#endif
+                return x;
+            }
+
+            /*
+             * Load the last bytes < 8 of a payload of at least eight bytes. The
+             * load ends at the payload end and shifts out the bytes before.
+             */
+            static inline uint64_t load_le_tail(const uint8_t *p, int bytes)
+            {
+                return load_le(p + bytes - 8) >> ((8 - bytes) * 8);
+            }
+
+            static inline uint64_t load_le_short(const uint8_t *p, int bytes)
+            {
+                uint64_t x = 0;
+                for (int q = 0; q < bytes; q++)
+                {
+                    x |= (uint64_t)p[q] << (q * 8);
+                }
+                return x;
+            }
+
+            /*
+             * Feed one bit of every lane into the CRC register ring. Register
+             * bit 0 is c[r], it shifts right once per bit and the feedback enters
+             * bits 15, 10 and 3 (reflected polynom 0x8408).
+             */
+            static inline void crc_step(uint64_t *c, int r, uint64_t bits)
+            {
+                const uint64_t fb = c[r & 15] ^ bits;
+                c[r & 15] = fb;
+                c[(r + 11) & 15] ^= fb;
+                c[(r + 4) & 15] ^= fb;
+            }
+
+            void batch_encoder::crc16(const uint8_t *payloads,
+                                      int stride,
+                                      int n,
+                                      int len,
+                                      uint16_t *crc)
+            {
+                uint64_t c[16];
+                for (auto &w : c)
+                {
+                    w = ~0ULL;
+                }
+
+                // Eight payload bytes of every lane per block. After transposing,
+                // word 8 * q + b holds bit b of byte q of all lanes, which is the
+                // order bits are sent on air.
+                uint64_t w[64];
+                int j = 0;
+                for (; j < len; j += 8)
+                {
+                    const int bytes = len - j < 8 ? len - j : 8;
+                    const uint8_t *p = payloads + j;
+                    int l = 0;
+                    if (bytes == 8)
+                    {
+                        for (; l < n; l++, p += stride)
+                        {
+                            w[l] = load_le(p);
+                        }
+                    }
+                    else if (len >= 8)
+                    {
+                        for (; l < n; l++, p += stride)
+                        {
+                            w[l] = load_le_tail(p, bytes);
+                        }
+                    }
+                    else
+                    {
+                        for (; l < n; l++, p += stride)
+                        {
+                            w[l] = load_le_short(p, bytes);
+                        }
+                    }
+                    for (; l < LANES; l++)
+                    {
+                        w[l] = 0;
+                    }
+                    transpose64(w);
+
+                    if (bytes == 8)
+                    {
+                        // 64 steps bring the ring back to start, unrolled the
+                        // indices are constant and the ring stays in registers.
+                        for (int k = 0; k < 64; k += 16)
+                        {
+#pragma GCC unroll 16
+                            for (int i = 0; i < 16; i++)
+                            {
+                                crc_step(c, i, w[k + i]);
+                            }
+                        }
+                    }
+                    else
+                    {
+                        for (int k = 0; k < bytes * 8; k++)
+                        {
+                            crc_step(c, k, w[k]);
+                        }
+                    }
+                }
+
+                // Gather the register bits per lane. After the block transpose
+                // word j bits 16 * b .. 16 * b + 15 hold the CRC of lane 16 * b + j.
+                const int r = (len * 8) & 15;
+                for (int i = 0; i < 16; i++)
+                {
+                    w[i] = c[(r + i) & 15];
+                }
+                transpose16x4(w);
+                for (int l = 0; l < n; l++)
+                {
+                    crc[l] = (uint16_t)((w[l & 15] >> (l & ~15)) ^ 0xffff);
+                }
+            }
+
+            template <bool NRZI, bool SINGLE_SLOT>
+            static void encode_lanes(const uint8_t *payloads,
+                                     int stride,
+                                     int n,
+                                     int len,
+                                     uint8_t *out,
+                                     int out_stride,
+                                     int *out_len)
+            {
+                uint16_t crc[batch_encoder::LANES];
+                for (int i = 0; i < n; i += batch_encoder::LANES)
+                {
+                    const int lanes = n - i < batch_encoder::LANES ? n - i : batch_encoder::LANES;
+                    if (len >= batch_encoder::SLICED_CRC_MIN_LEN)
+                    {
+                        batch_encoder::crc16(payloads + (long)i * stride, stride, lanes, len, crc);
+                    }
+                    else
+                    {
+                        for (int l = 0; l < lanes; l++)
+                        {
+                            crc[l] = framing::crc16(payloads + ((long)i + l) * stride, len);
+                        }
+                    }
+                    // Stuffing is variable length, continue per lane.
+                    for (int l = 0; l < lanes; l++)
+                    {
+                        const long k = (long)i + l;
+                        out_len[k] = build_frame<NRZI, SINGLE_SLOT>(
+                            payloads + k * stride, len, crc[l], out + k * out_stride);
+                    }
+                }
+            }
+
+            void batch_encoder::encode(const uint8_t *payloads,
+                                       int stride,
+                                       int n,
+                                       int len,
+                                       bool enable_nrzi,
+                                       uint8_t *out,
+                                       int out_stride,
+                                       int *out_len)
+            {
+                const bool single_slot = len * 8 <= LEN_SLOT_PAYLOAD;
+                if (enable_nrzi)
+                {
+                    if (single_slot)
+                    {
+                        encode_lanes<true, true>(payloads, stride, n, len, out, out_stride, out_len);
+                    }
+                    else
+                    {
+                        encode_lanes<true, false>(payloads, stride, n, len, out, out_stride, out_len);
+                    }
+                }
+                else
+                {
+                    if (single_slot)
+                    {
+                        encode_lanes<false, true>(payloads, stride, n, len, out, out_stride, out_len);
+                    }
+                    else
+                    {
+                        encode_lanes<false, false>(payloads, stride, n, len, out, out_stride, out_len);
+                    }
+                }
+            }
+
+        } // namespace framing
+    } // namespace ais_simulator
+} // namespace gr
@@ -0,0 +1,80 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_BATCH_ENCODER_H
+#define INCLUDED_AIS_SIMULATOR_BATCH_ENCODER_H
+
+#include <cstdint>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        namespace framing
+        {
+            /*
+             * Bit-sliced batch frame encoder for offline frame generation.
+             *
+             * Up to LANES payloads of equal length are transposed so that one
+             * 64-bit word holds the same payload bit of every frame. The CRC of
+             * all lanes is then computed with word wide boolean operations. Bit
+             * stuffing and NRZI follow the stuffing of each frame, they run per
+             * lane on packed bytes.
+             */
+            class batch_encoder
+            {
+            public:
+                static constexpr int LANES = 64;
+                // Below this payload length in bytes the transposition costs more
+                // than the table driven CRC saves, short payloads use the latter.
+                // Single slot frames (21 bytes) and longer take the sliced CRC.
+                static constexpr int SLICED_CRC_MIN_LEN = 16;
+
+                /*
+                 * Calculate the CRC-16/ITU of n <= LANES payloads of len bytes.
+                 * Payload i starts at payloads + i * stride.
+                 */
+                static void crc16(const uint8_t *payloads,
+                                  int stride,
+                                  int n,
+                                  int len,
+                                  uint16_t *crc);
+
+                /*
+                 * Build frames from n payloads of len bytes each, any n.
+                 * Frame i is written to out + i * out_stride and its length in
+                 * bytes to out_len[i]. out_stride must be at least
+                 * frame_bytes_max(len * 8).
+                 */
+                static void encode(const uint8_t *payloads,
+                                   int stride,
+                                   int n,
+                                   int len,
+                                   bool enable_nrzi,
+                                   uint8_t *out,
+                                   int out_stride,
+                                   int *out_len);
+            };
+
+        } // namespace framing
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_BATCH_ENCODER_H */
@@ -22,39 +22,63 @@
 #define INCLUDED_AIS_SIMULATOR_BITSTRING_TO_FRAME_IMPL_H
 
 #include <gnuradio/ais_simulator/bitstring_to_frame.h>
+#include "frame_builder.h"
+#include <cstring>
 
 namespace gr
 {
     namespace ais_simulator
     {
 
+        inline size_t frame_item_size(frame_format format)
+        {
+            return format == FRAME_NRZ ? sizeof(float) : sizeof(unsigned char);
+        }
+
+        // Output items per packed frame byte.
+        inline int frame_items_per_byte(frame_format format)
+        {
+            return format == FRAME_PACKED ? 1 : 8;
+        }
+
+        /*
+         * Write a packed frame of len bytes to out in the output format, out
+         * may be frame itself. Returns the number of output items.
+         */
+        inline int format_frame(frame_format format, const uint8_t *frame, int len, uint8_t *out)
+        {
+            switch (format)
+            {
+            case FRAME_UNPACKED:
+                return framing::unpack_frame(frame, len, out);
+            case FRAME_NRZ:
+                return framing::unpack_frame(frame, len, reinterpret_cast<float *>(out));
+            default:
+                if (frame != out)
+                {
+                    std::memcpy(out, frame, len);
+                }
+                return len;
+            }
+        }
+
+        template <bool NRZI>
         class bitstring_to_frame_impl : public bitstring_to_frame
         {
         private:
-            bool d_enable_nrzi;
-            const char *d_sentence;
-            char *d_payload;
+            uint8_t d_payload[framing::LEN_BUFFER / 8];
             unsigned short d_len_payload;
             std::vector<tag_t> d_tags;
+            const pmt::pmt_t d_credit_port;
+            const pmt::pmt_t d_credit;
+            const frame_format d_format;
 
         protected:
-            static const char preamble[24];
-            static const char start_mark[8];
-            static const unsigned short crc_itu16_table[256];
             int calculate_output_stream_length(const gr_vector_int &ninput_items);
             bool set_sentence(const char *sentence, long length);
-            void dump_buffer(const char *b, int buffer_size);
-            char *int2bin(int a, char *buffer, int buf_size);
-            int stuff(const char *in, char *out, int l_in);
-            void pack(int orig_ascii, char *ret, int bits_per_byte);
-            void nrz_to_nrzi(char *data, int length);
-            void reverse_bit_order(char *data, int length);
-            unsigned long unpack(char *buffer, int start, int length);
-            void compute_crc(char *buffer, char *ret, unsigned int len);
-            void byte_packing(char *input_frame, unsigned char *out_byte, unsigned int len);
 
         public:
-            bitstring_to_frame_impl(bool enable_nrzi, const std::string &len_tag_key);
+            bitstring_to_frame_impl(const std::string &len_tag_key, frame_format format);
             ~bitstring_to_frame_impl();
 
             // Where all the action really happens
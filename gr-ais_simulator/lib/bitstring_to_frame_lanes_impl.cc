@@ -0,0 +1,180 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "bitstring_to_frame_impl.h"
+#include "bitstring_to_frame_lanes_impl.h"
+#include "frame_builder.h"
+#include <algorithm>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*
+         * The private constructor
+         */
+        bitstring_to_frame_lanes_impl::bitstring_to_frame_lanes_impl(bool enable_nrzi,
+                                                                     const std::string &len_tag_key,
+                                                                     frame_format format,
+                                                                     int starvation_limit)
+            : gr::tagged_stream_block("bitstring_to_frame",
+                                      gr::io_signature::make(1, 1, sizeof(char)),
+                                      gr::io_signature::make(1, 1, frame_item_size(format)), len_tag_key),
+              d_len_tag_key(pmt::string_to_symbol(len_tag_key)),
+              d_credit_port(pmt::mp("credit")),
+              d_length_key(pmt::string_to_symbol("length")),
+              d_priority_key(pmt::string_to_symbol("priority")),
+              d_format(format),
+              d_item_size(frame_item_size(format)),
+              d_encode(enable_nrzi ? &framing::encode_sentence<true> : &framing::encode_sentence<false>),
+              d_lanes(starvation_limit)
+        {
+            // Output length tags are written per frame.
+            set_tag_propagation_policy(TPP_DONT);
+            // Room for the largest frame only, the backlog stays in the lanes.
+            set_max_output_buffer(0, framing::frame_bytes_max(framing::LEN_PAYLOAD_MAX) * frame_items_per_byte(format));
+            // Credits for built frames, for upstream flow control.
+            message_port_register_out(d_credit_port);
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        bitstring_to_frame_lanes_impl::~bitstring_to_frame_lanes_impl()
+        {
+        }
+
+        void bitstring_to_frame_lanes_impl::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+        {
+            // Keep getting called while the lanes hold packets.
+            ninput_items_required[0] = d_lanes.empty() ? 1 : 0;
+        }
+
+        /*
+         * Cut the copied sentence of a packet to its "length" tag, empty
+         * without one as in the other modes, and find its class from the
+         * "priority" tag or the message type.
+         */
+        priority_class
+        bitstring_to_frame_lanes_impl::packet_priority(uint64_t offset, long len, std::string &sentence)
+        {
+            long tag_len = 0;
+            priority_class c = PRIORITY_CLASSES;
+            get_tags_in_range(d_packet_tags, 0, offset, offset + len);
+            for (const auto &tag : d_packet_tags)
+            {
+                if (pmt::eqv(tag.key, d_length_key))
+                {
+                    tag_len = pmt::to_long(tag.value);
+                }
+                else if (pmt::eqv(tag.key, d_priority_key))
+                {
+                    if (pmt::is_symbol(tag.value))
+                    {
+                        const std::string name = pmt::symbol_to_string(tag.value);
+                        c = priority_from_name(name.data(), name.size());
+                    }
+                    else if (pmt::is_integer(tag.value))
+                    {
+                        c = (priority_class)std::min<long>(std::max<long>(pmt::to_long(tag.value), 0), PRIORITY_BULK);
+                    }
+                }
+            }
+            sentence.resize(std::max(std::min(tag_len, len), 0L));
+            return c != PRIORITY_CLASSES ? c : sentence_priority(sentence.data(), sentence.size());
+        }
+
+        int bitstring_to_frame_lanes_impl::general_work(int noutput_items,
+                                                        gr_vector_int &ninput_items,
+                                                        gr_vector_const_void_star &input_items,
+                                                        gr_vector_void_star &output_items)
+        {
+            const char *in = (const char *)input_items[0];
+            uint8_t *out = (uint8_t *)output_items[0];
+            const int items_per_byte = frame_items_per_byte(d_format);
+            const uint64_t nread = nitems_read(0);
+
+            // Move complete packets waiting in the input buffer into the lanes.
+            int consumed = 0;
+            get_tags_in_range(d_tags, 0, nread, nread + ninput_items[0], d_len_tag_key);
+            for (const auto &tag : d_tags)
+            {
+                const int start = (int)(tag.offset - nread);
+                const long len = pmt::to_long(tag.value);
+                if (start < consumed || start + len > ninput_items[0] ||
+                    d_lanes.size() >= LANES_MAX_PACKETS)
+                {
+                    break;
+                }
+                std::string sentence;
+                if (!d_free.empty())
+                {
+                    sentence = std::move(d_free.back());
+                    d_free.pop_back();
+                }
+                sentence.assign(in + start, len);
+                const priority_class c = packet_priority(nread + start, len, sentence);
+                d_lanes.push(c, std::move(sentence));
+                consumed = start + (int)len;
+            }
+            consume_each(consumed);
+
+            // Build frames in priority order while they fit.
+            int produced = 0;
+            long built = 0;
+            const std::string *next;
+            while ((next = d_lanes.front()) != nullptr)
+            {
+                // encode_sentence() truncates to the longest payload, size for
+                // that so an overlong sentence can't block the lanes.
+                const long len = std::min<long>(next->size(), framing::LEN_PAYLOAD_MAX);
+                if (framing::frame_bytes_max((int)len) * items_per_byte > noutput_items - produced)
+                {
+                    break;
+                }
+                d_lanes.pop(d_sentence);
+                uint8_t *o = out + produced * d_item_size;
+                const int n = format_frame(d_format, o, d_encode(d_sentence.data(), d_sentence.size(), o), o);
+                if (n > 0)
+                {
+                    add_item_tag(0, nitems_written(0) + produced, d_len_tag_key, pmt::from_long(n));
+                }
+                produced += n;
+                built++;
+                if (d_free.size() < LANES_MAX_PACKETS)
+                {
+                    d_free.push_back(std::move(d_sentence));
+                }
+            }
+            if (built > 0)
+            {
+                message_port_pub(d_credit_port, pmt::from_long(built));
+            }
+            return produced;
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
@@ -0,0 +1,90 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_BITSTRING_TO_FRAME_LANES_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_BITSTRING_TO_FRAME_LANES_IMPL_H
+
+#include <gnuradio/ais_simulator/bitstring_to_frame.h>
+#include "priority_lanes.h"
+#include <string>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*
+         * Priority lane mode of bitstring_to_frame.
+         *
+         * Like the worker pool mode this overrides general_work to see all
+         * packets waiting in the input buffer. They are moved into one lane
+         * per priority class, frames are built from the lanes as output space
+         * allows. The output buffer is kept to the largest frame, so an
+         * urgent packet never waits behind more than the frames downstream.
+         */
+        class bitstring_to_frame_lanes_impl : public bitstring_to_frame
+        {
+        private:
+            // Packets held in the lanes at most, the rest waits in the input.
+            static const size_t LANES_MAX_PACKETS = 4096;
+
+            const pmt::pmt_t d_len_tag_key;
+            const pmt::pmt_t d_credit_port;
+            const pmt::pmt_t d_length_key;
+            const pmt::pmt_t d_priority_key;
+            const frame_format d_format;
+            const size_t d_item_size;
+            int (*const d_encode)(const char *sentence, long length, uint8_t *out);
+            priority_lanes<std::string> d_lanes;
+            std::string d_sentence;
+            std::vector<std::string> d_free;
+            std::vector<tag_t> d_tags;
+            std::vector<tag_t> d_packet_tags;
+
+            priority_class packet_priority(uint64_t offset, long len, std::string &sentence);
+
+        public:
+            bitstring_to_frame_lanes_impl(bool enable_nrzi,
+                                          const std::string &len_tag_key,
+                                          frame_format format,
+                                          int starvation_limit);
+            ~bitstring_to_frame_lanes_impl();
+
+            void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+            int general_work(int noutput_items,
+                             gr_vector_int &ninput_items,
+                             gr_vector_const_void_star &input_items,
+                             gr_vector_void_star &output_items);
+
+            // Unused, general_work is overridden.
+            int work(int noutput_items,
+                     gr_vector_int &ninput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items)
+            {
+                return 0;
+            }
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_BITSTRING_TO_FRAME_LANES_IMPL_H */
@@ -0,0 +1,199 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "bitstring_to_frame_impl.h"
+#include "bitstring_to_frame_pool_impl.h"
+#include "frame_builder.h"
+#include <algorithm>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*
+         * The private constructor
+         */
+        bitstring_to_frame_pool_impl::bitstring_to_frame_pool_impl(bool enable_nrzi,
+                                                                   const std::string &len_tag_key,
+                                                                   int threads,
+                                                                   frame_format format)
+            : gr::tagged_stream_block("bitstring_to_frame",
+                                      gr::io_signature::make(1, 1, sizeof(char)),
+                                      gr::io_signature::make(1, 1, frame_item_size(format)), len_tag_key),
+              d_len_tag_key(pmt::string_to_symbol(len_tag_key)),
+              d_credit_port(pmt::mp("credit")),
+              d_ready_port(pmt::mp("ready")),
+              d_length_key(pmt::string_to_symbol("length")),
+              d_format(format),
+              d_item_size(frame_item_size(format)),
+              d_encode(enable_nrzi ? &framing::encode_sentence<true> : &framing::encode_sentence<false>),
+              d_pool(threads, 64 * threads, d_encode, [this] { _post(d_ready_port, pmt::PMT_T); })
+        {
+            // Output length tags are written per frame.
+            set_tag_propagation_policy(TPP_DONT);
+            // Credits for consumed packets, for upstream flow control.
+            message_port_register_out(d_credit_port);
+            // Internal wake up, the message itself is ignored. Handling it
+            // lets the scheduler call work again for the finished frame.
+            message_port_register_in(d_ready_port);
+            set_msg_handler(d_ready_port, [](pmt::pmt_t) {});
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        bitstring_to_frame_pool_impl::~bitstring_to_frame_pool_impl()
+        {
+        }
+
+        void bitstring_to_frame_pool_impl::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+        {
+            // Without input only get called for a finished frame, the ready
+            // port wakes the block thread when the next one is done.
+            ninput_items_required[0] = d_pool.ready() ? 0 : 1;
+        }
+
+        /*
+         * Sentence length from "length" tag within packet, zero if missing,
+         * at most the packet length.
+         */
+        long bitstring_to_frame_pool_impl::sentence_length(uint64_t offset, long len)
+        {
+            long tag_len = 0;
+            get_tags_in_range(d_length_tags, 0, offset, offset + len, d_length_key);
+            for (const auto &tag : d_length_tags)
+            {
+                tag_len = pmt::to_long(tag.value);
+            }
+            return std::min(tag_len, len);
+        }
+
+        void bitstring_to_frame_pool_impl::add_length_tag(int offset, int len)
+        {
+            add_item_tag(0, nitems_written(0) + offset, d_len_tag_key, pmt::from_long(len));
+        }
+
+        void bitstring_to_frame_pool_impl::credit(long packets)
+        {
+            if (packets > 0)
+            {
+                message_port_pub(d_credit_port, pmt::from_long(packets));
+            }
+        }
+
+        int bitstring_to_frame_pool_impl::general_work(int noutput_items,
+                                                       gr_vector_int &ninput_items,
+                                                       gr_vector_const_void_star &input_items,
+                                                       gr_vector_void_star &output_items)
+        {
+            const char *in = (const char *)input_items[0];
+            // Frames are written in bytes, produced counts output items.
+            uint8_t *out = (uint8_t *)output_items[0];
+            const int items_per_byte = frame_items_per_byte(d_format);
+            const uint64_t nread = nitems_read(0);
+            int consumed = 0;
+            int produced = 0;
+
+            // Complete packets waiting in the input buffer.
+            std::vector<std::pair<int, long>> packets;
+            get_tags_in_range(d_tags, 0, nread, nread + ninput_items[0], d_len_tag_key);
+            for (const auto &tag : d_tags)
+            {
+                const int start = (int)(tag.offset - nread);
+                const long len = pmt::to_long(tag.value);
+                if (start < consumed || start + len > ninput_items[0])
+                {
+                    break;
+                }
+                packets.emplace_back(start, len);
+                consumed = start + (int)len;
+            }
+            consumed = 0;
+
+            if (d_pool.in_flight() == 0 && (int)packets.size() <= INLINE_MAX_PACKETS)
+            {
+                // Low queue depth, no need to pay the pool's latency.
+                for (const auto &p : packets)
+                {
+                    // encode_sentence() truncates to the longest payload, size
+                    // for that so an overlong tag can't block the input.
+                    const long len = std::min<long>(sentence_length(nread + p.first, p.second),
+                                                    framing::LEN_PAYLOAD_MAX);
+                    if (framing::frame_bytes_max((int)len) * items_per_byte > noutput_items - produced)
+                    {
+                        break;
+                    }
+                    uint8_t *o = out + produced * d_item_size;
+                    const int n = format_frame(d_format, o, d_encode(in + p.first, len, o), o);
+                    if (n > 0)
+                    {
+                        add_length_tag(produced, n);
+                    }
+                    produced += n;
+                    consumed = p.first + (int)p.second;
+                    credit(1);
+                }
+                consume_each(consumed);
+                return produced;
+            }
+
+            long submitted = 0;
+            for (const auto &p : packets)
+            {
+                if (d_pool.full())
+                {
+                    break;
+                }
+                d_pool.submit(in + p.first, sentence_length(nread + p.first, p.second));
+                consumed = p.first + (int)p.second;
+                submitted++;
+            }
+            consume_each(consumed);
+            credit(submitted);
+
+            // Write finished frames in order. Frames still being built are
+            // written in a later call, after the ready port wakes us.
+            const std::vector<uint8_t> *frame;
+            while ((frame = d_pool.front()) != nullptr)
+            {
+                const int n = (int)frame->size() * items_per_byte;
+                if (n > noutput_items - produced)
+                {
+                    break;
+                }
+                if (n > 0)
+                {
+                    format_frame(d_format, frame->data(), (int)frame->size(), out + produced * d_item_size);
+                    add_length_tag(produced, n);
+                }
+                produced += n;
+                d_pool.pop();
+            }
+            return produced;
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
@@ -0,0 +1,91 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_BITSTRING_TO_FRAME_POOL_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_BITSTRING_TO_FRAME_POOL_IMPL_H
+
+#include <gnuradio/ais_simulator/bitstring_to_frame.h>
+#include "frame_worker_pool.h"
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        /*
+         * Worker pool mode of bitstring_to_frame.
+         *
+         * A tagged stream block handles one packet per work call, so this
+         * implementation overrides general_work to see all packets waiting in
+         * the input buffer, hands them to the worker pool and writes finished
+         * frames in input order. Work never waits for a worker, a worker
+         * finishing the next frame posts to the ready port to wake the block
+         * thread instead.
+         */
+        class bitstring_to_frame_pool_impl : public bitstring_to_frame
+        {
+        private:
+            // Up to this many packets are built inline while the pool is idle.
+            static const int INLINE_MAX_PACKETS = 1;
+
+            const pmt::pmt_t d_len_tag_key;
+            const pmt::pmt_t d_credit_port;
+            const pmt::pmt_t d_ready_port;
+            const pmt::pmt_t d_length_key;
+            const frame_format d_format;
+            const size_t d_item_size;
+            frame_worker_pool::encode_fn d_encode;
+            frame_worker_pool d_pool;
+            std::vector<tag_t> d_tags;
+            std::vector<tag_t> d_length_tags;
+
+            long sentence_length(uint64_t offset, long len);
+            void add_length_tag(int offset, int len);
+            void credit(long packets);
+
+        public:
+            bitstring_to_frame_pool_impl(bool enable_nrzi,
+                                         const std::string &len_tag_key,
+                                         int threads,
+                                         frame_format format);
+            ~bitstring_to_frame_pool_impl();
+
+            void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+            int general_work(int noutput_items,
+                             gr_vector_int &ninput_items,
+                             gr_vector_const_void_star &input_items,
+                             gr_vector_void_star &output_items);
+
+            // Unused, general_work is overridden.
+            int work(int noutput_items,
+                     gr_vector_int &ninput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items)
+            {
+                return 0;
+            }
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_BITSTRING_TO_FRAME_POOL_IMPL_H */
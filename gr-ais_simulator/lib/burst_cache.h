@@ -0,0 +1,114 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_BURST_CACHE_H
+#define INCLUDED_AIS_SIMULATOR_BURST_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * LRU cache of modulated bursts keyed by frame bits, within a memory
+         * budget in bytes. Bursts are shared, one being streamed stays valid
+         * after eviction. Lookups take a view of the frame in the input
+         * buffer, only inserts copy the key. Not thread safe.
+         */
+        template <typename T>
+        class burst_cache
+        {
+        public:
+            typedef std::shared_ptr<const std::vector<T>> burst_ptr;
+
+            explicit burst_cache(size_t budget) : d_budget(budget) {}
+
+            // Cached burst of the frame, nullptr on a miss. A hit becomes
+            // the most recent entry.
+            burst_ptr find(std::string_view key)
+            {
+                auto it = d_index.find(key);
+                if (it == d_index.end())
+                {
+                    return nullptr;
+                }
+                d_lru.splice(d_lru.begin(), d_lru, it->second);
+                return it->second->burst;
+            }
+
+            /*
+             * Insert as most recent entry and evict least recently used ones
+             * beyond the budget. Bursts larger than the budget are not kept.
+             */
+            void insert(std::string_view key, burst_ptr burst)
+            {
+                const size_t bytes = burst->size() * sizeof(T) + key.size() + ENTRY_OVERHEAD;
+                if (bytes > d_budget || d_index.count(key))
+                {
+                    return;
+                }
+                while (d_bytes + bytes > d_budget)
+                {
+                    const entry &last = d_lru.back();
+                    d_bytes -= last.bytes;
+                    d_index.erase(last.key);
+                    d_lru.pop_back();
+                    d_evictions++;
+                }
+                d_lru.push_front(entry{ std::string(key), std::move(burst), bytes });
+                d_index.emplace(d_lru.front().key, d_lru.begin());
+                d_bytes += bytes;
+            }
+
+            size_t size() const { return d_lru.size(); }
+            size_t bytes() const { return d_bytes; }
+            uint64_t evictions() const { return d_evictions; }
+
+        private:
+            // List node, index slot and shared control block, roughly.
+            static const size_t ENTRY_OVERHEAD = 128;
+
+            struct entry {
+                std::string key;
+                burst_ptr burst;
+                size_t bytes;
+            };
+
+            const size_t d_budget;
+            size_t d_bytes = 0;
+            uint64_t d_evictions = 0;
+            std::list<entry> d_lru; // Most recent first
+            // Keys view the strings held by the list nodes.
+            std::unordered_map<std::string_view, typename std::list<entry>::iterator> d_index;
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_BURST_CACHE_H */
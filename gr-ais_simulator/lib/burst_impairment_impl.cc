@@ -0,0 +1,243 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "burst_impairment_impl.h"
+#include <volk/volk.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        namespace
+        {
+            const double SPEED_OF_LIGHT = 299792458.0;
+
+            /*
+             * y += h * x on interleaved complex floats. Written out in real
+             * arithmetic so the compiler vectorizes it, a std::complex
+             * multiply does not without -ffast-math.
+             */
+            void complex_axpy(float *__restrict y, const float *__restrict x, gr_complex h, size_t n)
+            {
+                const float hr = h.real();
+                const float hi = h.imag();
+                for (size_t i = 0; i < 2 * n; i += 2)
+                {
+                    y[i] += hr * x[i] - hi * x[i + 1];
+                    y[i + 1] += hr * x[i + 1] + hi * x[i];
+                }
+            }
+        } // namespace
+
+        burst_impairment::sptr burst_impairment::make(double samp_rate,
+                                                      double carrier_freq,
+                                                      double ref_range,
+                                                      double ref_snr_db,
+                                                      bool two_ray,
+                                                      double tx_height,
+                                                      double rx_height,
+                                                      int seed)
+        {
+            return gnuradio::get_initial_sptr(new burst_impairment_impl(
+                samp_rate, carrier_freq, ref_range, ref_snr_db, two_ray, tx_height, rx_height, seed));
+        }
+
+        /*
+         * The private constructor
+         */
+        burst_impairment_impl::burst_impairment_impl(double samp_rate,
+                                                     double carrier_freq,
+                                                     double ref_range,
+                                                     double ref_snr_db,
+                                                     bool two_ray,
+                                                     double tx_height,
+                                                     double rx_height,
+                                                     int seed)
+            : gr::block("burst_impairment",
+                        gr::io_signature::make(0, 0, 0),
+                        gr::io_signature::make(0, 0, 0)),
+              d_in_port(pmt::mp("in")),
+              d_out_port(pmt::mp("out")),
+              d_samp_rate(samp_rate),
+              d_carrier_freq(carrier_freq),
+              d_ref_range(ref_range),
+              d_two_ray(two_ray),
+              d_tx_height(tx_height),
+              d_rx_height(rx_height),
+              d_rng(seed)
+        {
+            if (samp_rate <= 0 || carrier_freq <= 0 || ref_range <= 0 || tx_height <= 0 ||
+                rx_height <= 0)
+            {
+                throw std::invalid_argument("burst_impairment: Invalid rate, frequency, range or height");
+            }
+
+            // One cycle of the Doppler oscillator, indexed by the top phase bits.
+            d_osc.resize(1 << OSC_BITS);
+            d_scaled.resize(d_osc.size());
+            for (size_t i = 0; i < d_osc.size(); i++)
+            {
+                d_osc[i] = std::polar(1.0f, (float)(2 * M_PI * i / d_osc.size()));
+            }
+
+            // Complex Gaussian noise at the power giving ref_snr_db for a unit
+            // power burst at the reference range.
+            if (std::isfinite(ref_snr_db))
+            {
+                const float sigma = std::sqrt(0.5 * std::pow(10.0, -ref_snr_db / 10.0));
+                std::normal_distribution<float> gauss(0, sigma);
+                d_noise.resize(NOISE_SIZE);
+                for (gr_complex &n : d_noise)
+                {
+                    n = gr_complex(gauss(d_rng), gauss(d_rng));
+                }
+            }
+
+            message_port_register_in(d_in_port);
+            message_port_register_out(d_out_port);
+            set_msg_handler(d_in_port, [this](pmt::pmt_t msg) { this->impair(msg); });
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        burst_impairment_impl::~burst_impairment_impl() {}
+
+        /*
+         * Path loss in dB relative to the reference range. Free space loss
+         * grows with 20 log10(d), two-ray loss with 40 log10(d) beyond the
+         * crossover distance 4 pi ht hr / lambda.
+         */
+        double burst_impairment_impl::path_loss_db(double range) const
+        {
+            auto loss = [this](double d) {
+                const double lambda = SPEED_OF_LIGHT / d_carrier_freq;
+                const double crossover = 4 * M_PI * d_tx_height * d_rx_height / lambda;
+                if (!d_two_ray || d < crossover)
+                {
+                    return 20 * std::log10(4 * M_PI * d / lambda);
+                }
+                return 40 * std::log10(d) - 20 * std::log10(d_tx_height * d_rx_height);
+            };
+            return loss(std::max(range, 1.0)) - loss(d_ref_range);
+        }
+
+        /*
+         * Impair one burst PDU: multipath FIR, then path loss and Doppler
+         * with one pass of the table oscillator, then noise.
+         */
+        void burst_impairment_impl::impair(pmt::pmt_t msg)
+        {
+            if (!pmt::is_pair(msg) || !pmt::is_c32vector(pmt::cdr(msg)))
+            {
+                return;
+            }
+
+            pmt::pmt_t meta = pmt::car(msg);
+            if (!pmt::is_dict(meta))
+            {
+                meta = pmt::make_dict();
+            }
+            auto param = [&meta](const char *key, double value) {
+                const pmt::pmt_t v = pmt::dict_ref(meta, pmt::mp(key), pmt::PMT_NIL);
+                return pmt::is_number(v) ? pmt::to_double(v) : value;
+            };
+            const double range = param("range", d_ref_range);
+            const double velocity = param("velocity", 0);
+            const pmt::pmt_t multipath = pmt::dict_ref(meta, pmt::mp("multipath"), pmt::PMT_NIL);
+
+            size_t len;
+            const gr_complex *samples = pmt::c32vector_elements(pmt::cdr(msg), len);
+            size_t ntaps = 0;
+            const gr_complex *taps = nullptr;
+            if (pmt::is_c32vector(multipath))
+            {
+                taps = pmt::c32vector_elements(multipath, ntaps);
+            }
+
+            // Multipath, the burst grows by the delay spread.
+            const size_t n = len + (ntaps ? ntaps - 1 : 0);
+            d_buffer.resize(n);
+            if (ntaps)
+            {
+                std::fill(d_buffer.begin(), d_buffer.end(), gr_complex(0, 0));
+                for (size_t k = 0; k < ntaps; k++)
+                {
+                    if (taps[k] != gr_complex(0, 0))
+                    {
+                        complex_axpy((float *)&d_buffer[k], (const float *)samples, taps[k], len);
+                    }
+                }
+                samples = d_buffer.data();
+            }
+
+            // Path loss and Doppler. The oscillator runs on a 32 bit phase
+            // accumulator, the table is pre-scaled to the path amplitude.
+            const double loss_db = path_loss_db(range);
+            const float amplitude = std::pow(10.0, -loss_db / 20.0);
+            const double doppler = velocity / SPEED_OF_LIGHT * d_carrier_freq;
+            const uint32_t phase_inc = (uint32_t)(int64_t)std::llround(doppler / d_samp_rate * 4294967296.0);
+            if (phase_inc)
+            {
+                volk_32f_s32f_multiply_32f((float *)d_scaled.data(), (const float *)d_osc.data(), amplitude, 2 * d_osc.size());
+                d_rotator.resize(n);
+                uint32_t phase = 0;
+                for (size_t i = 0; i < n; i++)
+                {
+                    d_rotator[i] = d_scaled[phase >> (32 - OSC_BITS)];
+                    phase += phase_inc;
+                }
+                volk_32fc_x2_multiply_32fc(d_buffer.data(), samples, d_rotator.data(), n);
+            }
+            else
+            {
+                volk_32f_s32f_multiply_32f((float *)d_buffer.data(), (const float *)samples, amplitude, 2 * n);
+            }
+
+            // Noise from a random window of the table, wrapping around.
+            if (!d_noise.empty())
+            {
+                size_t pos = std::uniform_int_distribution<size_t>(0, NOISE_SIZE - 1)(d_rng);
+                for (size_t i = 0; i < n;)
+                {
+                    const size_t chunk = std::min(n - i, NOISE_SIZE - pos);
+                    volk_32f_x2_add_32f((float *)&d_buffer[i], (const float *)&d_buffer[i],
+                                        (const float *)&d_noise[pos], 2 * chunk);
+                    i += chunk;
+                    pos = 0;
+                }
+            }
+
+            meta = pmt::dict_add(meta, pmt::mp("path_loss_db"), pmt::from_double(loss_db));
+            message_port_pub(d_out_port, pmt::cons(meta, pmt::init_c32vector(n, d_buffer.data())));
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
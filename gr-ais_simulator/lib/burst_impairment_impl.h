@@ -0,0 +1,74 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_BURST_IMPAIRMENT_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_BURST_IMPAIRMENT_IMPL_H
+
+#include <gnuradio/ais_simulator/burst_impairment.h>
+#include <random>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        class burst_impairment_impl : public burst_impairment
+        {
+        private:
+            // Oscillator table size and phase to index shift for 32 bit phase.
+            static const int OSC_BITS = 12;
+            // Precomputed noise samples, a random window is used per burst.
+            static const size_t NOISE_SIZE = 1 << 16;
+
+            const pmt::pmt_t d_in_port;
+            const pmt::pmt_t d_out_port;
+            const double d_samp_rate;
+            const double d_carrier_freq;
+            const double d_ref_range;
+            const bool d_two_ray;
+            const double d_tx_height;
+            const double d_rx_height;
+            std::mt19937 d_rng;
+            std::vector<gr_complex> d_osc;
+            std::vector<gr_complex> d_scaled;  // d_osc times the path amplitude
+            std::vector<gr_complex> d_rotator;
+            std::vector<gr_complex> d_noise; // Scaled to the reference SNR
+            std::vector<gr_complex> d_buffer;
+
+            double path_loss_db(double range) const;
+            void impair(pmt::pmt_t msg);
+
+        public:
+            burst_impairment_impl(double samp_rate,
+                                  double carrier_freq,
+                                  double ref_range,
+                                  double ref_snr_db,
+                                  bool two_ray,
+                                  double tx_height,
+                                  double rx_height,
+                                  int seed);
+            ~burst_impairment_impl();
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_BURST_IMPAIRMENT_IMPL_H */
@@ -0,0 +1,203 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "burst_mixer_impl.h"
+#include <volk/volk.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        burst_mixer::sptr burst_mixer::make(double samp_rate,
+                                            float power_min_db,
+                                            float power_max_db,
+                                            double freq_offset_max,
+                                            int delay_max,
+                                            int max_active,
+                                            int seed)
+        {
+            return gnuradio::get_initial_sptr(new burst_mixer_impl(
+                samp_rate, power_min_db, power_max_db, freq_offset_max, delay_max, max_active, seed));
+        }
+
+        /*
+         * The private constructor
+         */
+        burst_mixer_impl::burst_mixer_impl(double samp_rate,
+                                           float power_min_db,
+                                           float power_max_db,
+                                           double freq_offset_max,
+                                           int delay_max,
+                                           int max_active,
+                                           int seed)
+            : gr::sync_block("burst_mixer",
+                             gr::io_signature::make(0, 0, 0),
+                             gr::io_signature::make(1, 1, sizeof(gr_complex))),
+              d_bursts_port(pmt::mp("bursts")),
+              d_burst_tag(pmt::mp("burst")),
+              d_samp_rate(samp_rate),
+              d_power_min_db(power_min_db),
+              d_power_max_db(std::max(power_min_db, power_max_db)),
+              d_freq_offset_max(std::fabs(freq_offset_max)),
+              d_delay_max(std::max(delay_max, 0)),
+              d_max_active(max_active),
+              d_rng(seed)
+        {
+            if (samp_rate <= 0 || max_active < 1)
+            {
+                throw std::invalid_argument("burst_mixer: Invalid sample rate or burst count");
+            }
+            d_active.reserve(max_active);
+            message_port_register_in(d_bursts_port);
+            set_msg_handler(d_bursts_port, [this](pmt::pmt_t msg) { this->add_burst(msg); });
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        burst_mixer_impl::~burst_mixer_impl() {}
+
+        /*
+         * Take a burst PDU, fix its parameters and queue it for work(). The
+         * amplitude is applied once here, the rotation while mixing.
+         */
+        void burst_mixer_impl::add_burst(pmt::pmt_t msg)
+        {
+            if (!pmt::is_pair(msg) || !pmt::is_c32vector(pmt::cdr(msg)))
+            {
+                return;
+            }
+            if (d_count >= d_max_active)
+            {
+                d_dropped++;
+                return;
+            }
+
+            const pmt::pmt_t meta = pmt::car(msg);
+            auto param = [&meta](const char *key, double value) {
+                const pmt::pmt_t v = pmt::is_dict(meta) ? pmt::dict_ref(meta, pmt::mp(key), pmt::PMT_NIL)
+                                                       : pmt::PMT_NIL;
+                return pmt::is_number(v) ? pmt::to_double(v) : value;
+            };
+            const double power_db = param(
+                "power_db", std::uniform_real_distribution<double>(d_power_min_db, d_power_max_db)(d_rng));
+            const double freq_offset = param(
+                "freq_offset",
+                std::uniform_real_distribution<double>(-d_freq_offset_max, d_freq_offset_max)(d_rng));
+            const int delay = std::max(
+                0, (int)param("delay", std::uniform_int_distribution<int>(0, d_delay_max)(d_rng)));
+
+            size_t len;
+            const gr_complex *samples = pmt::c32vector_elements(pmt::cdr(msg), len);
+            burst b;
+            b.samples.resize(len);
+            const float amplitude = std::pow(10.0, power_db / 20.0);
+            volk_32f_s32f_multiply_32f((float *)b.samples.data(), (const float *)samples, amplitude, 2 * len);
+            b.start = 0;
+            b.pos = 0;
+            b.phase = gr_complex(1, 0);
+            b.phase_inc = std::polar(1.0f, (float)(2 * M_PI * freq_offset / d_samp_rate));
+            b.delay = delay;
+            b.tag = pmt::make_dict();
+            b.tag = pmt::dict_add(b.tag, pmt::mp("power_db"), pmt::from_double(power_db));
+            b.tag = pmt::dict_add(b.tag, pmt::mp("freq_offset"), pmt::from_double(freq_offset));
+            b.tag = pmt::dict_add(b.tag, pmt::mp("length"), pmt::from_long(len));
+
+            d_count++;
+            std::lock_guard<std::mutex> lock(d_pending_mutex);
+            d_pending.push_back(std::move(b));
+        }
+
+        int burst_mixer_impl::work(int noutput_items,
+                                   gr_vector_const_void_star &input_items,
+                                   gr_vector_void_star &output_items)
+        {
+            gr_complex *out = (gr_complex *)output_items[0];
+            const uint64_t n0 = nitems_written(0);
+            const uint64_t n1 = n0 + noutput_items;
+
+            {
+                std::lock_guard<std::mutex> lock(d_pending_mutex);
+                for (burst &b : d_pending)
+                {
+                    b.start = n0 + b.delay;
+                    d_active.push_back(std::move(b));
+                }
+                d_pending.clear();
+            }
+
+            std::fill_n(out, noutput_items, gr_complex(0, 0));
+            if (d_scratch.size() < (size_t)noutput_items)
+            {
+                d_scratch.resize(noutput_items);
+            }
+
+            for (size_t i = 0; i < d_active.size();)
+            {
+                burst &b = d_active[i];
+                if (b.start >= n1)
+                {
+                    i++;
+                    continue;
+                }
+                if (b.pos == 0)
+                {
+                    add_item_tag(0, b.start, d_burst_tag, b.tag);
+                }
+
+                // Multiply-accumulate the part of the burst within this output.
+                const uint64_t offset = b.start + b.pos - n0;
+                const unsigned n = std::min<uint64_t>(n1 - (n0 + offset), b.samples.size() - b.pos);
+                const gr_complex *src = &b.samples[b.pos];
+                if (b.phase_inc != gr_complex(1, 0))
+                {
+                    volk_32fc_s32fc_x2_rotator2_32fc(d_scratch.data(), src, &b.phase_inc, &b.phase, n);
+                    src = d_scratch.data();
+                }
+                volk_32f_x2_add_32f((float *)(out + offset), (const float *)(out + offset), (const float *)src, 2 * n);
+                b.pos += n;
+
+                if (b.pos == b.samples.size())
+                {
+                    d_active[i] = std::move(d_active.back());
+                    d_active.pop_back();
+                    d_count--;
+                }
+                else
+                {
+                    i++;
+                }
+            }
+
+            return noutput_items;
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
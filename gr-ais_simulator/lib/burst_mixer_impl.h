@@ -0,0 +1,88 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_BURST_MIXER_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_BURST_MIXER_IMPL_H
+
+#include <gnuradio/ais_simulator/burst_mixer.h>
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        class burst_mixer_impl : public burst_mixer
+        {
+        private:
+            struct burst {
+                std::vector<gr_complex> samples; // Scaled by amplitude
+                uint64_t start;                  // Absolute output sample
+                size_t pos;                      // Next sample to mix
+                gr_complex phase;
+                gr_complex phase_inc;
+                int delay;
+                pmt::pmt_t tag; // Power, offset and length for the output tag
+            };
+
+            const pmt::pmt_t d_bursts_port;
+            const pmt::pmt_t d_burst_tag;
+            const double d_samp_rate;
+            const float d_power_min_db;
+            const float d_power_max_db;
+            const double d_freq_offset_max;
+            const int d_delay_max;
+            const size_t d_max_active;
+            std::mt19937 d_rng;
+            // Bursts from the message handler, moved to d_active by work().
+            std::mutex d_pending_mutex;
+            std::vector<burst> d_pending;
+            // Only bursts overlapping the output, the rest costs nothing.
+            std::vector<burst> d_active;
+            std::vector<gr_complex> d_scratch;
+            std::atomic<size_t> d_count{ 0 }; // Pending plus active
+            std::atomic<uint64_t> d_dropped{ 0 };
+
+            void add_burst(pmt::pmt_t msg);
+
+        public:
+            burst_mixer_impl(double samp_rate,
+                             float power_min_db,
+                             float power_max_db,
+                             double freq_offset_max,
+                             int delay_max,
+                             int max_active,
+                             int seed);
+            ~burst_mixer_impl();
+
+            uint64_t dropped() const { return d_dropped; }
+
+            int work(int noutput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_BURST_MIXER_IMPL_H */
@@ -0,0 +1,230 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "burst_modulator_impl.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        burst_modulator::sptr burst_modulator::make(int samples_per_symbol,
+                                                    double bt,
+                                                    frame_format format,
+                                                    int cache_mb,
+                                                    const std::string &len_tag_key)
+        {
+            return gnuradio::get_initial_sptr(
+                new burst_modulator_impl(samples_per_symbol, bt, format, cache_mb, len_tag_key));
+        }
+
+        /*
+         * The private constructor
+         */
+        burst_modulator_impl::burst_modulator_impl(int samples_per_symbol,
+                                                   double bt,
+                                                   frame_format format,
+                                                   int cache_mb,
+                                                   const std::string &len_tag_key)
+            : gr::block("burst_modulator",
+                        gr::io_signature::make(1, 1, sizeof(char)),
+                        gr::io_signature::make(1, 1, sizeof(gr_complex))),
+              d_sps(samples_per_symbol),
+              d_format(format),
+              d_len_tag_key(pmt::string_to_symbol(len_tag_key)),
+              d_cache((size_t)std::max(cache_mb, 0) << 20)
+        {
+            if (samples_per_symbol < 1 || !(bt > 0) || cache_mb < 0 || format == FRAME_NRZ)
+            {
+                throw std::invalid_argument(
+                    "burst_modulator: Invalid samples per symbol, BT, cache size or input format");
+            }
+            set_tag_propagation_policy(TPP_DONT);
+
+            // Gaussian filter over four symbols as firdes::gaussian(), times
+            // a one symbol rectangle, like GMSK Mod. The sensitivity gives a
+            // phase change of pi/2 per symbol.
+            const int ntaps = 4 * d_sps;
+            std::vector<double> gaussian(ntaps);
+            const double s = 2 * M_PI * bt / std::sqrt(std::log(2.0));
+            double sum = 0;
+            for (int i = 0; i < ntaps; i++)
+            {
+                const double t = s * (i + 1 - 0.5 * ntaps) / d_sps;
+                gaussian[i] = std::exp(-0.5 * t * t);
+                sum += gaussian[i];
+            }
+            const double sensitivity = (M_PI / 2) / d_sps;
+            d_pulse.assign(ntaps + d_sps - 1, 0);
+            for (int i = 0; i < ntaps; i++)
+            {
+                for (int j = 0; j < d_sps; j++)
+                {
+                    d_pulse[i + j] += gaussian[i] / sum * sensitivity;
+                }
+            }
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        burst_modulator_impl::~burst_modulator_impl() {}
+
+        void burst_modulator_impl::forecast(int noutput_items, gr_vector_int &ninput_items_required)
+        {
+            // A burst in progress needs no input.
+            ninput_items_required[0] = d_burst ? 0 : 1;
+        }
+
+        /*
+         * Modulate one frame into a new burst: sum the frequency pulses of
+         * the +/-1 symbols, integrate to phase.
+         */
+        burst_cache<gr_complex>::burst_ptr burst_modulator_impl::modulate(const uint8_t *frame, int len)
+        {
+            const int bits = d_format == FRAME_PACKED ? 8 * len : len;
+            const size_t pulse_len = d_pulse.size();
+            d_freq.assign((size_t)bits * d_sps + pulse_len - 1, 0);
+            for (int k = 0; k < bits; k++)
+            {
+                const bool one = d_format == FRAME_PACKED ? (frame[k >> 3] >> (7 - (k & 7))) & 1 : frame[k] & 1;
+                const float sign = one ? 1.0f : -1.0f;
+                float *f = &d_freq[(size_t)k * d_sps];
+                for (size_t i = 0; i < pulse_len; i++)
+                {
+                    f[i] += sign * d_pulse[i];
+                }
+            }
+
+            auto burst = std::make_shared<std::vector<gr_complex>>(d_freq.size());
+            double phase = 0;
+            for (size_t i = 0; i < d_freq.size(); i++)
+            {
+                phase += d_freq[i];
+                phase += phase > M_PI ? -2 * M_PI : phase < -M_PI ? 2 * M_PI : 0;
+                (*burst)[i] = gr_complex(std::cos(phase), std::sin(phase));
+            }
+            return burst;
+        }
+
+        int burst_modulator_impl::general_work(int noutput_items,
+                                               gr_vector_int &ninput_items,
+                                               gr_vector_const_void_star &input_items,
+                                               gr_vector_void_star &output_items)
+        {
+            const uint8_t *in = (const uint8_t *)input_items[0];
+            gr_complex *out = (gr_complex *)output_items[0];
+            const uint64_t nread = nitems_read(0);
+            int consumed = 0;
+            int produced = 0;
+            bool tags_read = false;
+            size_t next_tag = 0;
+
+            while (produced < noutput_items)
+            {
+                if (!d_burst)
+                {
+                    // Next frame, only once it is complete in the input.
+                    if (!tags_read)
+                    {
+                        get_tags_in_range(d_tags, 0, nread, nread + ninput_items[0], d_len_tag_key);
+                        tags_read = true;
+                    }
+                    while (next_tag < d_tags.size() && d_tags[next_tag].offset < nread + consumed)
+                    {
+                        next_tag++;
+                    }
+                    if (next_tag == d_tags.size())
+                    {
+                        // Nothing but untagged items left, drop them.
+                        consumed = ninput_items[0];
+                        break;
+                    }
+                    const tag_t &tag = d_tags[next_tag];
+                    const int start = (int)(tag.offset - nread);
+                    const long len = pmt::to_long(tag.value);
+                    if (len <= 0 || len > (d_format == FRAME_PACKED ? FRAME_MAX : FRAME_MAX * 8))
+                    {
+                        // Not a frame, its items are dropped with the next one.
+                        next_tag++;
+                        continue;
+                    }
+                    if (start + len > ninput_items[0])
+                    {
+                        consumed = start;
+                        break;
+                    }
+
+                    const std::string_view key((const char *)in + start, len);
+                    d_burst = d_cache.find(key);
+                    if (d_burst)
+                    {
+                        d_hits++;
+                    }
+                    else
+                    {
+                        d_burst = modulate(in + start, len);
+                        d_cache.insert(key, d_burst);
+                        d_cached_bytes = d_cache.bytes();
+                        d_misses++;
+                    }
+                    d_pos = 0;
+
+                    const uint64_t offset = nitems_written(0) + produced;
+                    add_item_tag(0, offset, d_len_tag_key, pmt::from_long(d_burst->size()));
+                    get_tags_in_range(d_start_tags, 0, tag.offset, tag.offset + 1);
+                    for (const tag_t &t : d_start_tags)
+                    {
+                        if (!pmt::eqv(t.key, d_len_tag_key))
+                        {
+                            add_item_tag(0, offset, t.key, t.value, t.srcid);
+                        }
+                    }
+                    consumed = start + len;
+                }
+
+                // Copy as much of the burst as fits.
+                const size_t n = std::min(d_burst->size() - d_pos, (size_t)(noutput_items - produced));
+                std::memcpy(out + produced, d_burst->data() + d_pos, n * sizeof(gr_complex));
+                d_pos += n;
+                produced += n;
+                if (d_pos == d_burst->size())
+                {
+                    d_burst.reset();
+                }
+            }
+
+            consume_each(consumed);
+            return produced;
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
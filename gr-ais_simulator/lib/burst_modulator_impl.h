@@ -0,0 +1,84 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_BURST_MODULATOR_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_BURST_MODULATOR_IMPL_H
+
+#include <gnuradio/ais_simulator/burst_modulator.h>
+#include "burst_cache.h"
+#include "frame_builder.h"
+#include <atomic>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        class burst_modulator_impl : public burst_modulator
+        {
+        private:
+            // Largest frame, packed bytes.
+            static const int FRAME_MAX = framing::frame_bytes_max(framing::LEN_PAYLOAD_MAX);
+
+            const int d_sps;
+            const frame_format d_format;
+            const pmt::pmt_t d_len_tag_key;
+            // Frequency pulse of one symbol, phase increment per sample.
+            std::vector<float> d_pulse;
+            std::vector<float> d_freq;
+            burst_cache<gr_complex> d_cache;
+            std::atomic<uint64_t> d_hits{ 0 };
+            std::atomic<uint64_t> d_misses{ 0 };
+            std::atomic<uint64_t> d_cached_bytes{ 0 };
+
+            // Burst being streamed and samples of it already written.
+            burst_cache<gr_complex>::burst_ptr d_burst;
+            size_t d_pos = 0;
+            std::vector<tag_t> d_tags;
+            std::vector<tag_t> d_start_tags;
+
+            burst_cache<gr_complex>::burst_ptr modulate(const uint8_t *frame, int len);
+
+        public:
+            burst_modulator_impl(int samples_per_symbol,
+                                 double bt,
+                                 frame_format format,
+                                 int cache_mb,
+                                 const std::string &len_tag_key);
+            ~burst_modulator_impl();
+
+            uint64_t hits() const { return d_hits; }
+            uint64_t misses() const { return d_misses; }
+            uint64_t cached_bytes() const { return d_cached_bytes; }
+
+            void forecast(int noutput_items, gr_vector_int &ninput_items_required);
+
+            int general_work(int noutput_items,
+                             gr_vector_int &ninput_items,
+                             gr_vector_const_void_star &input_items,
+                             gr_vector_void_star &output_items);
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_BURST_MODULATOR_IMPL_H */
@@ -0,0 +1,192 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/ais_simulator/framing.h>
+#include "batch_encoder.h"
+#include "frame_builder.h"
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        namespace
+        {
+            // Payloads packed per batch_encoder call, bounds the scratch buffer.
+            const long PACK_ROWS = 16 * framing::batch_encoder::LANES;
+
+            /*
+             * Encode rows [first, last), batching runs of equal length.
+             */
+            void encode_rows(const uint8_t *bits,
+                             long bits_stride,
+                             const int32_t *lengths,
+                             long first,
+                             long last,
+                             bool enable_nrzi,
+                             uint8_t *out,
+                             long out_stride,
+                             int32_t *out_len)
+            {
+                std::vector<uint8_t> payloads;
+                std::vector<int> frame_len;
+                long i = first;
+                while (i < last)
+                {
+                    const int len_bits = lengths[i];
+                    long end = i + 1;
+                    while (end < last && end - i < PACK_ROWS && lengths[end] == len_bits)
+                    {
+                        end++;
+                    }
+                    const long n = end - i;
+                    if (len_bits == 0)
+                    {
+                        std::fill(out_len + i, out_len + end, 0);
+                        i = end;
+                        continue;
+                    }
+
+                    // Pack bits MSB first and zero pad to full bytes, as
+                    // framing::pack_sentence does.
+                    const int len = (len_bits + 7) / 8;
+                    payloads.assign(n * len, 0);
+                    for (long r = 0; r < n; r++)
+                    {
+                        const uint8_t *b = bits + (i + r) * bits_stride;
+                        uint8_t *p = &payloads[r * len];
+                        for (int k = 0; k < len_bits; k++)
+                        {
+                            p[k >> 3] |= (b[k] & 1) << (7 - (k & 7));
+                        }
+                    }
+                    frame_len.resize(n);
+                    framing::batch_encoder::encode(payloads.data(),
+                                                   len,
+                                                   n,
+                                                   len,
+                                                   enable_nrzi,
+                                                   out + i * out_stride,
+                                                   out_stride,
+                                                   frame_len.data());
+                    std::copy(frame_len.begin(), frame_len.end(), out_len + i);
+                    i = end;
+                }
+            }
+
+            // Joins the workers however encode_frames() is left.
+            struct join_guard {
+                std::vector<std::thread> &workers;
+
+                ~join_guard()
+                {
+                    for (auto &w : workers)
+                    {
+                        w.join();
+                    }
+                }
+            };
+        } // namespace
+
+        int max_frame_bytes(int len_bits)
+        {
+            return framing::frame_bytes_max(std::min(std::max(len_bits, 0), framing::LEN_PAYLOAD_MAX));
+        }
+
+        void encode_frames(const uint8_t *bits,
+                           long bits_stride,
+                           const int32_t *lengths,
+                           long n,
+                           bool enable_nrzi,
+                           uint8_t *out,
+                           long out_stride,
+                           int32_t *out_len,
+                           int threads)
+        {
+            for (long i = 0; i < n; i++)
+            {
+                if (lengths[i] < 0 || lengths[i] > framing::LEN_PAYLOAD_MAX)
+                {
+                    throw std::invalid_argument("encode_frames: Payload length out of range");
+                }
+                if (max_frame_bytes(lengths[i]) > out_stride)
+                {
+                    throw std::invalid_argument("encode_frames: Output rows too short");
+                }
+            }
+
+            if (threads <= 0)
+            {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+            // Whole lane groups per thread, no thread for less than one group.
+            const long lanes = framing::batch_encoder::LANES;
+            const long groups = (n + lanes - 1) / lanes;
+            threads = (int)std::min<long>(threads, std::max(groups, 1L));
+            const long chunk = (groups + threads - 1) / threads * lanes;
+
+            // Worker failures are passed on to the caller after the join.
+            std::vector<std::exception_ptr> errors(threads);
+            std::vector<std::thread> workers;
+            {
+                join_guard guard{ workers };
+                for (int t = 1; t < threads; t++)
+                {
+                    const long first = t * chunk;
+                    const long last = std::min(n, first + chunk);
+                    if (first >= last)
+                    {
+                        break;
+                    }
+                    workers.emplace_back([=, &errors] {
+                        try
+                        {
+                            encode_rows(bits, bits_stride, lengths, first, last, enable_nrzi, out,
+                                        out_stride, out_len);
+                        }
+                        catch (...)
+                        {
+                            errors[t] = std::current_exception();
+                        }
+                    });
+                }
+                encode_rows(bits, bits_stride, lengths, 0, std::min(n, chunk), enable_nrzi, out, out_stride, out_len);
+            }
+            for (auto &e : errors)
+            {
+                if (e)
+                {
+                    std::rethrow_exception(e);
+                }
+            }
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
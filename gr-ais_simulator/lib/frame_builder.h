@@ -0,0 +1,448 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_FRAME_BUILDER_H
+#define INCLUDED_AIS_SIMULATOR_FRAME_BUILDER_H
+
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        namespace framing
+        {
+            constexpr int LEN_PREAMBLE = 24;
+            constexpr int LEN_START = 8;
+            constexpr int LEN_CRC = 16;
+            constexpr int LEN_FRAME_MAX = 256;    // One slot
+            constexpr int LEN_SLOT_PAYLOAD = 168; // Largest payload fitting in one slot
+            constexpr int LEN_BUFFER = 4096;
+            constexpr int LEN_PAYLOAD_MAX = LEN_BUFFER - LEN_CRC - LEN_PREAMBLE - LEN_START;
+
+            // PREAMBLE_MARK 101010101010101010101010 (24 bits)
+            constexpr uint32_t PREAMBLE = 0xAAAAAA;
+            // START_MARK 01111110 (8 bits)
+            constexpr uint8_t START_MARK = 0x7E;
+
+            /*
+             * Worst case frame size in bytes for a payload of given bit length,
+             * assuming a stuffing bit after every fifth data bit.
+             */
+            constexpr int frame_bytes_max(int len_payload)
+            {
+                int len_data = ((len_payload + 7) & ~7) + LEN_CRC;
+                int len_frame = LEN_PREAMBLE + LEN_START * 2 + len_data + len_data / 5;
+                len_frame = (len_frame + 7) & ~7;
+                return len_frame < LEN_FRAME_MAX ? LEN_FRAME_MAX / 8 : len_frame / 8;
+            }
+
+            /*
+             * CRC-16/ITU (X.25) lookup table, reflected polynom 0x8408.
+             */
+            constexpr std::array<uint16_t, 256> make_crc_itu16_table()
+            {
+                std::array<uint16_t, 256> table{};
+                for (int i = 0; i < 256; i++)
+                {
+                    uint16_t crc = static_cast<uint16_t>(i);
+                    for (int b = 0; b < 8; b++)
+                    {
+                        crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+                    }
+                    table[i] = crc;
+                }
+                return table;
+            }
+
+            /*
+             * NRZI lookup table for MSB first packed bytes. Index is previous
+             * line state * 256 + NRZ byte. A zero bit toggles the line state,
+             * a one bit keeps it. The new line state is the LSB of the result.
+             */
+            constexpr std::array<uint8_t, 512> make_nrzi_table()
+            {
+                std::array<uint8_t, 512> table{};
+                for (int state = 0; state < 2; state++)
+                {
+                    for (int nrz = 0; nrz < 256; nrz++)
+                    {
+                        int level = state;
+                        int nrzi = 0;
+                        for (int b = 7; b >= 0; b--)
+                        {
+                            if (((nrz >> b) & 1) == 0)
+                            {
+                                level ^= 1;
+                            }
+                            nrzi |= level << b;
+                        }
+                        table[state * 256 + nrz] = static_cast<uint8_t>(nrzi);
+                    }
+                }
+                return table;
+            }
+
+            constexpr std::array<uint16_t, 256> crc_itu16_table = make_crc_itu16_table();
+            constexpr std::array<uint8_t, 512> nrzi_table = make_nrzi_table();
+
+            static_assert(crc_itu16_table[1] == 0x1189 && crc_itu16_table[255] == 0x0F78,
+                          "Unexpected CRC-16/ITU table");
+
+            /*
+             * Preamble and start mark as packed bytes, NRZ or NRZI encoded.
+             * NRZI line state is zero before the first bit.
+             */
+            template <bool NRZI>
+            constexpr std::array<uint8_t, 4> make_header()
+            {
+                std::array<uint8_t, 4> header = { static_cast<uint8_t>(PREAMBLE >> 16),
+                                                  static_cast<uint8_t>(PREAMBLE >> 8),
+                                                  static_cast<uint8_t>(PREAMBLE),
+                                                  START_MARK };
+                if (NRZI)
+                {
+                    int state = 0;
+                    for (auto &b : header)
+                    {
+                        b = nrzi_table[state * 256 + b];
+                        state = b & 1;
+                    }
+                }
+                return header;
+            }
+
+            template <bool NRZI>
+            constexpr std::array<uint8_t, 4> header = make_header<NRZI>();
+
+            /*
+             * Calculates CRC-16/ITU checksum from packed data.
+             */
+            inline uint16_t crc16(const uint8_t *data, int len)
+            {
+                uint16_t crc = 0xffff;
+                for (int i = 0; i < len; i++)
+                {
+                    crc = (crc >> 8) ^ crc_itu16_table[(crc ^ data[i]) & 0xff];
+                }
+                return crc ^ 0xffff;
+            }
+
+            /*
+             * Bit stuffing lookup table. Index is the number of consecutive ones
+             * sent so far (0..4) * 256 + byte. Bit 7 is set when the byte, sent
+             * LSB first, needs a stuffing bit. Bits 0..2 hold the number of
+             * consecutive ones after the byte otherwise.
+             */
+            constexpr std::array<uint8_t, 5 * 256> make_stuff_table()
+            {
+                std::array<uint8_t, 5 * 256> table{};
+                for (int ones = 0; ones < 5; ones++)
+                {
+                    for (int byte = 0; byte < 256; byte++)
+                    {
+                        int run = ones;
+                        uint8_t entry = 0;
+                        for (int b = 0; b < 8; b++)
+                        {
+                            run = ((byte >> b) & 1) ? run + 1 : 0;
+                            if (run == 5)
+                            {
+                                entry = 0x80;
+                            }
+                        }
+                        table[ones * 256 + byte] = entry ? entry : static_cast<uint8_t>(run);
+                    }
+                }
+                return table;
+            }
+
+            constexpr std::array<uint8_t, 256> make_reverse_table()
+            {
+                std::array<uint8_t, 256> table{};
+                for (int byte = 0; byte < 256; byte++)
+                {
+                    int r = 0;
+                    for (int b = 0; b < 8; b++)
+                    {
+                        r |= ((byte >> b) & 1) << (7 - b);
+                    }
+                    table[byte] = static_cast<uint8_t>(r);
+                }
+                return table;
+            }
+
+            constexpr std::array<uint8_t, 5 * 256> stuff_table = make_stuff_table();
+            constexpr std::array<uint8_t, 256> reverse_table = make_reverse_table();
+
+            /*
+             * Number of stuffing bits build_frame() inserts into payload and
+             * CRC, without building the frame.
+             */
+            inline int stuffing_bits(const uint8_t *payload, int len, uint16_t crc)
+            {
+                int ones = 0;
+                int stuffed = 0;
+                auto count = [&ones, &stuffed](uint8_t byte) {
+                    const uint8_t entry = stuff_table[ones * 256 + byte];
+                    if (!(entry & 0x80))
+                    {
+                        ones = entry;
+                        return;
+                    }
+                    for (int b = 0; b < 8; b++)
+                    {
+                        ones = ((byte >> b) & 1) ? ones + 1 : 0;
+                        if (ones == 5)
+                        {
+                            stuffed++;
+                            ones = 0;
+                        }
+                    }
+                };
+                for (int i = 0; i < len; i++)
+                {
+                    count(payload[i]);
+                }
+                count(static_cast<uint8_t>(crc));
+                count(static_cast<uint8_t>(crc >> 8));
+                return stuffed;
+            }
+
+            /*
+             * Bit stuffing writer. Inserts a zero bit after five consecutive ones
+             * and packs the resulting bit stream MSB first.
+             */
+            class stuffing_writer
+            {
+            private:
+                uint8_t *d_out;
+                int d_len = 0;
+                uint64_t d_acc = 0;
+                int d_bits = 0;
+                int d_ones = 0;
+
+                void put(unsigned value, int n)
+                {
+                    d_acc = (d_acc << n) | value;
+                    d_bits += n;
+                    while (d_bits >= 8)
+                    {
+                        d_bits -= 8;
+                        d_out[d_len++] = static_cast<uint8_t>(d_acc >> d_bits);
+                    }
+                }
+
+            public:
+                explicit stuffing_writer(uint8_t *out) : d_out(out) {}
+
+                // Write one byte LSB first, as sent on air.
+                void put_stuffed(uint8_t byte)
+                {
+                    const uint8_t entry = stuff_table[d_ones * 256 + byte];
+                    if (!(entry & 0x80))
+                    {
+                        // No stuffing within this byte, write it at once.
+                        put(reverse_table[byte], 8);
+                        d_ones = entry;
+                        return;
+                    }
+                    for (int b = 0; b < 8; b++)
+                    {
+                        unsigned bit = (byte >> b) & 1;
+                        put(bit, 1);
+                        d_ones = bit ? d_ones + 1 : 0;
+                        if (d_ones == 5)
+                        {
+                            put(0, 1);
+                            d_ones = 0;
+                        }
+                    }
+                }
+
+                // Write one byte MSB first without stuffing.
+                void put_raw(uint8_t byte) { put(byte, 8); }
+
+                // Pad with zero bits to the next byte boundary, return length in bytes.
+                int flush()
+                {
+                    if (d_bits != 0)
+                    {
+                        put(0, 8 - d_bits);
+                    }
+                    return d_len;
+                }
+            };
+
+            /*
+             * Build a complete AIS frame from packed payload bytes and its CRC.
+             *
+             * Frame layout: preamble, start mark, stuffed payload and CRC (sent
+             * LSB first per byte), end mark. Single slot frames are zero padded to
+             * 256 bits, multi slot frames to the next byte boundary. Output is MSB
+             * first packed, out must hold frame_bytes_max(len * 8) bytes.
+             *
+             * Returns the frame length in bytes.
+             */
+            template <bool NRZI, bool SINGLE_SLOT>
+            int build_frame(const uint8_t *payload, int len, uint16_t crc, uint8_t *out)
+            {
+                constexpr auto &hdr = header<NRZI>;
+
+                for (int i = 0; i < 4; i++)
+                {
+                    out[i] = hdr[i];
+                }
+
+                stuffing_writer writer(out + 4);
+                for (int i = 0; i < len; i++)
+                {
+                    writer.put_stuffed(payload[i]);
+                }
+                writer.put_stuffed(static_cast<uint8_t>(crc));
+                writer.put_stuffed(static_cast<uint8_t>(crc >> 8));
+                writer.put_raw(START_MARK);
+                int len_frame = 4 + writer.flush();
+
+                if constexpr (SINGLE_SLOT)
+                {
+                    for (; len_frame < LEN_FRAME_MAX / 8; len_frame++)
+                    {
+                        out[len_frame] = 0;
+                    }
+                }
+
+                if constexpr (NRZI)
+                {
+                    int state = hdr[3] & 1;
+                    for (int i = 4; i < len_frame; i++)
+                    {
+                        out[i] = nrzi_table[state * 256 + out[i]];
+                        state = out[i] & 1;
+                    }
+                }
+                return len_frame;
+            }
+
+            template <bool NRZI, bool SINGLE_SLOT>
+            int build_frame(const uint8_t *payload, int len, uint8_t *out)
+            {
+                return build_frame<NRZI, SINGLE_SLOT>(payload, len, crc16(payload, len), out);
+            }
+
+            /*
+             * Pack an ASCII bit string ("0101...") MSB first into payload bytes.
+             * The sentence ends at the first new line or null character, the
+             * payload is zero padded to a multiple of 8 bits and limited to
+             * LEN_PAYLOAD_MAX bits.
+             *
+             * Returns the padded payload length in bits, zero on empty input.
+             */
+            inline int pack_sentence(const char *sentence, long length, uint8_t *payload)
+            {
+                int len = length > LEN_PAYLOAD_MAX ? LEN_PAYLOAD_MAX : (int)length;
+                if (len > 1)
+                {
+                    for (int l = 0; l < len; l++)
+                    {
+                        if (sentence[l] == '\n' || sentence[l] == '\0')
+                        {
+                            len = l;
+                            break;
+                        }
+                    }
+                }
+                if (len <= 0)
+                {
+                    return 0;
+                }
+
+                const int len_bytes = (len + 7) / 8;
+                for (int i = 0; i < len_bytes; i++)
+                {
+                    unsigned byte = 0;
+                    for (int b = 0; b < 8; b++)
+                    {
+                        const int l = i * 8 + b;
+                        byte = (byte << 1) | (l < len ? (sentence[l] & 0x01) : 0);
+                    }
+                    payload[i] = static_cast<uint8_t>(byte);
+                }
+                return len_bytes * 8;
+            }
+
+            /*
+             * Build a frame straight from an ASCII bit string, out must hold
+             * frame_bytes_max(length) bytes. Returns the frame length in bytes,
+             * zero on empty input.
+             */
+            template <bool NRZI>
+            int encode_sentence(const char *sentence, long length, uint8_t *out)
+            {
+                uint8_t payload[LEN_BUFFER / 8];
+                const int len = pack_sentence(sentence, length, payload);
+                if (len == 0)
+                {
+                    return 0;
+                }
+                if (len <= LEN_SLOT_PAYLOAD)
+                {
+                    return build_frame<NRZI, true>(payload, len / 8, out);
+                }
+                return build_frame<NRZI, false>(payload, len / 8, out);
+            }
+
+            /*
+             * Expand a packed frame into one item per bit, MSB first, as 0/1
+             * bytes or as NRZ floats with a one at +1.0. Runs back to front,
+             * so out may start at frame for expanding in place.
+             *
+             * Returns the number of items, len * 8.
+             */
+            template <typename T>
+            int unpack_frame(const uint8_t *frame, int len, T *out)
+            {
+                for (int i = len - 1; i >= 0; i--)
+                {
+                    const unsigned byte = frame[i];
+                    T *o = out + i * 8;
+                    for (int b = 0; b < 8; b++)
+                    {
+                        const unsigned bit = (byte >> (7 - b)) & 1;
+                        if constexpr (std::is_floating_point<T>::value)
+                        {
+                            o[b] = bit ? T(1) : T(-1);
+                        }
+                        else
+                        {
+                            o[b] = static_cast<T>(bit);
+                        }
+                    }
+                }
+                return len * 8;
+            }
+
+        } // namespace framing
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_FRAME_BUILDER_H */
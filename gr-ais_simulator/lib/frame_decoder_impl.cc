@@ -0,0 +1,152 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include <gnuradio/math.h>
+#include "frame_decoder_impl.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        frame_decoder::sptr frame_decoder::make(double samp_rate, double baud_rate)
+        {
+            return gnuradio::get_initial_sptr(new frame_decoder_impl(samp_rate, baud_rate));
+        }
+
+        /*
+         * The private constructor
+         */
+        frame_decoder_impl::frame_decoder_impl(double samp_rate, double baud_rate)
+            : gr::sync_block("frame_decoder",
+                             gr::io_signature::make(1, 1, sizeof(gr_complex)),
+                             gr::io_signature::make(0, 0, 0)),
+              d_out_port(pmt::mp("out")),
+              d_decimation(std::max(1, (int)(samp_rate / baud_rate / OVERSAMPLING))),
+              d_clock_step(baud_rate * d_decimation / samp_rate)
+        {
+            if (samp_rate <= 0 || baud_rate <= 0 || samp_rate < 2 * baud_rate)
+            {
+                throw std::invalid_argument("frame_decoder: Need at least two samples per symbol");
+            }
+            message_port_register_out(d_out_port);
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        frame_decoder_impl::~frame_decoder_impl() {}
+
+        /*
+         * One sample after decimation. The FM discriminator output is summed
+         * over each symbol, its sign gives the line level. Frequency zero
+         * crossings mark symbol boundaries and pull the symbol clock.
+         */
+        void frame_decoder_impl::symbol_sample(gr_complex y, uint64_t offset)
+        {
+            const float freq = gr::fast_atan2f(y * std::conj(d_prev));
+            d_prev = y;
+
+            const bool positive = freq > 0;
+            if (positive != d_prev_positive)
+            {
+                // The crossing lies half a sample back, ideally at phase zero.
+                float error = d_clock - d_clock_step / 2;
+                error = error < 0.5f ? error : error - 1;
+                d_clock -= CLOCK_GAIN * error;
+                d_prev_positive = positive;
+            }
+
+            d_freq_sum += freq;
+            d_clock += d_clock_step;
+            if (d_clock < 1)
+            {
+                return;
+            }
+            d_clock -= 1;
+            const unsigned level = d_freq_sum > 0;
+            d_freq_sum = 0;
+
+            d_deframer.push(level, [this, offset](const uint8_t *payload, int len) {
+                std::vector<uint8_t> bits(len * 8);
+                for (int i = 0; i < len * 8; i++)
+                {
+                    bits[i] = '0' + ((payload[i >> 3] >> (7 - (i & 7))) & 1);
+                }
+                pmt::pmt_t meta = pmt::make_dict();
+                meta = pmt::dict_add(meta, pmt::mp("offset"), pmt::from_uint64(offset));
+                message_port_pub(d_out_port, pmt::cons(meta, pmt::init_u8vector(bits.size(), bits.data())));
+            });
+        }
+
+        int frame_decoder_impl::work(int noutput_items,
+                                     gr_vector_const_void_star &input_items,
+                                     gr_vector_void_star &output_items)
+        {
+            const gr_complex *in = (const gr_complex *)input_items[0];
+            const uint64_t n0 = nitems_read(0);
+
+            // Integrate and dump, a boxcar low pass in front of the
+            // discriminator. Split sums keep the adds independent.
+            int i = 0;
+            while (i < noutput_items)
+            {
+                const int n = std::min(d_decimation - d_acc_count, noutput_items - i);
+                float re[2] = { 0, 0 };
+                float im[2] = { 0, 0 };
+                int k = 0;
+                for (; k + 1 < n; k += 2)
+                {
+                    re[0] += in[i + k].real();
+                    im[0] += in[i + k].imag();
+                    re[1] += in[i + k + 1].real();
+                    im[1] += in[i + k + 1].imag();
+                }
+                if (k < n)
+                {
+                    re[0] += in[i + k].real();
+                    im[0] += in[i + k].imag();
+                }
+                d_acc += gr_complex(re[0] + re[1], im[0] + im[1]);
+                d_acc_count += n;
+                i += n;
+                if (d_acc_count == d_decimation)
+                {
+                    symbol_sample(d_acc, n0 + i);
+                    d_acc = 0;
+                    d_acc_count = 0;
+                }
+            }
+
+            d_frames = d_deframer.frames;
+            d_crc_errors = d_deframer.crc_errors;
+            return noutput_items;
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
@@ -0,0 +1,75 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_FRAME_DECODER_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_FRAME_DECODER_IMPL_H
+
+#include <gnuradio/ais_simulator/frame_decoder.h>
+#include "hdlc_deframer.h"
+#include <atomic>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        class frame_decoder_impl : public frame_decoder
+        {
+        private:
+            // Samples per symbol after decimation, before clock recovery.
+            static constexpr int OVERSAMPLING = 8;
+            // Symbol clock correction per transition, fraction of the error.
+            static constexpr float CLOCK_GAIN = 0.1f;
+
+            const pmt::pmt_t d_out_port;
+            const int d_decimation;
+            const float d_clock_step; // Symbols per decimated sample
+
+            // Integrate and dump decimator
+            gr_complex d_acc = 0;
+            int d_acc_count = 0;
+            // Discriminator and symbol clock
+            gr_complex d_prev = 0;
+            bool d_prev_positive = false;
+            float d_clock = 0; // Symbol phase, a bit is decided at 1
+            float d_freq_sum = 0;
+
+            framing::hdlc_deframer d_deframer;
+            std::atomic<uint64_t> d_frames{ 0 };
+            std::atomic<uint64_t> d_crc_errors{ 0 };
+
+            void symbol_sample(gr_complex y, uint64_t offset);
+
+        public:
+            frame_decoder_impl(double samp_rate, double baud_rate);
+            ~frame_decoder_impl();
+
+            uint64_t frames() const { return d_frames; }
+            uint64_t crc_errors() const { return d_crc_errors; }
+
+            int work(int noutput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_FRAME_DECODER_IMPL_H */
@@ -0,0 +1,154 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "bitstring_to_frame_impl.h"
+#include "frame_library_source_impl.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        frame_library_source::sptr frame_library_source::make(const std::string &filename,
+                                                              const std::string &len_tag_key,
+                                                              bool repeat,
+                                                              frame_format format)
+        {
+            return gnuradio::get_initial_sptr(
+                new frame_library_source_impl(filename, len_tag_key, repeat, format));
+        }
+
+        /*
+         * The private constructor
+         */
+        frame_library_source_impl::frame_library_source_impl(const std::string &filename,
+                                                             const std::string &len_tag_key,
+                                                             bool repeat,
+                                                             frame_format format)
+            : gr::sync_block("frame_library_source",
+                             gr::io_signature::make(0, 0, 0),
+                             gr::io_signature::make(1, 1, frame_item_size(format))),
+              d_len_tag_key(pmt::string_to_symbol(len_tag_key)),
+              d_time_key(pmt::mp("time")),
+              d_repeat(repeat),
+              d_format(format),
+              d_item_size(frame_item_size(format)),
+              d_items_per_byte(frame_items_per_byte(format))
+        {
+            if (format < FRAME_PACKED || format > FRAME_NRZ)
+            {
+                throw std::invalid_argument("frame_library_source: Unknown output format");
+            }
+            const int rc = ais_flib_open(&d_lib, filename.c_str());
+            if (rc < 0)
+            {
+                throw std::runtime_error("frame_library_source: Cannot open " + filename + ": " +
+                                         std::strerror(-rc));
+            }
+            // Frames are read once front to back, let the kernel read ahead.
+            madvise((void *)d_lib.header, d_lib.size, MADV_SEQUENTIAL);
+            d_released = d_lib.header->data;
+            // Unpacked formats write whole frame bytes.
+            set_output_multiple(d_items_per_byte);
+            GR_LOG_INFO(d_logger, filename + ": " + std::to_string(d_lib.header->count) + " frames");
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        frame_library_source_impl::~frame_library_source_impl() { ais_flib_close(&d_lib); }
+
+        /*
+         * Drop streamed pages from the mapping, they stay in the page cache
+         * for the next run but no longer count against this process.
+         */
+        void frame_library_source_impl::release(uint64_t offset)
+        {
+            const uint64_t page = sysconf(_SC_PAGESIZE);
+            offset &= ~(page - 1);
+            if (offset >= d_released + RELEASE_STEP)
+            {
+                const uint64_t start = d_released & ~(page - 1);
+                madvise((uint8_t *)d_lib.header + start, offset - start, MADV_DONTNEED);
+                d_released = offset;
+            }
+        }
+
+        int frame_library_source_impl::work(int noutput_items,
+                                            gr_vector_const_void_star &input_items,
+                                            gr_vector_void_star &output_items)
+        {
+            uint8_t *out = (uint8_t *)output_items[0];
+            const uint64_t count = d_lib.header->count;
+            int produced = 0;
+
+            while (produced < noutput_items)
+            {
+                if (d_entry == count)
+                {
+                    if (!d_repeat || count == 0)
+                    {
+                        return produced ? produced : WORK_DONE;
+                    }
+                    d_entry = 0;
+                    d_released = d_lib.header->data;
+                }
+
+                const ais_flib_entry &e = d_lib.entries[d_entry];
+                const uint8_t *frame = ais_flib_frame(&d_lib, &e);
+                if (frame == nullptr)
+                {
+                    GR_LOG_ERROR(d_logger, "Frame outside of data area, library truncated?");
+                    return produced ? produced : WORK_DONE;
+                }
+                if (d_pos == 0)
+                {
+                    const uint64_t offset = nitems_written(0) + produced;
+                    add_item_tag(0, offset, d_len_tag_key, pmt::from_long(e.len * d_items_per_byte));
+                    add_item_tag(0, offset, d_time_key, pmt::from_double(e.time));
+                }
+
+                const int n = std::min<int>(e.len - d_pos, (noutput_items - produced) / d_items_per_byte);
+                format_frame(d_format, frame + d_pos, n, out + produced * d_item_size);
+                produced += n * d_items_per_byte;
+                d_pos += n;
+                if (d_pos == e.len)
+                {
+                    d_pos = 0;
+                    d_entry++;
+                    d_sent++;
+                }
+            }
+
+            release(d_lib.header->data + d_lib.entries[std::min(d_entry, count - 1)].offset);
+            return produced;
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
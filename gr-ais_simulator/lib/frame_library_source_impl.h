@@ -0,0 +1,73 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_FRAME_LIBRARY_SOURCE_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_FRAME_LIBRARY_SOURCE_IMPL_H
+
+#include <gnuradio/ais_simulator/frame_library.h>
+#include <gnuradio/ais_simulator/frame_library_source.h>
+#include <atomic>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        class frame_library_source_impl : public frame_library_source
+        {
+        private:
+            // Streamed frame data is dropped from the mapping in steps of this.
+            static constexpr uint64_t RELEASE_STEP = 16 << 20;
+
+            ais_flib d_lib;
+            const pmt::pmt_t d_len_tag_key;
+            const pmt::pmt_t d_time_key;
+            const bool d_repeat;
+            const frame_format d_format;
+            const size_t d_item_size;
+            const int d_items_per_byte;
+
+            uint64_t d_entry = 0; // Next entry to stream
+            int d_pos = 0;        // Bytes of it already written
+            uint64_t d_released;  // File offset up to which pages were dropped
+            std::atomic<uint64_t> d_sent{ 0 };
+
+            void release(uint64_t offset);
+
+        public:
+            frame_library_source_impl(const std::string &filename,
+                                      const std::string &len_tag_key,
+                                      bool repeat,
+                                      frame_format format);
+            ~frame_library_source_impl();
+
+            uint64_t frames() const { return d_lib.header->count; }
+            uint64_t sent() const { return d_sent; }
+
+            int work(int noutput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_FRAME_LIBRARY_SOURCE_IMPL_H */
@@ -0,0 +1,243 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "frame_tap_impl.h"
+#include "hdlc_deframer.h"
+#include "nmea_encoder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        frame_tap::sptr frame_tap::make(bool enable_nrzi,
+                                        const std::string &len_tag_key,
+                                        double baud_rate,
+                                        char channel,
+                                        int queue_size,
+                                        frame_format format)
+        {
+            return gnuradio::get_initial_sptr(
+                new frame_tap_impl(enable_nrzi, len_tag_key, baud_rate, channel, queue_size, format));
+        }
+
+        /*
+         * The private constructor
+         */
+        frame_tap_impl::frame_tap_impl(bool enable_nrzi,
+                                       const std::string &len_tag_key,
+                                       double baud_rate,
+                                       char channel,
+                                       int queue_size,
+                                       frame_format format)
+            : gr::sync_block("frame_tap",
+                             gr::io_signature::make(1, 1, sizeof(unsigned char)),
+                             gr::io_signature::make(1, 1, sizeof(unsigned char))),
+              d_frames_port(pmt::mp("frames")),
+              d_len_tag_key(pmt::mp(len_tag_key)),
+              d_nrzi(enable_nrzi),
+              d_item_bits(format == FRAME_PACKED ? 8 : 1),
+              d_baud_rate(baud_rate),
+              d_channel(channel),
+              d_queue(std::max(queue_size, 1))
+        {
+            if (baud_rate <= 0 || (format != FRAME_PACKED && format != FRAME_UNPACKED))
+            {
+                throw std::invalid_argument("frame_tap: Invalid baud rate or input format");
+            }
+            message_port_register_out(d_frames_port);
+            d_thread = gr::thread::thread([this] { run(); });
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        frame_tap_impl::~frame_tap_impl()
+        {
+            stop();
+        }
+
+        /*
+         * Stop publisher thread when block stops, queued frames are still
+         * published.
+         */
+        bool frame_tap_impl::stop()
+        {
+            if (d_thread.joinable())
+            {
+                d_stop = true;
+                d_thread.join();
+            }
+            return true;
+        }
+
+        /*
+         * Copy frames aside and pass the stream through.
+         */
+        int frame_tap_impl::work(int noutput_items,
+                                 gr_vector_const_void_star &input_items,
+                                 gr_vector_void_star &output_items)
+        {
+            const uint8_t *in = (const uint8_t *)input_items[0];
+            uint8_t *out = (uint8_t *)output_items[0];
+            const uint64_t n0 = nitems_read(0);
+            std::memcpy(out, in, noutput_items);
+
+            get_tags_in_range(d_tags, 0, n0, n0 + noutput_items, d_len_tag_key);
+            size_t t = 0;
+            int i = 0;
+            while (i < noutput_items)
+            {
+                if (d_remaining == 0)
+                {
+                    // Skip to the next frame start.
+                    if (t == d_tags.size())
+                    {
+                        break;
+                    }
+                    const gr::tag_t &tag = d_tags[t++];
+                    const long len = pmt::to_long(tag.value);
+                    i = tag.offset - n0;
+                    if (len <= 0 || len > (long)FRAME_MAX * 8 / d_item_bits)
+                    {
+                        continue;
+                    }
+                    const double offset = (double)tag.offset * d_item_bits / d_baud_rate;
+                    if (d_start < 0)
+                    {
+                        d_start = std::chrono::duration<double>(
+                                      std::chrono::system_clock::now().time_since_epoch())
+                                      .count() -
+                                  offset;
+                    }
+                    d_frame.time = d_start + offset;
+                    d_frame.len = (len * d_item_bits + 7) / 8;
+                    d_items = len;
+                    d_remaining = len;
+                    if (d_item_bits == 1)
+                    {
+                        std::memset(d_frame.data, 0, d_frame.len);
+                    }
+                }
+
+                const int n = std::min(d_remaining, noutput_items - i);
+                const int first = d_items - d_remaining;
+                if (d_item_bits == 8)
+                {
+                    std::memcpy(d_frame.data + first, in + i, n);
+                }
+                else
+                {
+                    // Pack MSB first, as bitstring_to_frame builds them.
+                    for (int k = 0; k < n; k++)
+                    {
+                        const int b = first + k;
+                        d_frame.data[b >> 3] |= (in[i + k] & 1) << (7 - (b & 7));
+                    }
+                }
+                d_remaining -= n;
+                i += n;
+                if (d_remaining == 0 && !d_queue.push(std::move(d_frame)))
+                {
+                    d_dropped++;
+                }
+            }
+
+            return noutput_items;
+        }
+
+        /*
+         * Publisher thread, polls the queue so the stream thread never has
+         * to signal.
+         */
+        void frame_tap_impl::run()
+        {
+            frame_copy f;
+            for (;;)
+            {
+                if (d_queue.pop(f))
+                {
+                    publish(f);
+                    continue;
+                }
+                if (d_stop)
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        /*
+         * Recover the payload and publish frame, slot, time and sentences.
+         */
+        void frame_tap_impl::publish(const frame_copy &f)
+        {
+            // Frames start with NRZI line state zero. Without NRZI the
+            // deframer gets the line levels NRZI would produce.
+            framing::hdlc_deframer deframer;
+            std::string aivdm;
+            unsigned level = 0;
+            for (int b = 0; b < f.len * 8; b++)
+            {
+                const unsigned bit = (f.data[b >> 3] >> (7 - (b & 7))) & 1;
+                level = d_nrzi ? bit : level ^ !bit;
+                deframer.push(level, [this, &aivdm](const uint8_t *payload, int len) {
+                    encode_aivdm(payload, len * 8, d_channel, d_seq_id, aivdm);
+                    d_seq_id = (d_seq_id + 1) % 10;
+                });
+                if (!aivdm.empty())
+                {
+                    break;
+                }
+            }
+
+            const int slot = (int)(std::fmod(f.time, 60.0) * 2250 / 60);
+            std::vector<uint8_t> record(12 + f.len + aivdm.size());
+            const uint16_t slot16 = slot;
+            const uint16_t len16 = f.len;
+            std::memcpy(&record[0], &f.time, 8);
+            std::memcpy(&record[8], &slot16, 2);
+            std::memcpy(&record[10], &len16, 2);
+            std::memcpy(&record[12], f.data, f.len);
+            std::memcpy(&record[12 + f.len], aivdm.data(), aivdm.size());
+
+            pmt::pmt_t meta = pmt::make_dict();
+            meta = pmt::dict_add(meta, pmt::mp("time"), pmt::from_double(f.time));
+            meta = pmt::dict_add(meta, pmt::mp("slot"), pmt::from_long(slot));
+            meta = pmt::dict_add(meta, pmt::mp("aivdm"), pmt::mp(aivdm));
+            message_port_pub(d_frames_port, pmt::cons(meta, pmt::init_u8vector(record.size(), record.data())));
+            d_frames++;
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
@@ -0,0 +1,92 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_FRAME_TAP_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_FRAME_TAP_IMPL_H
+
+#include <gnuradio/ais_simulator/frame_tap.h>
+#include <gnuradio/thread/thread.h>
+#include "frame_builder.h"
+#include "spsc_ring.h"
+#include <atomic>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        class frame_tap_impl : public frame_tap
+        {
+        private:
+            // Largest frame bitstring_to_frame builds.
+            static const int FRAME_MAX = framing::frame_bytes_max(framing::LEN_PAYLOAD_MAX);
+
+            // Fixed size so the stream thread never allocates.
+            struct frame_copy {
+                double time; // UNIX seconds
+                int len;
+                uint8_t data[FRAME_MAX];
+            };
+
+            const pmt::pmt_t d_frames_port;
+            const pmt::pmt_t d_len_tag_key;
+            const bool d_nrzi;
+            const int d_item_bits; // 8 packed, 1 unpacked
+            const double d_baud_rate;
+            const char d_channel;
+            std::vector<gr::tag_t> d_tags;
+            // Frame being copied, it may span several work() calls.
+            frame_copy d_frame;
+            int d_items = 0;
+            int d_remaining = 0;
+            spsc_ring<frame_copy> d_queue;
+            std::atomic<uint64_t> d_frames{ 0 };
+            std::atomic<uint64_t> d_dropped{ 0 };
+            // Wall clock of stream item zero, set at the first frame.
+            double d_start = -1;
+            int d_seq_id = 0;
+            gr::thread::thread d_thread;
+            std::atomic<bool> d_stop{ false };
+
+            void run();
+            void publish(const frame_copy &f);
+
+        public:
+            frame_tap_impl(bool enable_nrzi,
+                           const std::string &len_tag_key,
+                           double baud_rate,
+                           char channel,
+                           int queue_size,
+                           frame_format format);
+            ~frame_tap_impl();
+
+            uint64_t frames() const { return d_frames; }
+            uint64_t dropped() const { return d_dropped; }
+            bool stop();
+
+            int work(int noutput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_FRAME_TAP_IMPL_H */
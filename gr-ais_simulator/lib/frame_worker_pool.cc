@@ -0,0 +1,194 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "frame_builder.h"
+#include "frame_worker_pool.h"
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        frame_worker_pool::frame_worker_pool(int threads,
+                                             int capacity,
+                                             encode_fn encode,
+                                             std::function<void()> ready)
+            : d_capacity(capacity), d_encode(encode), d_ready(std::move(ready)), d_slots(capacity)
+        {
+            for (int i = 0; i < threads; i++)
+            {
+                d_queues.emplace_back(new worker_queue);
+            }
+            for (int i = 0; i < threads; i++)
+            {
+                d_threads.emplace_back(&frame_worker_pool::run, this, i);
+            }
+        }
+
+        frame_worker_pool::~frame_worker_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(d_work_mutex);
+                d_stop = true;
+            }
+            d_work_cond.notify_all();
+            for (auto &t : d_threads)
+            {
+                t.join();
+            }
+        }
+
+        /*
+         * Distribute sentences round robin over the worker queues.
+         */
+        void frame_worker_pool::submit(const char *sentence, long length)
+        {
+            const uint64_t seq = d_submitted++;
+            worker_queue &q = *d_queues[seq % d_queues.size()];
+            {
+                std::lock_guard<std::mutex> lock(q.mutex);
+                q.jobs.push_back(job{ seq, std::vector<char>(sentence, sentence + length) });
+            }
+            {
+                std::lock_guard<std::mutex> lock(d_work_mutex);
+                d_pending++;
+            }
+            d_work_cond.notify_one();
+        }
+
+        /*
+         * Take a job from the own queue front, otherwise steal from the back
+         * of another worker's queue.
+         */
+        bool frame_worker_pool::take(int worker, job &j)
+        {
+            const int n = (int)d_queues.size();
+            for (int i = 0; i < n; i++)
+            {
+                worker_queue &q = *d_queues[(worker + i) % n];
+                std::lock_guard<std::mutex> lock(q.mutex);
+                if (q.jobs.empty())
+                {
+                    continue;
+                }
+                if (i == 0)
+                {
+                    j = std::move(q.jobs.front());
+                    q.jobs.pop_front();
+                }
+                else
+                {
+                    j = std::move(q.jobs.back());
+                    q.jobs.pop_back();
+                }
+                return true;
+            }
+            return false;
+        }
+
+        void frame_worker_pool::run(int worker)
+        {
+            std::vector<uint8_t> frame;
+            job j;
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(d_work_mutex);
+                    d_work_cond.wait(lock, [this] { return d_stop || d_pending > 0; });
+                    if (d_stop)
+                    {
+                        return;
+                    }
+                    d_pending--;
+                }
+                // A pending count guarantees a job in one of the queues.
+                while (!take(worker, j))
+                {
+                    std::this_thread::yield();
+                }
+
+                frame.resize(framing::frame_bytes_max((int)j.sentence.size()));
+                frame.resize(d_encode(j.sentence.data(), (long)j.sentence.size(), frame.data()));
+
+                bool notify = false;
+                {
+                    std::lock_guard<std::mutex> lock(d_done_mutex);
+                    slot &s = d_slots[j.seq % d_capacity];
+                    s.frame.swap(frame);
+                    s.ready = true;
+                    if (d_waiting && d_wait_seq == j.seq)
+                    {
+                        d_waiting = false;
+                        notify = true;
+                    }
+                }
+                if (notify && d_ready)
+                {
+                    d_ready();
+                }
+            }
+        }
+
+        bool frame_worker_pool::ready()
+        {
+            if (in_flight() == 0)
+            {
+                return false;
+            }
+            std::lock_guard<std::mutex> lock(d_done_mutex);
+            return d_slots[d_next % d_capacity].ready;
+        }
+
+        const std::vector<uint8_t> *frame_worker_pool::front()
+        {
+            if (in_flight() == 0)
+            {
+                return nullptr;
+            }
+            slot &s = d_slots[d_next % d_capacity];
+            std::lock_guard<std::mutex> lock(d_done_mutex);
+            if (!s.ready)
+            {
+                // The worker finishing this frame runs the ready callback.
+                d_waiting = true;
+                d_wait_seq = d_next;
+                return nullptr;
+            }
+            // Workers never write a slot while it is ready, the frame can be
+            // read without the lock until pop().
+            return &s.frame;
+        }
+
+        void frame_worker_pool::pop()
+        {
+            slot &s = d_slots[d_next % d_capacity];
+            {
+                std::lock_guard<std::mutex> lock(d_done_mutex);
+                s.ready = false;
+            }
+            d_next++;
+        }
+
+    } // namespace ais_simulator
+} // namespace gr
@@ -0,0 +1,123 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_FRAME_WORKER_POOL_H
+#define INCLUDED_AIS_SIMULATOR_FRAME_WORKER_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * Frame building worker pool with ordered output.
+         *
+         * Sentences are numbered on submit and handed to per worker queues in
+         * round robin. An idle worker steals from the back of other queues.
+         * Finished frames go into a reorder ring indexed by sequence number and
+         * are taken out strictly in submit order by a single consumer. The
+         * consumer never blocks, when the next frame is not finished yet the
+         * ready callback is run from the worker that finishes it.
+         */
+        class frame_worker_pool
+        {
+        public:
+            typedef int (*encode_fn)(const char *sentence, long length, uint8_t *out);
+
+            frame_worker_pool(int threads,
+                              int capacity,
+                              encode_fn encode,
+                              std::function<void()> ready = nullptr);
+            ~frame_worker_pool();
+
+            // Number of sentences submitted but not yet popped.
+            int in_flight() const { return (int)(d_submitted - d_next); }
+            bool full() const { return in_flight() >= d_capacity; }
+            // Next frame in submit order is finished.
+            bool ready();
+
+            // Queue a sentence, the caller has to check full() before.
+            void submit(const char *sentence, long length);
+
+            /*
+             * Next frame in submit order or nullptr if not finished, then the
+             * ready callback runs once it is. Frames of empty sentences have
+             * zero length.
+             */
+            const std::vector<uint8_t> *front();
+            // Release the frame returned by front().
+            void pop();
+
+        private:
+            struct job {
+                uint64_t seq;
+                std::vector<char> sentence;
+            };
+
+            struct worker_queue {
+                std::mutex mutex;
+                std::deque<job> jobs;
+            };
+
+            struct slot {
+                std::vector<uint8_t> frame;
+                bool ready = false;
+            };
+
+            const int d_capacity;
+            const encode_fn d_encode;
+            const std::function<void()> d_ready;
+            std::vector<std::unique_ptr<worker_queue>> d_queues;
+            std::vector<std::thread> d_threads;
+
+            // Pending jobs over all queues, workers sleep while zero.
+            std::mutex d_work_mutex;
+            std::condition_variable d_work_cond;
+            int d_pending = 0;
+            bool d_stop = false;
+
+            // Reorder ring of d_capacity slots.
+            std::mutex d_done_mutex;
+            std::vector<slot> d_slots;
+            // Consumer waits for the frame of this sequence number.
+            bool d_waiting = false;
+            uint64_t d_wait_seq = 0;
+
+            // Only touched by the consumer thread.
+            uint64_t d_submitted = 0;
+            uint64_t d_next = 0;
+
+            bool take(int worker, job &j);
+            void run(int worker);
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_FRAME_WORKER_POOL_H */
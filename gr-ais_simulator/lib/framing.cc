@@ -0,0 +1,142 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/ais_simulator/framing.h>
+#include "frame_builder.h"
+#include "hdlc_deframer.h"
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+using namespace gr::ais_simulator;
+
+/*
+ * C API of the framing core. Thin shims over frame_builder.h and
+ * hdlc_deframer.h, no exception leaves them.
+ */
+
+int ais_frame_bytes_max(int len_bits) { return max_frame_bytes(len_bits); }
+
+uint16_t ais_crc16(const uint8_t *data, int len) { return framing::crc16(data, len); }
+
+int ais_encode_payload(const uint8_t *payload, int len, int nrzi, uint8_t *out, size_t out_size)
+{
+    if (len <= 0)
+    {
+        return len < 0 ? -EINVAL : 0;
+    }
+    if (len > framing::LEN_PAYLOAD_MAX / 8)
+    {
+        return -EMSGSIZE;
+    }
+    if (out_size < (size_t)framing::frame_bytes_max(len * 8))
+    {
+        return -ENOSPC;
+    }
+    if (len * 8 <= framing::LEN_SLOT_PAYLOAD)
+    {
+        return nrzi ? framing::build_frame<true, true>(payload, len, out)
+                    : framing::build_frame<false, true>(payload, len, out);
+    }
+    return nrzi ? framing::build_frame<true, false>(payload, len, out)
+                : framing::build_frame<false, false>(payload, len, out);
+}
+
+int ais_encode_bits(const char *bits, long len_bits, int nrzi, uint8_t *out, size_t out_size)
+{
+    const void *end = std::memchr(bits, '\n', len_bits > 0 ? len_bits : 0);
+    const void *nul = std::memchr(bits, '\0', len_bits > 0 ? len_bits : 0);
+    if (nul && (!end || nul < end))
+    {
+        end = nul;
+    }
+    const long len = end ? (const char *)end - bits : len_bits;
+    if (len > framing::LEN_PAYLOAD_MAX)
+    {
+        return -EMSGSIZE;
+    }
+
+    uint8_t payload[framing::LEN_BUFFER / 8];
+    const int len_payload = framing::pack_sentence(bits, len, payload);
+    return ais_encode_payload(payload, len_payload / 8, nrzi, out, out_size);
+}
+
+int ais_encode_batch(const uint8_t *bits,
+                     long bits_stride,
+                     const int32_t *lengths,
+                     long n,
+                     int nrzi,
+                     uint8_t *out,
+                     long out_stride,
+                     int32_t *out_len,
+                     int threads)
+{
+    try
+    {
+        encode_frames(bits, bits_stride, lengths, n, nrzi, out, out_stride, out_len, threads);
+    }
+    catch (const std::invalid_argument &)
+    {
+        return -EINVAL;
+    }
+    catch (const std::system_error &e)
+    {
+        return -e.code().value();
+    }
+    catch (const std::bad_alloc &)
+    {
+        return -ENOMEM;
+    }
+    catch (...)
+    {
+        return -EIO;
+    }
+    return 0;
+}
+
+int ais_decode_frame(const uint8_t *frame, int len, int nrzi, uint8_t *payload, size_t payload_size)
+{
+    framing::hdlc_deframer deframer;
+    int result = -ENOMSG;
+    unsigned level = 0;
+    for (long i = 0; i < (long)len * 8 && result == -ENOMSG; i++)
+    {
+        const unsigned bit = (frame[i >> 3] >> (7 - (i & 7))) & 1;
+        // The deframer undoes NRZI, give it line levels in both modes.
+        level = nrzi ? bit : level ^ !bit;
+        deframer.push(level, [&](const uint8_t *data, int data_len) {
+            if ((size_t)data_len > payload_size)
+            {
+                result = -ENOSPC;
+                return;
+            }
+            std::memcpy(payload, data, data_len);
+            result = data_len;
+        });
+    }
+    return result;
+}
@@ -0,0 +1,147 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_HANDLER_MEMORY_H
+#define INCLUDED_AIS_SIMULATOR_HANDLER_MEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * Recycled storage for the completion handler of one kind of
+         * asynchronous operation that is never in flight twice, e.g. a
+         * session's read. Asio allocates the operation state through the
+         * handler's associated allocator, with this the steady state needs
+         * no heap allocation. A second concurrent allocation or one too large
+         * for the slot falls back to the heap.
+         *
+         * The slot may be allocated on one thread and freed on another, as
+         * long as the two do not overlap.
+         */
+        class handler_memory
+        {
+        private:
+            static constexpr size_t SIZE = 2048; // Beast websocket read state is about 1.1k
+            alignas(std::max_align_t) unsigned char d_storage[SIZE];
+            std::atomic<bool> d_in_use{ false };
+
+        public:
+            handler_memory() = default;
+            handler_memory(const handler_memory &) = delete;
+            handler_memory &operator=(const handler_memory &) = delete;
+
+            void *allocate(size_t size)
+            {
+                if (size <= SIZE && !d_in_use.exchange(true, std::memory_order_acquire))
+                {
+                    return d_storage;
+                }
+                return ::operator new(size);
+            }
+
+            void deallocate(void *p)
+            {
+                if (p == d_storage)
+                {
+                    d_in_use.store(false, std::memory_order_release);
+                    return;
+                }
+                ::operator delete(p);
+            }
+        };
+
+        // Minimal allocator handing out a handler_memory slot.
+        template <typename T>
+        class handler_allocator
+        {
+        private:
+            template <typename>
+            friend class handler_allocator;
+            handler_memory &d_memory;
+
+        public:
+            typedef T value_type;
+
+            explicit handler_allocator(handler_memory &memory) : d_memory(memory) {}
+
+            template <typename U>
+            handler_allocator(const handler_allocator<U> &other) : d_memory(other.d_memory)
+            {
+            }
+
+            T *allocate(size_t n) { return static_cast<T *>(d_memory.allocate(sizeof(T) * n)); }
+            void deallocate(T *p, size_t) { d_memory.deallocate(p); }
+
+            template <typename U>
+            bool operator==(const handler_allocator<U> &other) const
+            {
+                return &d_memory == &other.d_memory;
+            }
+
+            template <typename U>
+            bool operator!=(const handler_allocator<U> &other) const
+            {
+                return &d_memory != &other.d_memory;
+            }
+        };
+
+        // Completion handler wrapper associating a handler_memory slot.
+        template <typename Handler>
+        class recycled_handler
+        {
+        private:
+            handler_memory &d_memory;
+            Handler d_handler;
+
+        public:
+            typedef handler_allocator<Handler> allocator_type;
+
+            recycled_handler(handler_memory &memory, Handler &&handler)
+                : d_memory(memory), d_handler(std::move(handler))
+            {
+            }
+
+            allocator_type get_allocator() const noexcept { return allocator_type(d_memory); }
+
+            template <typename... Args>
+            void operator()(Args &&... args)
+            {
+                d_handler(std::forward<Args>(args)...);
+            }
+        };
+
+        template <typename Handler>
+        recycled_handler<typename std::decay<Handler>::type> recycle(handler_memory &memory, Handler &&handler)
+        {
+            return recycled_handler<typename std::decay<Handler>::type>(memory, std::forward<Handler>(handler));
+        }
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_HANDLER_MEMORY_H */
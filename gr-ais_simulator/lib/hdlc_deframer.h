@@ -0,0 +1,141 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_HDLC_DEFRAMER_H
+#define INCLUDED_AIS_SIMULATOR_HDLC_DEFRAMER_H
+
+#include "frame_builder.h"
+#include <cstdint>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        namespace framing
+        {
+            /*
+             * Receive side of build_frame(). Takes one line level per bit,
+             * undoes NRZI, searches the start mark, removes stuffing bits and
+             * checks the CRC at the end mark.
+             *
+             * A frame failing the CRC may have started on a false start mark
+             * from noise. Its end mark is then taken as start of the next
+             * frame, so a real frame right behind it is not lost.
+             */
+            class hdlc_deframer
+            {
+            private:
+                uint8_t d_data[LEN_BUFFER / 8];
+                int d_bits = 0;      // Data bits of the current frame
+                unsigned d_level = 0;
+                unsigned d_shift = 0; // Last NRZ bits, newest in bit 0
+                int d_ones = 0;
+                bool d_in_frame = false;
+
+                template <typename F>
+                void end_of_frame(F &emit)
+                {
+                    // Drop the zero and six ones of the end mark.
+                    const int bits = d_bits - 7;
+                    d_bits = 0;
+                    if (bits < 3 * 8 || bits % 8)
+                    {
+                        // Too short or unaligned, most likely noise.
+                        return;
+                    }
+                    const int len = bits / 8 - 2;
+                    const uint16_t crc = d_data[len] | (d_data[len + 1] << 8);
+                    if (crc16(d_data, len) != crc)
+                    {
+                        crc_errors++;
+                        return;
+                    }
+                    frames++;
+                    d_in_frame = false;
+                    emit(static_cast<const uint8_t *>(d_data), len);
+                }
+
+            public:
+                uint64_t frames = 0;
+                uint64_t crc_errors = 0;
+
+                /*
+                 * Feed one received line level. Calls emit(payload, len) with
+                 * the packed payload bytes of each frame with a valid CRC.
+                 */
+                template <typename F>
+                void push(unsigned level, F emit)
+                {
+                    const unsigned bit = level == d_level; // No change is a one
+                    d_level = level;
+                    d_shift = (d_shift << 1) | bit;
+
+                    if (!d_in_frame)
+                    {
+                        if ((d_shift & 0xff) == START_MARK)
+                        {
+                            d_in_frame = true;
+                            d_bits = 0;
+                            d_ones = 0;
+                        }
+                        return;
+                    }
+
+                    if (bit)
+                    {
+                        if (++d_ones > 6)
+                        {
+                            // Abort sequence or idle line.
+                            d_in_frame = false;
+                            return;
+                        }
+                    }
+                    else
+                    {
+                        const int ones = d_ones;
+                        d_ones = 0;
+                        if (ones == 5)
+                        {
+                            return; // Stuffing bit
+                        }
+                        if (ones == 6)
+                        {
+                            end_of_frame(emit);
+                            return;
+                        }
+                    }
+
+                    if (d_bits == LEN_BUFFER)
+                    {
+                        d_in_frame = false;
+                        return;
+                    }
+                    // Bytes are sent LSB first.
+                    uint8_t &byte = d_data[d_bits >> 3];
+                    byte = (d_bits & 7) ? byte | (bit << (d_bits & 7)) : bit;
+                    d_bits++;
+                }
+            };
+
+        } // namespace framing
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_HDLC_DEFRAMER_H */
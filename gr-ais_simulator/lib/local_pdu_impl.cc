@@ -0,0 +1,336 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "local_pdu_impl.h"
+#include "sentence_pdu.h"
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        local_pdu::sptr
+        local_pdu::make(std::string socket_path, std::string shm_name, int shm_size)
+        {
+            return gnuradio::get_initial_sptr(new local_pdu_impl(socket_path, shm_name, shm_size));
+        }
+
+        /*
+         * The private constructor
+         */
+        local_pdu_impl::local_pdu_impl(std::string socket_path, std::string shm_name, int shm_size)
+            : gr::block("local_pdu",
+                        gr::io_signature::make(0, 0, 0),
+                        gr::io_signature::make(0, 0, 0)),
+              d_out_port(pmt::mp("out")),
+              d_socket_path(socket_path),
+              d_shm_name(shm_name)
+        {
+            message_port_register_out(d_out_port);
+            try
+            {
+                if (!d_socket_path.empty())
+                {
+                    open_socket();
+                }
+                if (!d_shm_name.empty())
+                {
+                    open_ring(shm_size);
+                }
+            }
+            catch (...)
+            {
+                stop();
+                throw;
+            }
+            if (d_listen_fd >= 0)
+            {
+                d_socket_thread = gr::thread::thread([this] { socket_loop(); });
+            }
+            if (d_ring)
+            {
+                d_shm_thread = gr::thread::thread([this] { shm_loop(); });
+            }
+            d_started = true;
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        local_pdu_impl::~local_pdu_impl()
+        {
+            stop();
+        }
+
+        /*
+         * Stop ingest threads and remove socket and ring.
+         */
+        bool local_pdu_impl::stop()
+        {
+            if (d_started)
+            {
+                d_stop = true;
+                if (d_stop_fd >= 0)
+                {
+                    const uint64_t one = 1;
+                    (void)!write(d_stop_fd, &one, sizeof(one));
+                }
+                if (d_ring)
+                {
+                    __atomic_add_fetch(&d_ring->wake, 1, __ATOMIC_SEQ_CST);
+                    syscall(SYS_futex, &d_ring->wake, FUTEX_WAKE, 1, NULL, NULL, 0);
+                }
+                if (d_socket_thread.joinable())
+                {
+                    d_socket_thread.join();
+                }
+                if (d_shm_thread.joinable())
+                {
+                    d_shm_thread.join();
+                }
+                d_started = false;
+            }
+            if (d_listen_fd >= 0)
+            {
+                close(d_listen_fd);
+                unlink(d_socket_path.c_str());
+                d_listen_fd = -1;
+            }
+            if (d_stop_fd >= 0)
+            {
+                close(d_stop_fd);
+                d_stop_fd = -1;
+            }
+            if (d_ring)
+            {
+                munmap(d_ring, d_ring_size);
+                shm_unlink(d_shm_name.c_str());
+                d_ring = nullptr;
+            }
+            return true;
+        }
+
+        /*
+         * Publish the sentences of one message, same PDUs as websocket_pdu.
+         */
+        void local_pdu_impl::publish(const char *p, size_t len)
+        {
+            for_each_batch_sentence(p, len, [this](const char *s, size_t l, priority_class c) {
+                message_port_pub(d_out_port, make_sentence_pdu(s, l, c));
+            });
+        }
+
+        /*
+         * Listen on a sequenced packet socket, message boundaries are kept so
+         * every packet is one message.
+         */
+        void local_pdu_impl::open_socket()
+        {
+            struct sockaddr_un addr;
+            if (d_socket_path.size() >= sizeof(addr.sun_path))
+            {
+                throw std::invalid_argument("local_pdu: Socket path too long");
+            }
+            memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            memcpy(addr.sun_path, d_socket_path.c_str(), d_socket_path.size());
+
+            d_stop_fd = eventfd(0, EFD_CLOEXEC);
+            d_listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+            if (d_stop_fd < 0 || d_listen_fd < 0)
+            {
+                throw std::runtime_error(std::string("local_pdu: socket: ") + strerror(errno));
+            }
+            // Remove a stale socket of a previous run.
+            unlink(d_socket_path.c_str());
+            if (bind(d_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+                listen(d_listen_fd, 16) < 0)
+            {
+                throw std::runtime_error("local_pdu: Failed to listen on " + d_socket_path + ": " +
+                                         strerror(errno));
+            }
+        }
+
+        /*
+         * Create the shared memory ring, magic is written last so producers
+         * never attach to a half initialized ring.
+         */
+        void local_pdu_impl::open_ring(int shm_size)
+        {
+            if (shm_size < 4096 || (shm_size & (shm_size - 1)))
+            {
+                throw std::invalid_argument("local_pdu: Ring size must be a power of two >= 4096");
+            }
+            int fd = shm_open(d_shm_name.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0600);
+            if (fd < 0)
+            {
+                throw std::runtime_error("local_pdu: shm_open " + d_shm_name + ": " + strerror(errno));
+            }
+            d_ring_size = sizeof(struct ais_shm_ring) + shm_size;
+            void *m = MAP_FAILED;
+            if (ftruncate(fd, d_ring_size) == 0)
+            {
+                m = mmap(NULL, d_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+            if (m == MAP_FAILED)
+            {
+                shm_unlink(d_shm_name.c_str());
+                throw std::runtime_error("local_pdu: Failed to map " + d_shm_name + ": " + strerror(errno));
+            }
+            d_ring = (struct ais_shm_ring *)m;
+            d_ring->version = AIS_SHM_VERSION;
+            d_ring->capacity = shm_size;
+            __atomic_store_n(&d_ring->magic, AIS_SHM_MAGIC, __ATOMIC_RELEASE);
+        }
+
+        /*
+         * Accept producers and publish their packets.
+         */
+        void local_pdu_impl::socket_loop()
+        {
+            std::vector<struct pollfd> fds = { { d_stop_fd, POLLIN, 0 }, { d_listen_fd, POLLIN, 0 } };
+            std::vector<char> buffer(MAX_PACKET);
+
+            while (!d_stop)
+            {
+                if (poll(fds.data(), fds.size(), -1) < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    std::cerr << "local_pdu: poll: " << strerror(errno) << "\n";
+                    break;
+                }
+                if (fds[0].revents)
+                {
+                    break;
+                }
+                if (fds[1].revents & POLLIN)
+                {
+                    const int fd = accept4(d_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+                    if (fd >= 0)
+                    {
+                        fds.push_back({ fd, POLLIN, 0 });
+                    }
+                }
+                for (size_t i = 2; i < fds.size(); i++)
+                {
+                    if (!fds[i].revents)
+                    {
+                        continue;
+                    }
+                    struct iovec iov = { buffer.data(), buffer.size() };
+                    struct msghdr msg;
+                    memset(&msg, 0, sizeof(msg));
+                    msg.msg_iov = &iov;
+                    msg.msg_iovlen = 1;
+                    const ssize_t n = recvmsg(fds[i].fd, &msg, MSG_DONTWAIT);
+                    if (n > 0 && (msg.msg_flags & MSG_TRUNC))
+                    {
+                        std::cerr << "local_pdu: Dropped packet larger than " << MAX_PACKET << " bytes\n";
+                    }
+                    else if (n > 0)
+                    {
+                        publish(buffer.data(), n);
+                    }
+                    else if (n == 0 || (errno != EAGAIN && errno != EINTR))
+                    {
+                        // Producer closed the connection.
+                        close(fds[i].fd);
+                        fds.erase(fds.begin() + i--);
+                    }
+                }
+            }
+
+            for (size_t i = 2; i < fds.size(); i++)
+            {
+                close(fds[i].fd);
+            }
+        }
+
+        /*
+         * Consume the shared memory ring, sleep on the wake counter when
+         * empty. The head is released after every record so producers get
+         * space back early.
+         */
+        void local_pdu_impl::shm_loop()
+        {
+            struct ais_shm_ring *r = d_ring;
+            const uint64_t mask = r->capacity - 1;
+            uint64_t head = r->head;
+
+            while (!d_stop)
+            {
+                const uint64_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+                if (head != tail)
+                {
+                    while (head != tail)
+                    {
+                        uint32_t len;
+                        memcpy(&len, r->data + (head & mask), 4);
+                        if (len != AIS_SHM_PAD && len > r->capacity / 2)
+                        {
+                            std::cerr << "local_pdu: Corrupt ring record, skipping to tail\n";
+                            head = tail;
+                        }
+                        else if (len == AIS_SHM_PAD)
+                        {
+                            head += r->capacity - (head & mask);
+                        }
+                        else
+                        {
+                            publish((const char *)r->data + (head & mask) + 4, len);
+                            head += AIS_SHM_ALIGN(4 + (uint64_t)len);
+                        }
+                        __atomic_store_n(&r->head, head, __ATOMIC_RELEASE);
+                    }
+                    continue;
+                }
+
+                // Announce sleep, then check once more for a commit that missed it.
+                __atomic_store_n(&r->waiting, 1, __ATOMIC_SEQ_CST);
+                const uint32_t wake = __atomic_load_n(&r->wake, __ATOMIC_SEQ_CST);
+                if (__atomic_load_n(&r->tail, __ATOMIC_SEQ_CST) == head && !d_stop)
+                {
+                    struct timespec timeout = { 0, 100000000 };
+                    syscall(SYS_futex, &r->wake, FUTEX_WAIT, wake, &timeout, NULL, 0);
+                }
+                __atomic_store_n(&r->waiting, 0, __ATOMIC_SEQ_CST);
+            }
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
@@ -0,0 +1,68 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_LOCAL_PDU_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_LOCAL_PDU_IMPL_H
+
+#include <gnuradio/ais_simulator/local_pdu.h>
+#include <gnuradio/ais_simulator/shm_ring.h>
+#include <gnuradio/thread/thread.h>
+#include <atomic>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        class local_pdu_impl : public local_pdu
+        {
+        private:
+            // Largest packet read from the socket.
+            static const size_t MAX_PACKET = 65536;
+
+            const pmt::pmt_t d_out_port;
+            const std::string d_socket_path;
+            const std::string d_shm_name;
+            int d_listen_fd = -1;
+            int d_stop_fd = -1;
+            struct ais_shm_ring *d_ring = nullptr;
+            size_t d_ring_size = 0;
+            std::atomic<bool> d_stop{ false };
+            gr::thread::thread d_socket_thread;
+            gr::thread::thread d_shm_thread;
+            bool d_started = false;
+
+            void publish(const char *p, size_t len);
+            void open_socket();
+            void open_ring(int shm_size);
+            void socket_loop();
+            void shm_loop();
+
+        public:
+            local_pdu_impl(std::string socket_path, std::string shm_name, int shm_size);
+            ~local_pdu_impl();
+            bool stop();
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_LOCAL_PDU_IMPL_H */
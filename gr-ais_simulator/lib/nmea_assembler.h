@@ -0,0 +1,197 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_NMEA_ASSEMBLER_H
+#define INCLUDED_AIS_SIMULATOR_NMEA_ASSEMBLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * Decode !AIVDM/!AIVDO sentences into payload bit strings as sent by
+         * the web app, reassembling multipart messages.
+         *
+         * Fragments are kept per sequential message ID and channel. A fragment
+         * out of order drops the partial message. Not thread safe.
+         */
+        class nmea_assembler
+        {
+        public:
+            enum result { COMPLETE, PENDING, IGNORED, BAD_CHECKSUM, MALFORMED };
+
+            explicit nmea_assembler(bool verify_checksum = true)
+                : d_verify_checksum(verify_checksum)
+            {
+            }
+
+            /*
+             * Feed one line without line ending. An optional tag block
+             * (\...\) in front is skipped. On COMPLETE bits holds the payload.
+             */
+            result feed(const char *p, size_t len, std::string &bits)
+            {
+                const char *end = p + len;
+                const char *start = (const char *)memchr(p, '!', len);
+                if (!start || end - start < 7 ||
+                    (memcmp(start + 3, "VDM,", 4) != 0 && memcmp(start + 3, "VDO,", 4) != 0))
+                {
+                    return IGNORED;
+                }
+
+                // Checksum is the XOR of all characters between '!' and '*'.
+                const char *star = (const char *)memchr(start, '*', end - start);
+                if (d_verify_checksum)
+                {
+                    if (!star || end - star < 3)
+                    {
+                        return BAD_CHECKSUM;
+                    }
+                    uint8_t sum = 0;
+                    for (const char *c = start + 1; c < star; c++)
+                    {
+                        sum ^= (uint8_t)*c;
+                    }
+                    if (hex(star[1]) != (sum >> 4) || hex(star[2]) != (sum & 0xf))
+                    {
+                        return BAD_CHECKSUM;
+                    }
+                }
+                end = star ? star : end;
+
+                // !AIVDM,<count>,<number>,<sequence id>,<channel>,<payload>,<fill>
+                const char *f[6];
+                int n = 0;
+                for (const char *c = start; c < end; c++)
+                {
+                    if (*c == ',')
+                    {
+                        if (n == 6)
+                        {
+                            return MALFORMED;
+                        }
+                        f[n++] = c + 1;
+                    }
+                }
+                if (n != 6)
+                {
+                    return MALFORMED;
+                }
+                if (f[5] >= end)
+                {
+                    return MALFORMED;
+                }
+                const int count = f[0][0] - '0';
+                const int number = f[1][0] - '0';
+                const int seq = f[2][0] == ',' ? 0 : f[2][0] - '0' + 1;
+                const int fill = f[5][0] - '0';
+                if (count < 1 || count > 9 || number < 1 || number > count || seq < 0 || seq > 10 ||
+                    fill < 0 || fill > 5)
+                {
+                    return MALFORMED;
+                }
+
+                if (count == 1)
+                {
+                    bits.clear();
+                    return decode(f[4], f[5] - 1, fill, bits) ? COMPLETE : MALFORMED;
+                }
+
+                // Multipart, channel A, B or none.
+                part &pt = d_parts[seq][f[3][0] == 'B' || f[3][0] == '2' ? 1 : 0];
+                if (number == 1)
+                {
+                    pt.bits.clear();
+                    pt.count = count;
+                    pt.next = 1;
+                }
+                if (pt.count != count || pt.next != number)
+                {
+                    pt.next = 0;
+                    return MALFORMED;
+                }
+                if (!decode(f[4], f[5] - 1, number == count ? fill : 0, pt.bits))
+                {
+                    pt.next = 0;
+                    return MALFORMED;
+                }
+                if (++pt.next <= count)
+                {
+                    return PENDING;
+                }
+                pt.next = 0;
+                bits.swap(pt.bits);
+                return COMPLETE;
+            }
+
+        private:
+            struct part {
+                int count = 0;
+                int next = 0; // Next expected fragment, 0 = none
+                std::string bits;
+            };
+
+            const bool d_verify_checksum;
+            // Sequential message ID 0-9 plus none, per channel.
+            part d_parts[11][2];
+
+            static int hex(char c)
+            {
+                return c >= '0' && c <= '9' ? c - '0' : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            }
+
+            // Append six bit armored payload as '0'/'1' characters.
+            static bool decode(const char *p, const char *end, int fill, std::string &bits)
+            {
+                // Fill bits can only pad out the last character.
+                if (fill > 5 || fill > (end - p) * 6)
+                {
+                    return false;
+                }
+                const size_t start = bits.size();
+                bits.resize(start + (end - p) * 6);
+                char *out = &bits[start];
+                for (; p < end; p++)
+                {
+                    int v = *p - 48;
+                    if (v < 0 || v > 71 || (v > 39 && v < 48))
+                    {
+                        return false;
+                    }
+                    v = v > 40 ? v - 8 : v;
+                    for (int b = 5; b >= 0; b--)
+                    {
+                        *out++ = '0' + ((v >> b) & 1);
+                    }
+                }
+                bits.resize(bits.size() - fill);
+                return true;
+            }
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_NMEA_ASSEMBLER_H */
@@ -0,0 +1,87 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_NMEA_ENCODER_H
+#define INCLUDED_AIS_SIMULATOR_NMEA_ENCODER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * Six bit armor packed payload bytes (MSB first) into !AIVDM
+         * sentences, the counterpart of nmea_assembler. Payloads longer than
+         * one sentence are split into fragments with the given sequential
+         * message ID. Sentences are appended to out, each ending in CR LF.
+         */
+        inline void encode_aivdm(const uint8_t *payload, int len_bits, char channel, int seq_id, std::string &out)
+        {
+            // Keeps a full sentence within the 82 character NMEA limit.
+            const int MAX_CHARS = 60;
+            const int chars = (len_bits + 5) / 6;
+            const int fill = chars * 6 - len_bits;
+            const int count = chars ? (chars + MAX_CHARS - 1) / MAX_CHARS : 1;
+
+            int bit = 0;
+            for (int number = 1; number <= count; number++)
+            {
+                char head[32];
+                if (count == 1)
+                {
+                    std::snprintf(head, sizeof(head), "!AIVDM,1,1,,%c,", channel);
+                }
+                else
+                {
+                    std::snprintf(head, sizeof(head), "!AIVDM,%d,%d,%d,%c,", count, number, seq_id, channel);
+                }
+                const size_t start = out.size();
+                out += head;
+                for (int c = 0; c < MAX_CHARS && bit < len_bits; c++)
+                {
+                    int v = 0;
+                    for (int b = 0; b < 6; b++, bit++)
+                    {
+                        v = (v << 1) | (bit < len_bits ? (payload[bit >> 3] >> (7 - (bit & 7))) & 1 : 0);
+                    }
+                    out += (char)(v < 40 ? v + 48 : v + 56);
+                }
+                out += ',';
+                out += (char)('0' + (number == count ? fill : 0));
+
+                // Checksum is the XOR of all characters between '!' and '*'.
+                uint8_t sum = 0;
+                for (size_t i = start + 1; i < out.size(); i++)
+                {
+                    sum ^= (uint8_t)out[i];
+                }
+                char tail[8];
+                std::snprintf(tail, sizeof(tail), "*%02X\r\n", sum);
+                out += tail;
+            }
+        }
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_NMEA_ENCODER_H */
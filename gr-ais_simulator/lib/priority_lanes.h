@@ -0,0 +1,164 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_PRIORITY_LANES_H
+#define INCLUDED_AIS_SIMULATOR_PRIORITY_LANES_H
+
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <utility>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        enum priority_class {
+            PRIORITY_URGENT = 0, // Safety related, types 12 and 14
+            PRIORITY_NORMAL,
+            PRIORITY_BULK,       // Scenario streaming
+            PRIORITY_CLASSES
+        };
+
+        inline const char *priority_name(priority_class c)
+        {
+            static const char *const names[] = { "urgent", "normal", "bulk" };
+            return names[c];
+        }
+
+        // Class from its name, PRIORITY_CLASSES if unknown.
+        inline priority_class priority_from_name(const char *s, size_t len)
+        {
+            for (int c = 0; c < PRIORITY_CLASSES; c++)
+            {
+                const char *name = priority_name((priority_class)c);
+                if (len == std::strlen(name) && std::memcmp(s, name, len) == 0)
+                {
+                    return (priority_class)c;
+                }
+            }
+            return PRIORITY_CLASSES;
+        }
+
+        /*
+         * Class of an AIS bit string by message type, the first six bits.
+         * Addressed and broadcast safety related messages are urgent.
+         */
+        inline priority_class sentence_priority(const char *bits, size_t len)
+        {
+            if (len < 6)
+            {
+                return PRIORITY_NORMAL;
+            }
+            int type = 0;
+            for (int i = 0; i < 6; i++)
+            {
+                type = (type << 1) | (bits[i] == '1');
+            }
+            return type == 12 || type == 14 ? PRIORITY_URGENT : PRIORITY_NORMAL;
+        }
+
+        /*
+         * One FIFO lane per priority class with strict priority dequeue.
+         * Urgent always goes first. Between the others, a lane passed over
+         * starvation_limit times in a row while holding items gets the next
+         * turn, unless urgent items wait. Zero disables that bound. Not thread
+         * safe.
+         */
+        template <typename T>
+        class priority_lanes
+        {
+        private:
+            std::deque<T> d_lanes[PRIORITY_CLASSES];
+            int d_passed[PRIORITY_CLASSES] = {};
+            const int d_starvation_limit;
+            size_t d_size = 0;
+
+        public:
+            explicit priority_lanes(int starvation_limit) : d_starvation_limit(starvation_limit) {}
+
+            size_t size() const { return d_size; }
+            size_t size(priority_class c) const { return d_lanes[c].size(); }
+            bool empty() const { return d_size == 0; }
+
+            void push(priority_class c, T &&item)
+            {
+                d_lanes[c].push_back(std::move(item));
+                d_size++;
+            }
+
+            // Lane the next pop() takes from, PRIORITY_CLASSES when empty.
+            priority_class next() const
+            {
+                if (!d_lanes[PRIORITY_URGENT].empty())
+                {
+                    return PRIORITY_URGENT;
+                }
+                if (d_starvation_limit > 0)
+                {
+                    for (int c = PRIORITY_NORMAL; c < PRIORITY_CLASSES; c++)
+                    {
+                        if (d_passed[c] >= d_starvation_limit && !d_lanes[c].empty())
+                        {
+                            return (priority_class)c;
+                        }
+                    }
+                }
+                for (int c = PRIORITY_NORMAL; c < PRIORITY_CLASSES; c++)
+                {
+                    if (!d_lanes[c].empty())
+                    {
+                        return (priority_class)c;
+                    }
+                }
+                return PRIORITY_CLASSES;
+            }
+
+            // Item the next pop() takes, nullptr when empty.
+            T *front()
+            {
+                const priority_class c = next();
+                return c == PRIORITY_CLASSES ? nullptr : &d_lanes[c].front();
+            }
+
+            // Take the next item, or the next one of lane c only.
+            bool pop(T &item, priority_class c = PRIORITY_CLASSES)
+            {
+                c = c == PRIORITY_CLASSES ? next() : c;
+                if (c == PRIORITY_CLASSES || d_lanes[c].empty())
+                {
+                    return false;
+                }
+                std::swap(item, d_lanes[c].front());
+                d_lanes[c].pop_front();
+                d_size--;
+                d_passed[c] = 0;
+                for (int l = c + 1; l < PRIORITY_CLASSES; l++)
+                {
+                    d_passed[l] += !d_lanes[l].empty();
+                }
+                return true;
+            }
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_PRIORITY_LANES_H */
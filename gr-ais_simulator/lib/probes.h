@@ -0,0 +1,54 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_PROBES_H
+#define INCLUDED_AIS_SIMULATOR_PROBES_H
+
+/*
+ * Statically defined tracepoints (USDT) in the hot paths, for bpftrace,
+ * perf or SystemTap on production hosts. Compiled in with the CMake option
+ * ENABLE_USDT, otherwise AIS_PROBE expands to nothing. An enabled probe
+ * costs one nop until a tracer attaches.
+ *
+ * All probes belong to provider "ais_simulator":
+ *
+ *   ws_accept(int error)                  listener accepted a connection
+ *   ws_read(size_t bytes)                 websocket message received
+ *   ws_message(const char *s, size_t len) sentence published as PDU
+ *   ws_write_queue(size_t bytes, int binary, size_t queued)
+ *   ws_write(size_t bytes, size_t queued) websocket write completed
+ *   frame_work_entry(long input_len)      bitstring_to_frame work()
+ *   set_sentence(long length, int payload_bits)
+ *   frame_work_exit(int payload_bits, int frame_bytes)
+ *
+ * See examples/bpftrace for latency histograms per stage.
+ */
+
+#ifdef AIS_SIMULATOR_USDT
+#include <sys/sdt.h>
+#define AIS_PROBE(name, ...) STAP_PROBEV(ais_simulator, name, __VA_ARGS__)
+#else
+#define AIS_PROBE(name, ...) \
+    do                       \
+    {                        \
+    } while (0)
+#endif
+
+#endif /* INCLUDED_AIS_SIMULATOR_PROBES_H */
@@ -0,0 +1,155 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "burst_cache.h"
+#include <boost/test/unit_test.hpp>
+#include <complex>
+#include <random>
+#include <string>
+#include <vector>
+
+using gr::ais_simulator::burst_cache;
+
+namespace
+{
+    typedef burst_cache<std::complex<float>> cache;
+
+    cache::burst_ptr burst(size_t len, float value = 0)
+    {
+        return std::make_shared<const std::vector<std::complex<float>>>(len, value);
+    }
+
+    // Bytes charged for an entry, see burst_cache::insert().
+    size_t cost(const std::string &key, size_t len)
+    {
+        return len * sizeof(std::complex<float>) + key.size() + 128;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_eviction_order)
+{
+    const size_t len = 1000;
+    const std::string keys[] = { "0001", "0010", "0100", "1000" };
+    cache c(3 * cost(keys[0], len));
+
+    for (int i = 0; i < 3; i++)
+    {
+        c.insert(keys[i], burst(len, i));
+    }
+    BOOST_CHECK_EQUAL(c.size(), 3u);
+    BOOST_CHECK_EQUAL(c.evictions(), 0u);
+
+    // A hit makes "0001" most recent, "0010" goes first.
+    BOOST_REQUIRE(c.find(keys[0]));
+    c.insert(keys[3], burst(len, 3));
+    BOOST_CHECK_EQUAL(c.size(), 3u);
+    BOOST_CHECK_EQUAL(c.evictions(), 1u);
+    BOOST_CHECK(!c.find(keys[1]));
+    BOOST_CHECK(c.find(keys[2]));
+
+    // Now "0001" is least recent.
+    BOOST_CHECK(c.find(keys[3]));
+    c.insert(keys[1], burst(len, 1));
+    BOOST_CHECK(!c.find(keys[0]));
+    BOOST_CHECK_EQUAL((*c.find(keys[1]))[0], std::complex<float>(1));
+    BOOST_CHECK_EQUAL((*c.find(keys[2]))[0], std::complex<float>(2));
+    BOOST_CHECK_EQUAL((*c.find(keys[3]))[0], std::complex<float>(3));
+    BOOST_CHECK_EQUAL(c.evictions(), 2u);
+}
+
+BOOST_AUTO_TEST_CASE(test_byte_budget)
+{
+    const size_t budget = 100000;
+    cache c(budget);
+    std::mt19937 rng(1);
+    size_t inserted = 0;
+    for (int i = 0; i < 2000; i++)
+    {
+        std::string key(8 + rng() % 200, '0');
+        for (auto &b : key)
+        {
+            b = '0' + (rng() & 1);
+        }
+        const size_t len = rng() % 3000;
+        const size_t before = c.bytes();
+        const bool known = (bool)c.find(key);
+        c.insert(key, burst(len));
+        inserted += !known;
+        BOOST_REQUIRE_LE(c.bytes(), budget);
+        if (known)
+        {
+            BOOST_CHECK_EQUAL(c.bytes(), before);
+        }
+        else
+        {
+            // Newest entry is always kept when it fits at all.
+            BOOST_REQUIRE(c.find(key));
+        }
+    }
+    BOOST_CHECK_EQUAL(c.evictions() + c.size(), inserted);
+
+    // Bytes are the sum of what the entries were charged.
+    cache d(budget);
+    size_t expect = 0;
+    for (int i = 0; i < 10; i++)
+    {
+        const std::string key = std::to_string(1000000 + i);
+        d.insert(key, burst(100 * i));
+        expect += cost(key, 100 * i);
+    }
+    BOOST_CHECK_EQUAL(d.bytes(), expect);
+    BOOST_CHECK_EQUAL(d.size(), 10u);
+
+    // Duplicates are ignored, larger than the budget is not kept.
+    d.insert("1000003", burst(2000));
+    BOOST_CHECK_EQUAL(d.bytes(), expect);
+    BOOST_CHECK_EQUAL(d.find("1000003")->size(), 300u);
+    d.insert("big", burst(budget / sizeof(std::complex<float>)));
+    BOOST_CHECK(!d.find("big"));
+    BOOST_CHECK_EQUAL(d.size(), 10u);
+    BOOST_CHECK_EQUAL(d.evictions(), 0u);
+
+    // An entry of exactly the budget evicts all others.
+    const std::string key = "exact";
+    const size_t len = (budget - key.size() - 128) / sizeof(std::complex<float>);
+    cache e(cost(key, len));
+    e.insert("a", burst(10));
+    e.insert(key, burst(len));
+    BOOST_CHECK_EQUAL(e.size(), 1u);
+    BOOST_CHECK_EQUAL(e.bytes(), cost(key, len));
+}
+
+BOOST_AUTO_TEST_CASE(test_views_and_sharing)
+{
+    cache c(cost("0101", 10));
+    c.insert("0101", burst(10, 7));
+
+    // Lookup by a view into a larger buffer, as from the input stream.
+    const std::string input = "11110101000";
+    BOOST_CHECK(c.find(std::string_view(input).substr(4, 4)));
+    BOOST_CHECK(!c.find(std::string_view(input).substr(3, 4)));
+
+    // A burst in use outlives its eviction.
+    cache::burst_ptr held = c.find("0101");
+    c.insert("1010", burst(10));
+    BOOST_CHECK(!c.find("0101"));
+    BOOST_CHECK_EQUAL(held->size(), 10u);
+    BOOST_CHECK_EQUAL((*held)[9], std::complex<float>(7));
+}
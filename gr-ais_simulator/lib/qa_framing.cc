@@ -0,0 +1,225 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gnuradio/ais_simulator/framing.h>
+#include "hdlc_deframer.h"
+#include <boost/test/unit_test.hpp>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // CRC-16-ITU bit by bit, reflected, as in ITU-R M.1371 / ISO 13239.
+    uint16_t reference_crc(const uint8_t *data, int len)
+    {
+        uint16_t crc = 0xffff;
+        for (int i = 0; i < len; i++)
+        {
+            crc ^= data[i];
+            for (int b = 0; b < 8; b++)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+            }
+        }
+        return crc ^ 0xffff;
+    }
+
+    std::vector<uint8_t> random_bytes(std::mt19937 &rng, int len)
+    {
+        std::vector<uint8_t> v(len);
+        for (auto &b : v)
+        {
+            b = (uint8_t)rng();
+        }
+        return v;
+    }
+
+    /*
+     * Run a packed frame through hdlc_deframer, collecting the payloads.
+     * The deframer takes line levels, NRZ frames are turned into those.
+     */
+    std::vector<std::vector<uint8_t>>
+    deframe(const std::vector<uint8_t> &frame, int len, bool nrzi, gr::ais_simulator::framing::hdlc_deframer &d)
+    {
+        std::vector<std::vector<uint8_t>> payloads;
+        unsigned level = 0;
+        for (int i = 0; i < len * 8; i++)
+        {
+            const unsigned bit = (frame[i >> 3] >> (7 - (i & 7))) & 1;
+            level = nrzi ? bit : level ^ !bit;
+            d.push(level, [&payloads](const uint8_t *p, int l) { payloads.emplace_back(p, p + l); });
+        }
+        return payloads;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_crc16)
+{
+    const uint8_t check[] = "123456789";
+    BOOST_CHECK_EQUAL(ais_crc16(check, 9), 0x906e);
+    BOOST_CHECK_EQUAL(ais_crc16(check, 0), 0x0000);
+
+    std::mt19937 rng(1);
+    for (int len = 1; len < 600; len += 7)
+    {
+        const std::vector<uint8_t> data = random_bytes(rng, len);
+        BOOST_CHECK_EQUAL(ais_crc16(data.data(), len), reference_crc(data.data(), len));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_hdlc_round_trip)
+{
+    std::mt19937 rng(2);
+    const int lengths[] = { 1, 2, 3, 8, 20, 21, 22, 32, 63, 64, 100, 255, 505, 506 };
+    for (int nrzi = 0; nrzi < 2; nrzi++)
+    {
+        for (int len : lengths)
+        {
+            std::vector<uint8_t> payload = random_bytes(rng, len);
+            // Runs of ones exercise bit stuffing.
+            if (len > 4)
+            {
+                memset(payload.data() + 1, 0xff, 3);
+            }
+            std::vector<uint8_t> frame(ais_frame_bytes_max(len * 8));
+            const int frame_len = ais_encode_payload(payload.data(), len, nrzi, frame.data(), frame.size());
+            BOOST_REQUIRE_GT(frame_len, 0);
+            BOOST_CHECK_LE((size_t)frame_len, frame.size());
+            if (len * 8 <= 168)
+            {
+                BOOST_CHECK_EQUAL(frame_len, 32); // Padded to one slot
+            }
+
+            gr::ais_simulator::framing::hdlc_deframer d;
+            const auto payloads = deframe(frame, frame_len, nrzi, d);
+            BOOST_CHECK_EQUAL(d.crc_errors, 0u);
+            BOOST_REQUIRE_EQUAL(payloads.size(), 1u);
+            BOOST_CHECK(payloads[0] == payload);
+
+            std::vector<uint8_t> out(len);
+            BOOST_CHECK_EQUAL(ais_decode_frame(frame.data(), frame_len, nrzi, out.data(), out.size()), len);
+            BOOST_CHECK(out == payload);
+            if (len > 1)
+            {
+                BOOST_CHECK_EQUAL(ais_decode_frame(frame.data(), frame_len, nrzi, out.data(), len - 1),
+                                  -ENOSPC);
+            }
+
+            // A flipped payload or CRC bit fails the CRC, in NRZI it flips
+            // two data bits.
+            const int first = (24 + 8) / 8;
+            for (int i = first * 8; i < (first + len + 2) * 8; i += 13)
+            {
+                std::vector<uint8_t> bad = frame;
+                bad[i >> 3] ^= 0x80 >> (i & 7);
+                gr::ais_simulator::framing::hdlc_deframer bd;
+                BOOST_CHECK(deframe(bad, frame_len, nrzi, bd).empty());
+                BOOST_CHECK_EQUAL(ais_decode_frame(bad.data(), frame_len, nrzi, out.data(), out.size()),
+                                  -ENOMSG);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_encode_bits)
+{
+    std::vector<uint8_t> a(ais_frame_bytes_max(AIS_FRAMING_PAYLOAD_MAX));
+    std::vector<uint8_t> b(a.size());
+    const uint8_t payload[] = { 0x9c, 0x40 };
+
+    // Zero padded to whole bytes, ends at a new line or null character.
+    const int len = ais_encode_bits("1001110001\n1111", 15, 1, a.data(), a.size());
+    BOOST_CHECK_EQUAL(len, ais_encode_payload(payload, 2, 1, b.data(), b.size()));
+    BOOST_CHECK(memcmp(a.data(), b.data(), len) == 0);
+    BOOST_CHECK_EQUAL(ais_encode_bits("1001110001\0" "1111", 15, 1, a.data(), a.size()), len);
+    BOOST_CHECK(memcmp(a.data(), b.data(), len) == 0);
+
+    BOOST_CHECK_EQUAL(ais_encode_bits("", 0, 0, a.data(), a.size()), 0);
+    BOOST_CHECK_EQUAL(ais_encode_bits("\n", 1, 0, a.data(), a.size()), 0);
+
+    const std::string longest(AIS_FRAMING_PAYLOAD_MAX, '1');
+    BOOST_CHECK_GT(ais_encode_bits(longest.data(), longest.size(), 0, a.data(), a.size()), 0);
+    BOOST_CHECK_EQUAL(ais_encode_bits((longest + "0").data(), longest.size() + 1, 0, a.data(), a.size()),
+                      -EMSGSIZE);
+    BOOST_CHECK_EQUAL(ais_encode_bits(longest.data(), longest.size(), 0, a.data(), a.size() - 1),
+                      -ENOSPC);
+    BOOST_CHECK_EQUAL(ais_encode_payload(payload, -1, 0, a.data(), a.size()), -EINVAL);
+    // Sizes whose bit count overflows an int.
+    BOOST_CHECK_EQUAL(ais_encode_payload(payload, 1 << 29, 0, a.data(), a.size()), -EMSGSIZE);
+    BOOST_CHECK_EQUAL(ais_encode_payload(payload, INT_MAX, 0, a.data(), a.size()), -EMSGSIZE);
+}
+
+BOOST_AUTO_TEST_CASE(test_encode_batch)
+{
+    std::mt19937 rng(3);
+    const long stride = ais_frame_bytes_max(AIS_FRAMING_PAYLOAD_MAX);
+    const long n = 200;
+
+    // Runs of equal lengths go through the bit-sliced encoder.
+    std::vector<int32_t> lengths(n);
+    for (long i = 0; i < n; i++)
+    {
+        lengths[i] = i < 80 ? 168 : i < 150 ? 256 : i < 190 ? (int32_t)(rng() % 1000) : 0;
+    }
+    std::vector<uint8_t> bits(n * AIS_FRAMING_PAYLOAD_MAX);
+    for (auto &b : bits)
+    {
+        b = rng() & 1;
+    }
+
+    for (int nrzi = 0; nrzi < 2; nrzi++)
+    {
+        for (int threads : { 1, 3, 0 })
+        {
+            std::vector<uint8_t> out(n * stride);
+            std::vector<int32_t> out_len(n, -1);
+            BOOST_REQUIRE_EQUAL(ais_encode_batch(bits.data(), AIS_FRAMING_PAYLOAD_MAX, lengths.data(), n,
+                                                 nrzi, out.data(), stride, out_len.data(), threads),
+                                0);
+            for (long i = 0; i < n; i++)
+            {
+                std::string s(lengths[i], '0');
+                for (int k = 0; k < lengths[i]; k++)
+                {
+                    s[k] += bits[i * AIS_FRAMING_PAYLOAD_MAX + k];
+                }
+                std::vector<uint8_t> frame(stride);
+                const int len = ais_encode_bits(s.data(), s.size(), nrzi, frame.data(), frame.size());
+                BOOST_REQUIRE_EQUAL(out_len[i], len);
+                BOOST_CHECK(memcmp(out.data() + i * stride, frame.data(), len) == 0);
+            }
+        }
+    }
+
+    std::vector<uint8_t> out(stride);
+    int32_t out_len;
+    int32_t bad = AIS_FRAMING_PAYLOAD_MAX + 1;
+    BOOST_CHECK_EQUAL(ais_encode_batch(bits.data(), bad, &bad, 1, 0, out.data(), stride, &out_len, 1),
+                      -EINVAL);
+    bad = -1;
+    BOOST_CHECK_EQUAL(ais_encode_batch(bits.data(), 1, &bad, 1, 0, out.data(), stride, &out_len, 1),
+                      -EINVAL);
+    BOOST_CHECK_EQUAL(ais_encode_batch(bits.data(), AIS_FRAMING_PAYLOAD_MAX, lengths.data(), 1, 0,
+                                       out.data(), 8, &out_len, 1),
+                      -EINVAL);
+}
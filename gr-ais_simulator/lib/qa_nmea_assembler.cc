@@ -0,0 +1,210 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "nmea_assembler.h"
+#include <boost/test/unit_test.hpp>
+#include <cstdio>
+#include <string>
+
+using gr::ais_simulator::nmea_assembler;
+
+namespace
+{
+    // Complete a sentence body, e.g. "!AIVDM,1,1,,A,15M,0", with its checksum.
+    std::string sentence(const std::string &body)
+    {
+        unsigned sum = 0;
+        for (size_t i = 1; i < body.size(); i++)
+        {
+            sum ^= (unsigned char)body[i];
+        }
+        char cs[4];
+        snprintf(cs, sizeof(cs), "*%02X", sum);
+        return body + cs;
+    }
+
+    nmea_assembler::result feed(nmea_assembler &a, const std::string &line, std::string &bits)
+    {
+        return a.feed(line.data(), line.size(), bits);
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_single_part)
+{
+    nmea_assembler a;
+    std::string bits;
+
+    // '0' is 0, 'W' is 39, '`' is 40 and 'w' is 63.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,0W`w,0"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "000000100111101000111111");
+
+    // Fill bits come off the end.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDO,1,1,,B,w,2"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "1111");
+
+    // Tag block in front is skipped, other sentences are ignored.
+    BOOST_CHECK_EQUAL(feed(a, "\\s:base,c:1600000000*00\\" + sentence("!AIVDM,1,1,,A,w,0"), bits),
+                      nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "111111");
+    BOOST_CHECK_EQUAL(feed(a, sentence("$GPGGA,1,2,3,4,5,6"), bits), nmea_assembler::IGNORED);
+    BOOST_CHECK_EQUAL(feed(a, "", bits), nmea_assembler::IGNORED);
+}
+
+BOOST_AUTO_TEST_CASE(test_empty_payload)
+{
+    nmea_assembler a;
+    std::string bits = "1";
+
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,,0"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK(bits.empty());
+
+    // Fill bits on nothing used to underflow the bit string.
+    BOOST_CHECK_EQUAL(feed(a, "!AIVDM,1,1,,A,,5*23", bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,,1"), bits), nmea_assembler::MALFORMED);
+
+    // Missing fields.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,w"), bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,w,"), bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,,,,,,"), bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,w,0,0"), bits), nmea_assembler::MALFORMED);
+}
+
+BOOST_AUTO_TEST_CASE(test_bad_fill)
+{
+    nmea_assembler a;
+    std::string bits;
+
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,w,6"), bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,w,x"), bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,w,5"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "1");
+
+    // Invalid payload characters.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,0X,0"), bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,1,1,,A,0x,0"), bits), nmea_assembler::MALFORMED);
+
+    // Fill on the last fragment of a multipart message only.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,1,A,w,4"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,1,A,0,4"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "11111100");
+
+    // A bad fill on the last fragment drops the message.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,1,A,w,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,1,A,,2"), bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,1,A,0,0"), bits), nmea_assembler::MALFORMED);
+}
+
+BOOST_AUTO_TEST_CASE(test_checksum)
+{
+    nmea_assembler a;
+    std::string bits;
+    const std::string good = sentence("!AIVDM,1,1,,A,w,0");
+
+    std::string bad = good;
+    bad[bad.size() - 1] = bad.back() == '0' ? '1' : '0';
+    BOOST_CHECK_EQUAL(feed(a, bad, bits), nmea_assembler::BAD_CHECKSUM);
+    BOOST_CHECK_EQUAL(feed(a, good.substr(0, good.size() - 3), bits),
+                      nmea_assembler::BAD_CHECKSUM);
+    BOOST_CHECK_EQUAL(feed(a, good.substr(0, good.size() - 1), bits),
+                      nmea_assembler::BAD_CHECKSUM);
+
+    // Payload changed, checksum not.
+    std::string altered = good;
+    altered[altered.find(",w,") + 1] = '0';
+    BOOST_CHECK_EQUAL(feed(a, altered, bits), nmea_assembler::BAD_CHECKSUM);
+
+    // A bad fragment doesn't touch the partial message.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,2,A,w,0"), bits), nmea_assembler::PENDING);
+    bad = sentence("!AIVDM,2,2,2,A,0,0");
+    bad[bad.size() - 2] ^= 1;
+    BOOST_CHECK_EQUAL(feed(a, bad, bits), nmea_assembler::BAD_CHECKSUM);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,2,A,0,0"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "111111000000");
+
+    // Without verification the checksum may be anything or missing.
+    nmea_assembler lax(false);
+    BOOST_CHECK_EQUAL(feed(lax, altered, bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "000000");
+    BOOST_CHECK_EQUAL(feed(lax, "!AIVDM,1,1,,A,w,0", bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "111111");
+}
+
+BOOST_AUTO_TEST_CASE(test_multipart_order)
+{
+    nmea_assembler a;
+    std::string bits;
+
+    // Second fragment before the first.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,3,A,0,0"), bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,3,A,w,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,3,A,0,0"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "111111000000");
+
+    // Skipped fragment drops the message, the rest is refused.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,3,1,3,A,w,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,3,3,3,A,0,0"), bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,3,2,3,A,0,0"), bits), nmea_assembler::MALFORMED);
+
+    // Fragment count changing midway.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,3,1,3,A,w,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,3,A,0,0"), bits), nmea_assembler::MALFORMED);
+
+    // Fragment number out of range.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,3,3,A,0,0"), bits), nmea_assembler::MALFORMED);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,0,3,A,0,0"), bits), nmea_assembler::MALFORMED);
+
+    // Messages interleaved on channels and sequence IDs assemble separately.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,4,A,w,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,4,B,0,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,5,A,`,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,,A,W,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,4,B,w,0"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "000000111111");
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,,A,w,0"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "100111111111");
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,5,A,w,0"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "101000111111");
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,4,A,0,0"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "111111000000");
+
+    // Completed messages are gone.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,4,A,0,0"), bits), nmea_assembler::MALFORMED);
+}
+
+BOOST_AUTO_TEST_CASE(test_sequence_reuse)
+{
+    nmea_assembler a;
+    std::string bits;
+
+    // A new first fragment on a busy sequence ID starts over.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,3,1,7,A,w,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,3,2,7,A,w,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,7,A,0,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,7,A,W,0"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "000000100111");
+
+    // Reused right after completion.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,7,A,`,0"), bits), nmea_assembler::PENDING);
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,2,7,A,`,3"), bits), nmea_assembler::COMPLETE);
+    BOOST_CHECK_EQUAL(bits, "101000101");
+
+    // Sequence IDs are single digits.
+    BOOST_CHECK_EQUAL(feed(a, sentence("!AIVDM,2,1,A,A,w,0"), bits), nmea_assembler::MALFORMED);
+}
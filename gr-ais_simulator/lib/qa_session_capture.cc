@@ -0,0 +1,174 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "session_capture.h"
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using gr::ais_simulator::capture_reader;
+using gr::ais_simulator::capture_writer;
+
+namespace
+{
+    // Unique file name in the temporary directory, removed when done.
+    struct temp_file {
+        std::string path;
+
+        temp_file()
+        {
+            const char *dir = std::getenv("TMPDIR");
+            path = std::string(dir ? dir : "/tmp") + "/qa_session_capture_XXXXXX";
+            const int fd = mkstemp(&path[0]);
+            BOOST_REQUIRE(fd >= 0);
+            close(fd);
+        }
+
+        ~temp_file() { unlink(path.c_str()); }
+    };
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_round_trip)
+{
+    temp_file f;
+    std::vector<std::string> msgs = { "", "0101", "@schedule\n+1 0 0101", "MMSI 244123456: SOG=1" };
+    msgs.push_back(std::string(100000, '1'));
+    for (int i = 0; i < 10000; i++)
+    {
+        msgs.push_back(std::to_string(i));
+    }
+
+    const uint64_t before = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::system_clock::now().time_since_epoch())
+                                .count();
+    {
+        capture_writer w(f.path);
+        for (const auto &m : msgs)
+        {
+            w.record(m.data(), m.size());
+        }
+        // Records are written by the writer thread.
+        for (int i = 0; i < 1000 && w.records() < msgs.size(); i++)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        BOOST_CHECK_EQUAL(w.records(), msgs.size());
+        BOOST_CHECK_EQUAL(w.errors(), 0u);
+    }
+
+    capture_reader r(f.path);
+    BOOST_CHECK_GE(r.start(), before);
+    BOOST_CHECK_LT(r.start() - before, 10000000000ull);
+    uint64_t time;
+    uint64_t last = 0;
+    std::string data;
+    for (const auto &m : msgs)
+    {
+        BOOST_REQUIRE(r.next(time, data));
+        BOOST_CHECK(data == m);
+        BOOST_CHECK_GE(time, last);
+        last = time;
+    }
+    BOOST_CHECK(!r.next(time, data));
+}
+
+BOOST_AUTO_TEST_CASE(test_truncated)
+{
+    temp_file f;
+    {
+        capture_writer w(f.path);
+        w.record("0101", 4);
+        w.record("1111", 4);
+    }
+    // Cut the last record short, a record is time, length and data.
+    const size_t record = 8 + 4 + 4;
+    BOOST_REQUIRE_EQUAL(
+        truncate(f.path.c_str(), sizeof(gr::ais_simulator::capture_header) + 2 * record - 2), 0);
+    capture_reader r(f.path);
+    uint64_t time;
+    std::string data;
+    BOOST_CHECK(r.next(time, data));
+    BOOST_CHECK_EQUAL(data, "0101");
+    BOOST_CHECK(!r.next(time, data));
+}
+
+BOOST_AUTO_TEST_CASE(test_bad_files)
+{
+    temp_file f;
+    BOOST_CHECK_THROW(capture_reader r(f.path), std::runtime_error); // Empty
+    FILE *file = std::fopen(f.path.c_str(), "wb");
+    std::fputs("not a capture log at all", file);
+    std::fclose(file);
+    BOOST_CHECK_THROW(capture_reader r(f.path), std::runtime_error);
+    BOOST_CHECK_THROW(capture_reader r(f.path + ".missing"), std::runtime_error);
+    BOOST_CHECK_THROW(capture_writer w("/nonexistent/capture"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_oversized_record)
+{
+    temp_file f;
+    {
+        capture_writer w(f.path);
+        w.record("0101", 4);
+    }
+    // Append a record claiming more than the reader accepts.
+    FILE *file = std::fopen(f.path.c_str(), "ab");
+    const uint64_t time = 0;
+    const uint32_t len = gr::ais_simulator::CAPTURE_RECORD_MAX + 1;
+    std::fwrite(&time, sizeof(time), 1, file);
+    std::fwrite(&len, sizeof(len), 1, file);
+    std::fputs("1111", file);
+    std::fclose(file);
+    capture_reader r(f.path);
+    uint64_t t;
+    std::string data;
+    BOOST_CHECK(r.next(t, data));
+    BOOST_CHECK_EQUAL(data, "0101");
+    BOOST_CHECK(!r.next(t, data));
+}
+
+BOOST_AUTO_TEST_CASE(test_write_errors_counted)
+{
+    if (access("/dev/full", W_OK) != 0)
+    {
+        return;
+    }
+    // The header fits the stdio buffer, the flush after a record fails.
+    capture_writer w("/dev/full");
+    w.record("0101", 4);
+    for (int i = 0; i < 1000 && w.errors() == 0; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    BOOST_REQUIRE_GT(w.errors(), 0u);
+    // Nothing is written after the failure, the skipped records count.
+    w.record("1111", 4);
+    w.record("0000", 4);
+    for (int i = 0; i < 1000 && w.errors() < 3; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    BOOST_CHECK_EQUAL(w.errors(), 3u);
+}
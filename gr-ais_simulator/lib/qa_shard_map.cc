@@ -0,0 +1,129 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "shard_map.h"
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using gr::ais_simulator::shard_map;
+
+namespace
+{
+    // Sequential MMSIs from a typical range plus a spread over all of them.
+    std::vector<uint32_t> test_mmsis()
+    {
+        std::vector<uint32_t> v;
+        for (uint32_t m = 211000000; m < 211100000; m++)
+        {
+            v.push_back(m);
+        }
+        for (uint32_t m = 1; m < 999999999; m += 9973)
+        {
+            v.push_back(m);
+        }
+        return v;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_single_shard)
+{
+    const shard_map one(1);
+    const shard_map none(0);
+    BOOST_CHECK_EQUAL(one.shards(), 1);
+    for (uint32_t m : { 1u, 211000000u, 999999999u })
+    {
+        BOOST_CHECK_EQUAL(one.owner(m), 0);
+        BOOST_CHECK_EQUAL(none.owner(m), 0);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_owner_stable_when_adding_shard)
+{
+    const std::vector<uint32_t> mmsis = test_mmsis();
+    for (int n = 1; n < 12; n++)
+    {
+        const shard_map before(n);
+        const shard_map after(n + 1);
+        size_t moved = 0;
+        for (uint32_t m : mmsis)
+        {
+            const int a = before.owner(m);
+            const int b = after.owner(m);
+            BOOST_REQUIRE(a >= 0 && a < n);
+            // An MMSI stays or goes to the new shard, never between old ones.
+            if (a != b)
+            {
+                BOOST_REQUIRE_EQUAL(b, n);
+                moved++;
+            }
+        }
+        // About 1/(n+1) moves.
+        const double share = (double)moved / mmsis.size();
+        BOOST_CHECK_MESSAGE(share > 0.5 / (n + 1) && share < 1.5 / (n + 1),
+                            "adding shard " << n << " moved " << share);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_balance_and_determinism)
+{
+    const std::vector<uint32_t> mmsis = test_mmsis();
+    const int n = 8;
+    const shard_map a(n);
+    const shard_map b(n);
+    std::vector<size_t> count(n);
+    for (uint32_t m : mmsis)
+    {
+        const int s = a.owner(m);
+        BOOST_REQUIRE_EQUAL(s, b.owner(m));
+        count[s]++;
+    }
+    for (int s = 0; s < n; s++)
+    {
+        const double share = (double)count[s] * n / mmsis.size();
+        BOOST_CHECK_MESSAGE(share > 0.6 && share < 1.4, "shard " << s << " holds " << share);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_mmsi_parsing)
+{
+    uint32_t mmsi = 0;
+
+    // Type 1, repeat 0, MMSI 211000001.
+    std::string bits = "00000100";
+    for (int i = 29; i >= 0; i--)
+    {
+        bits.push_back('0' + ((211000001u >> i) & 1));
+    }
+    BOOST_CHECK(gr::ais_simulator::sentence_mmsi(bits.data(), bits.size(), mmsi));
+    BOOST_CHECK_EQUAL(mmsi, 211000001u);
+    BOOST_CHECK(!gr::ais_simulator::sentence_mmsi(bits.data(), bits.size() - 1, mmsi));
+    bits[20] = 'x';
+    BOOST_CHECK(!gr::ais_simulator::sentence_mmsi(bits.data(), bits.size(), mmsi));
+
+    const std::string delta = "  mmsi 244123456: SOG=12.5";
+    BOOST_CHECK(gr::ais_simulator::delta_mmsi(delta.data(), delta.size(), mmsi));
+    BOOST_CHECK_EQUAL(mmsi, 244123456u);
+    for (const char *bad : { "MMSI 0: SOG=1", "MMSI 1000000000: SOG=1", "MMSI : SOG=1", "SHIP 1: SOG=1" })
+    {
+        BOOST_CHECK_MESSAGE(!gr::ais_simulator::delta_mmsi(bad, strlen(bad), mmsi), bad);
+    }
+}
@@ -0,0 +1,197 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "timer_wheel.h"
+#include <boost/test/unit_test.hpp>
+#include <random>
+#include <vector>
+
+using gr::ais_simulator::timer_wheel;
+
+namespace
+{
+    struct fired {
+        uint64_t expiry;
+        uint64_t tick;
+    };
+
+    // Advance to tick, record the tick each entry fires at.
+    void advance(timer_wheel<int> &w, uint64_t to, std::vector<fired> &log)
+    {
+        w.advance(to, [&w, &log](uint64_t expiry, int &&) { log.push_back(fired{ expiry, w.now() }); });
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_timer_wheel_boundaries)
+{
+    // Expiries around the level 1, 2 and 3 slot boundaries, reached tick by
+    // tick or in larger steps up to the level 2 ones, then in one step.
+    const std::vector<uint64_t> expiries = { 1,     255,   256,    257,    511,    512,
+                                             768,   65535, 65536,  65537,  65792,  131072,
+                                             131328, 16777215, 16777216, 16777472 };
+    for (const uint64_t step : { 1ULL, 1000ULL, 20000000ULL })
+    {
+        timer_wheel<int> w;
+        for (const uint64_t e : expiries)
+        {
+            w.insert(e, 0);
+        }
+        std::vector<fired> log;
+        for (uint64_t t = 0; t < 140000; t += step)
+        {
+            advance(w, t + step, log);
+        }
+        advance(w, 20000000, log);
+        BOOST_CHECK(w.empty());
+        BOOST_REQUIRE_EQUAL(log.size(), expiries.size());
+        for (size_t i = 0; i < log.size(); i++)
+        {
+            BOOST_CHECK_EQUAL(log[i].expiry, expiries[i]);
+            BOOST_CHECK_EQUAL(log[i].tick, expiries[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_timer_wheel_cascade_from_offset)
+{
+    // Entries inserted part way into a slot range, expiring on multiples
+    // of 256 and 65536 after one or more cascades.
+    for (const uint64_t start : { 1ULL, 200ULL, 255ULL, 65000ULL, 65535ULL })
+    {
+        timer_wheel<int> w(start);
+        std::vector<uint64_t> expiries;
+        for (uint64_t e = 256; e <= 4 * 65536; e += 256)
+        {
+            if (e > start)
+            {
+                w.insert(e, 0);
+                expiries.push_back(e);
+            }
+        }
+        std::vector<fired> log;
+        advance(w, 4 * 65536, log);
+        BOOST_REQUIRE_EQUAL(log.size(), expiries.size());
+        for (size_t i = 0; i < log.size(); i++)
+        {
+            BOOST_CHECK_EQUAL(log[i].tick, expiries[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_timer_wheel_past_and_horizon)
+{
+    timer_wheel<int> w(1000);
+    w.insert(10, 0);
+    w.insert(1000, 0);
+    std::vector<fired> log;
+    advance(w, 1001, log);
+    BOOST_REQUIRE_EQUAL(log.size(), 2u);
+    BOOST_CHECK_EQUAL(log[0].tick, 1001u);
+    BOOST_CHECK_EQUAL(log[1].tick, 1001u);
+
+    // Beyond the horizon is clamped to it.
+    w.insert(w.now() + timer_wheel<int>::HORIZON + 100, 0);
+    uint64_t next;
+    BOOST_REQUIRE(w.next_tick(next));
+    log.clear();
+    advance(w, w.now() + timer_wheel<int>::HORIZON, log);
+    BOOST_REQUIRE_EQUAL(log.size(), 1u);
+    BOOST_CHECK_EQUAL(log[0].tick, 1001 + timer_wheel<int>::HORIZON);
+}
+
+BOOST_AUTO_TEST_CASE(test_timer_wheel_next_tick)
+{
+    timer_wheel<int> w;
+    uint64_t next;
+    BOOST_CHECK(!w.next_tick(next));
+
+    // Level 0 expiry, level 1 and level 2 cascades.
+    w.insert(70000, 0);
+    BOOST_REQUIRE(w.next_tick(next));
+    BOOST_CHECK_EQUAL(next, 65536u);
+    w.insert(300, 0);
+    BOOST_REQUIRE(w.next_tick(next));
+    BOOST_CHECK_EQUAL(next, 256u);
+    w.insert(10, 0);
+    BOOST_REQUIRE(w.next_tick(next));
+    BOOST_CHECK_EQUAL(next, 10u);
+
+    std::vector<fired> log;
+    advance(w, 10, log);
+    BOOST_REQUIRE(w.next_tick(next));
+    BOOST_CHECK_EQUAL(next, 256u);
+    advance(w, 256, log);
+    BOOST_REQUIRE(w.next_tick(next));
+    BOOST_CHECK_EQUAL(next, 300u);
+    advance(w, 300, log);
+    BOOST_REQUIRE(w.next_tick(next));
+    BOOST_CHECK_EQUAL(next, 65536u);
+    advance(w, 65536, log);
+    BOOST_REQUIRE(w.next_tick(next));
+    BOOST_CHECK_EQUAL(next, 69888u);
+    advance(w, 70000, log);
+    BOOST_CHECK_EQUAL(log.size(), 3u);
+    BOOST_CHECK(!w.next_tick(next));
+}
+
+BOOST_AUTO_TEST_CASE(test_timer_wheel_fuzz)
+{
+    // Random expiries and advance steps, every entry fires exactly at its
+    // expiry. Repeats are reinserted from fire.
+    timer_wheel<int> w;
+    std::mt19937_64 rng(5);
+    uint64_t now = 0;
+    long count = 0;
+    long wrong = 0;
+    for (int round = 0; round < 1000; round++)
+    {
+        for (int i = 0; i < 100; i++)
+        {
+            uint64_t d;
+            switch (rng() % 4)
+            {
+            case 0:
+                d = 1 + rng() % 300;
+                break;
+            case 1:
+                d = 256 * (1 + rng() % 4);
+                break;
+            case 2:
+                d = 1 + rng() % 70000;
+                break;
+            default:
+                d = 65536 * (1 + rng() % 3) - 1 + rng() % 3;
+                break;
+            }
+            w.insert(now + d, (int)(rng() % 2));
+        }
+        now += rng() % 5000;
+        w.advance(now, [&](uint64_t expiry, int &&repeat) {
+            count++;
+            wrong += w.now() != expiry;
+            if (repeat)
+            {
+                w.insert(expiry + 256, 0);
+            }
+        });
+    }
+    BOOST_CHECK_GT(count, 50000);
+    BOOST_CHECK_EQUAL(wrong, 0);
+}
@@ -0,0 +1,247 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include "vessel_store.h"
+#include <boost/test/unit_test.hpp>
+#include <map>
+#include <random>
+#include <vector>
+
+using gr::ais_simulator::vessel_state;
+using gr::ais_simulator::vessel_store;
+
+namespace
+{
+    // Unsigned field of n bits at offset from a bit string.
+    uint32_t field(const std::string &bits, size_t offset, int n)
+    {
+        uint32_t v = 0;
+        for (int i = 0; i < n; i++)
+        {
+            v = (v << 1) | (bits.at(offset + i) == '1');
+        }
+        return v;
+    }
+
+    int32_t signed_field(const std::string &bits, size_t offset, int n)
+    {
+        const uint32_t v = field(bits, offset, n);
+        return (v & (1u << (n - 1))) ? (int32_t)(v - (1u << n)) : (int32_t)v;
+    }
+
+    // Six-bit text of chars characters, trailing '@' removed.
+    std::string text(const std::string &bits, size_t offset, size_t chars)
+    {
+        const char *sixbit = "@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^- !\"#$%&'()*+,-./0123456789:;<=>?";
+        std::string s;
+        for (size_t i = 0; i < chars; i++)
+        {
+            s.push_back(sixbit[field(bits, offset + i * 6, 6)]);
+        }
+        return s.substr(0, s.find_last_not_of('@') + 1);
+    }
+
+    vessel_state *apply(vessel_store &store, const std::string &delta)
+    {
+        std::string error;
+        vessel_state *v = store.apply(delta.data(), delta.data() + delta.size(), error);
+        BOOST_CHECK_MESSAGE(error.empty(), delta + ": " + error);
+        return v;
+    }
+
+    // Flush all dirty messages, keyed by message type (24B as 0).
+    std::map<int, std::string> flush(vessel_store &store, vessel_state &v)
+    {
+        std::map<int, std::string> msgs;
+        store.flush(v, [&msgs](std::string &&bits) {
+            const int type = (int)field(bits, 0, 6);
+            msgs[type == 24 && field(bits, 38, 2) == 1 ? 0 : type] = bits;
+            return true;
+        });
+        return msgs;
+    }
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_vessel_store_against_map)
+{
+    // Random insert, find and erase against std::map. Sequential MMSIs
+    // cluster in the table, random ones spread, the table grows on the way.
+    vessel_store store;
+    std::map<uint32_t, int> ref;
+    std::mt19937 rng(7);
+    for (int i = 0; i < 200000; i++)
+    {
+        const uint32_t mmsi = (rng() % 2) ? 211000000 + rng() % 5000 : 1 + rng() % 999999999;
+        switch (rng() % 3)
+        {
+        case 0:
+        {
+            vessel_state &v = store.insert(mmsi);
+            BOOST_REQUIRE_EQUAL(v.mmsi, mmsi);
+            v.length = i;
+            ref[mmsi] = i;
+            break;
+        }
+        case 1:
+            BOOST_REQUIRE_EQUAL(store.erase(mmsi), ref.erase(mmsi) == 1);
+            break;
+        default:
+        {
+            vessel_state *v = store.find(mmsi);
+            auto it = ref.find(mmsi);
+            BOOST_REQUIRE_EQUAL(v != nullptr, it != ref.end());
+            if (v)
+            {
+                BOOST_REQUIRE_EQUAL(v->mmsi, mmsi);
+                BOOST_REQUIRE_EQUAL(v->length, it->second);
+            }
+            break;
+        }
+        }
+        BOOST_REQUIRE_EQUAL(store.size(), ref.size());
+    }
+    for (const auto &r : ref)
+    {
+        vessel_state *v = store.find(r.first);
+        BOOST_REQUIRE(v);
+        BOOST_CHECK_EQUAL(v->length, r.second);
+    }
+    for (const auto &r : ref)
+    {
+        BOOST_REQUIRE(store.erase(r.first));
+    }
+    BOOST_CHECK_EQUAL(store.size(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_vessel_store_message_lengths)
+{
+    vessel_state v;
+    v.mmsi = 247320162;
+    v.name = "A LONG NAME FOR AN AID TO NAVIGATION";
+    const std::map<int, size_t> lengths = { { 1, 168 },  { 4, 168 },  { 5, 424 },
+                                            { 9, 168 },  { 18, 168 }, { 19, 312 },
+                                            { 24, 168 }, { 0, 168 },  { 27, 96 } };
+    std::string bits;
+    for (const auto &l : lengths)
+    {
+        vessel_store::encode(v, l.first, bits);
+        BOOST_CHECK_EQUAL(bits.size(), l.second);
+        BOOST_CHECK_EQUAL(field(bits, 0, 6), (uint32_t)(l.first ? l.first : 24));
+        BOOST_CHECK_EQUAL(field(bits, 8, 30), v.mmsi);
+    }
+    // Message 21 carries the name beyond 20 characters in the extension,
+    // padded to a byte boundary.
+    vessel_store::encode(v, 21, bits);
+    BOOST_CHECK_EQUAL(bits.size(), 272u + 88);
+    BOOST_CHECK_EQUAL(text(bits, 272, 14), "ID TO NAVIGATI");
+    v.name = "SHORT";
+    vessel_store::encode(v, 21, bits);
+    BOOST_CHECK_EQUAL(bits.size(), 272u);
+}
+
+BOOST_AUTO_TEST_CASE(test_vessel_store_field_layout)
+{
+    vessel_store store;
+    vessel_state *v = apply(store,
+                            "MMSI 247320162: TYPES=1/5/18/24, STATUS=5, SOG=12.3, COG=85.4, "
+                            "LAT=54.5, LON=-10.25, SHIPTYPE=70, LENGTH=100, BEAM=20, "
+                            "DRAUGHT=7.5, ETA=06-15 12:30, NAME=Test Vessel, "
+                            "CALLSIGN=DABC, DEST=Hamburg");
+    BOOST_REQUIRE(v);
+    std::map<int, std::string> msgs = flush(store, *v);
+    BOOST_REQUIRE_EQUAL(msgs.size(), 5u);
+    BOOST_CHECK_EQUAL(v->dirty, 0u);
+
+    const std::string &m1 = msgs[1];
+    BOOST_CHECK_EQUAL(field(m1, 38, 4), 5u); // Status
+    BOOST_CHECK_EQUAL(field(m1, 50, 10), 123u); // SOG
+    BOOST_CHECK_EQUAL(signed_field(m1, 61, 28), -6150000); // Lon
+    BOOST_CHECK_EQUAL(signed_field(m1, 89, 27), 32700000); // Lat
+    BOOST_CHECK_EQUAL(field(m1, 116, 12), 854u); // COG
+    BOOST_CHECK_EQUAL(field(m1, 128, 9), 511u); // Heading
+
+    const std::string &m5 = msgs[5];
+    BOOST_CHECK_EQUAL(text(m5, 70, 7), "DABC");
+    BOOST_CHECK_EQUAL(text(m5, 112, 20), "TEST VESSEL");
+    BOOST_CHECK_EQUAL(field(m5, 232, 8), 70u);
+    BOOST_CHECK_EQUAL(field(m5, 240, 9), 50u); // To bow
+    BOOST_CHECK_EQUAL(field(m5, 249, 9), 50u); // To stern
+    BOOST_CHECK_EQUAL(field(m5, 258, 6), 10u); // To port
+    BOOST_CHECK_EQUAL(field(m5, 264, 6), 10u); // To starboard
+    BOOST_CHECK_EQUAL(field(m5, 274, 4), 6u); // ETA month
+    BOOST_CHECK_EQUAL(field(m5, 278, 5), 15u); // ETA day
+    BOOST_CHECK_EQUAL(field(m5, 283, 5), 12u); // ETA hour
+    BOOST_CHECK_EQUAL(field(m5, 288, 6), 30u); // ETA minute
+    BOOST_CHECK_EQUAL(field(m5, 294, 8), 75u); // Draught
+    BOOST_CHECK_EQUAL(text(m5, 302, 20), "HAMBURG");
+
+    const std::string &m18 = msgs[18];
+    BOOST_CHECK_EQUAL(field(m18, 46, 10), 123u);
+    BOOST_CHECK_EQUAL(signed_field(m18, 57, 28), -6150000);
+    BOOST_CHECK_EQUAL(signed_field(m18, 85, 27), 32700000);
+    BOOST_CHECK_EQUAL(field(m18, 112, 12), 854u);
+
+    BOOST_CHECK_EQUAL(field(msgs[24], 38, 2), 0u);
+    BOOST_CHECK_EQUAL(text(msgs[24], 40, 20), "TEST VESSEL");
+    BOOST_CHECK_EQUAL(field(msgs[0], 38, 2), 1u);
+    BOOST_CHECK_EQUAL(field(msgs[0], 40, 8), 70u);
+    BOOST_CHECK_EQUAL(text(msgs[0], 90, 7), "DABC");
+}
+
+BOOST_AUTO_TEST_CASE(test_vessel_store_deltas)
+{
+    vessel_store store;
+    vessel_state *v = apply(store, "MMSI 211000001: TYPES=1/5");
+    BOOST_REQUIRE(v);
+    BOOST_CHECK_EQUAL(flush(store, *v).size(), 2u);
+
+    // A field only dirties the enabled messages carrying it.
+    v = apply(store, "MMSI 211000001: SOG=3");
+    BOOST_REQUIRE(v);
+    std::map<int, std::string> msgs = flush(store, *v);
+    BOOST_REQUIRE_EQUAL(msgs.size(), 1u);
+    BOOST_CHECK(msgs.count(1));
+    v = apply(store, "MMSI 211000001: DEST=KIEL");
+    BOOST_REQUIRE(v);
+    msgs = flush(store, *v);
+    BOOST_REQUIRE_EQUAL(msgs.size(), 1u);
+    BOOST_CHECK(msgs.count(5));
+
+    // Refused messages stay dirty.
+    v = apply(store, "MMSI 211000001: SEND");
+    BOOST_REQUIRE(v);
+    BOOST_CHECK_EQUAL(store.flush(*v, [](std::string &&) { return false; }), 0);
+    BOOST_CHECK_EQUAL(flush(store, *v).size(), 2u);
+
+    // Malformed lines leave the vessel untouched.
+    std::string error;
+    const std::string bad = "MMSI 211000001: SOG=1, LAT=95";
+    BOOST_CHECK(!store.apply(bad.data(), bad.data() + bad.size(), error));
+    BOOST_CHECK(!error.empty());
+    BOOST_CHECK_EQUAL(store.find(211000001)->speed, 3);
+    error.clear();
+    const std::string unknown = "MMSI 211000001: COLOR=red";
+    BOOST_CHECK(!store.apply(unknown.data(), unknown.data() + unknown.size(), error));
+    BOOST_CHECK(!error.empty());
+
+    BOOST_CHECK(!apply(store, "MMSI 211000001: DELETE"));
+    BOOST_CHECK(!store.find(211000001));
+    BOOST_CHECK_EQUAL(store.size(), 0u);
+}
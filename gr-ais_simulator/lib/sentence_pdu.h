@@ -0,0 +1,122 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_SENTENCE_PDU_H
+#define INCLUDED_AIS_SIMULATOR_SENTENCE_PDU_H
+
+#include <pmt/pmt.h>
+#include "priority_lanes.h"
+#include <cstring>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * PDU published by the ingest blocks for one sentence, a "length"
+         * entry in the meta data and the sentence as u8vector. The length
+         * is propagated via tag in tagged stream. The "priority" entry, the
+         * class name as symbol, becomes a tag on the packet for
+         * bitstring_to_frame's priority lanes.
+         */
+        inline pmt::pmt_t make_sentence_pdu(const char *s, size_t l, priority_class c)
+        {
+            static const pmt::pmt_t length_key = pmt::string_to_symbol("length");
+            static const pmt::pmt_t priority_key = pmt::string_to_symbol("priority");
+            static const pmt::pmt_t names[] = { pmt::string_to_symbol(priority_name(PRIORITY_URGENT)),
+                                                pmt::string_to_symbol(priority_name(PRIORITY_NORMAL)),
+                                                pmt::string_to_symbol(priority_name(PRIORITY_BULK)) };
+            pmt::pmt_t d = pmt::dict_add(pmt::make_dict(), length_key, pmt::from_long(l));
+            d = pmt::dict_add(d, priority_key, names[c]);
+            return pmt::cons(d, pmt::init_u8vector(l, (const uint8_t *)s));
+        }
+
+        /*
+         * Class set by a "@priority <class>" first line of a batch, which is
+         * skipped. PRIORITY_CLASSES if there is none or it is unknown.
+         */
+        inline priority_class batch_priority(const char *&p, size_t &len)
+        {
+            if (len < 10 || std::memcmp(p, "@priority ", 10) != 0)
+            {
+                return PRIORITY_CLASSES;
+            }
+            const char *end = p + len;
+            const char *eol = (const char *)memchr(p, '\n', len);
+            eol = eol ? eol : end;
+            const char *name = p + 10;
+            const char *last = eol;
+            while (last > name && (last[-1] == '\r' || last[-1] == ' '))
+            {
+                last--;
+            }
+            const priority_class c = priority_from_name(name, last - name);
+            p = eol < end ? eol + 1 : end;
+            len = end - p;
+            return c;
+        }
+
+        /*
+         * Call fn(s, l) for every newline separated sentence in a batch, in
+         * place. Empty lines and a CR before the newline are dropped.
+         * Returns the number of sentences.
+         */
+        template <typename F>
+        long for_each_sentence(const char *p, size_t len, F fn)
+        {
+            long n = 0;
+            const char *end = p + len;
+            while (p < end)
+            {
+                const char *eol = (const char *)memchr(p, '\n', end - p);
+                const char *next = eol ? eol + 1 : end;
+                eol = eol ? eol : end;
+                if (eol > p && eol[-1] == '\r')
+                {
+                    eol--;
+                }
+                if (eol > p)
+                {
+                    fn(p, (size_t)(eol - p));
+                    n++;
+                }
+                p = next;
+            }
+            return n;
+        }
+
+        /*
+         * Same for a batch with an optional "@priority" first line. Calls
+         * fn(s, l, c) with the class it sets, else by message type.
+         */
+        template <typename F>
+        long for_each_batch_sentence(const char *p, size_t len, F fn)
+        {
+            const priority_class batch = batch_priority(p, len);
+            return for_each_sentence(p, len, [&fn, batch](const char *s, size_t l) {
+                fn(s, l, batch != PRIORITY_CLASSES ? batch : sentence_priority(s, l));
+            });
+        }
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_SENTENCE_PDU_H */
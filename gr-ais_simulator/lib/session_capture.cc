@@ -0,0 +1,201 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#include "session_capture.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        capture_writer::capture_writer(const std::string &path)
+            : d_file(std::fopen(path.c_str(), "wb")), d_start(std::chrono::steady_clock::now())
+        {
+            if (d_file == nullptr)
+            {
+                throw std::runtime_error("capture: " + path + ": " + std::strerror(errno));
+            }
+            std::setvbuf(d_file, nullptr, _IOFBF, 1 << 20);
+            const capture_header header = {
+                CAPTURE_MAGIC,
+                CAPTURE_VERSION,
+                (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch())
+                    .count()
+            };
+            if (std::fwrite(&header, sizeof(header), 1, d_file) != 1)
+            {
+                const int err = errno;
+                std::fclose(d_file);
+                throw std::runtime_error("capture: " + path + ": " + std::strerror(err));
+            }
+            d_thread = gr::thread::thread(boost::bind(&capture_writer::run, this));
+        }
+
+        capture_writer::~capture_writer()
+        {
+            {
+                std::lock_guard<std::mutex> lock(d_mutex);
+                d_stop = true;
+            }
+            d_cond.notify_one();
+            d_thread.join();
+            if (std::fclose(d_file) != 0)
+            {
+                failed("Close");
+            }
+            if (d_errors > 0)
+            {
+                std::cerr << "capture: " << d_errors << " file errors, the capture is incomplete\n";
+            }
+        }
+
+        /*
+         * Time stamp the message and hand it to the writer thread. Waits for
+         * the writer when the ring is full, keeps every message.
+         */
+        void capture_writer::record(const char *data, size_t len)
+        {
+            d_scratch.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now() - d_start)
+                                 .count();
+            d_scratch.data.assign(data, len);
+            while (!d_ring.push_swap(d_scratch))
+            {
+                std::this_thread::yield();
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (d_idle.load())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(d_mutex);
+                    d_wake = true;
+                }
+                d_cond.notify_one();
+            }
+        }
+
+        void capture_writer::write(const entry &e)
+        {
+            const uint32_t len = e.data.size();
+            if (d_failed)
+            {
+                d_errors++;
+                return;
+            }
+            if (std::fwrite(&e.time, sizeof(e.time), 1, d_file) != 1 ||
+                std::fwrite(&len, sizeof(len), 1, d_file) != 1 ||
+                std::fwrite(e.data.data(), 1, len, d_file) != len)
+            {
+                failed("Write");
+                return;
+            }
+            d_records++;
+        }
+
+        /*
+         * Count a failed file operation, report the first one. A partial
+         * record would misalign the rest of the log, stop writing.
+         */
+        void capture_writer::failed(const char *what)
+        {
+            d_failed = true;
+            if (d_errors++ == 0)
+            {
+                std::cerr << "capture: " << what << " failed: " << std::strerror(errno) << "\n";
+            }
+        }
+
+        /*
+         * Writer thread. Drains the ring into the stdio buffer and flushes
+         * whenever it runs empty.
+         */
+        void capture_writer::run()
+        {
+            gr::thread::set_thread_name(gr::thread::get_current_thread_id(), "ws_capture");
+            for (;;)
+            {
+                while (d_ring.pop_swap(d_entry))
+                {
+                    write(d_entry);
+                }
+                if (!d_failed && std::fflush(d_file) != 0)
+                {
+                    failed("Flush");
+                }
+                if (d_stop)
+                {
+                    break;
+                }
+
+                // Announce idle, then check once more for a push that missed it.
+                d_idle = true;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (d_ring.empty())
+                {
+                    std::unique_lock<std::mutex> lock(d_mutex);
+                    d_cond.wait_for(lock, std::chrono::milliseconds(100), [this] {
+                        return d_wake || d_stop;
+                    });
+                    d_wake = false;
+                }
+                d_idle = false;
+            }
+        }
+
+        capture_reader::capture_reader(const std::string &path) : d_file(std::fopen(path.c_str(), "rb"))
+        {
+            if (d_file == nullptr)
+            {
+                throw std::runtime_error("capture: " + path + ": " + std::strerror(errno));
+            }
+            if (std::fread(&d_header, sizeof(d_header), 1, d_file) != 1 ||
+                d_header.magic != CAPTURE_MAGIC || d_header.version != CAPTURE_VERSION)
+            {
+                std::fclose(d_file);
+                throw std::runtime_error("capture: " + path + ": Not a capture log");
+            }
+        }
+
+        capture_reader::~capture_reader()
+        {
+            std::fclose(d_file);
+        }
+
+        bool capture_reader::next(uint64_t &time, std::string &data)
+        {
+            uint32_t len;
+            if (std::fread(&time, sizeof(time), 1, d_file) != 1 ||
+                std::fread(&len, sizeof(len), 1, d_file) != 1 || len > CAPTURE_RECORD_MAX)
+            {
+                return false;
+            }
+            data.resize(len);
+            return std::fread(&data[0], 1, len, d_file) == len;
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
@@ -0,0 +1,132 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_SESSION_CAPTURE_H
+#define INCLUDED_AIS_SIMULATOR_SESSION_CAPTURE_H
+
+#include <gnuradio/thread/thread.h>
+#include "spsc_ring.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * Capture log of received websocket messages, for replay.
+         *
+         * Layout, host byte order, append only:
+         *
+         *   header   struct capture_header
+         *   records  uint64_t time, nanoseconds since start on the steady
+         *            clock, uint32_t length, then the message bytes
+         */
+        struct capture_header {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t start; // UNIX time of the capture start in nanoseconds
+        };
+
+        static const uint32_t CAPTURE_MAGIC = 0x50414357u; // "WCAP"
+        static const uint32_t CAPTURE_VERSION = 1u;
+        // Longest record, Beast's default websocket message limit.
+        static const uint32_t CAPTURE_RECORD_MAX = 16u << 20;
+
+        /*
+         * Writes the capture log from a background thread. The producer
+         * copies messages into recycled ring slots, no allocation in steady
+         * state. When the ring is full it waits, a capture never drops
+         * messages. After a failed write or flush nothing more is written,
+         * so the log stays readable up to there. Failures and the records
+         * not written are counted, the first failure and the total are
+         * reported on stderr.
+         */
+        class capture_writer
+        {
+        public:
+            // Throws std::runtime_error if the file can't be created.
+            explicit capture_writer(const std::string &path);
+            ~capture_writer();
+
+            // Queue one message, single producer.
+            void record(const char *data, size_t len);
+            uint64_t records() const { return d_records; }
+            uint64_t errors() const { return d_errors; }
+
+        private:
+            static const size_t RING_CAPACITY = 4096;
+
+            struct entry {
+                uint64_t time;
+                std::string data;
+            };
+
+            FILE *d_file;
+            const std::chrono::steady_clock::time_point d_start;
+            spsc_ring<entry> d_ring{ RING_CAPACITY };
+            entry d_scratch;                 // Producer
+            entry d_entry;                   // Writer thread
+            std::atomic<uint64_t> d_records{ 0 };
+            std::atomic<uint64_t> d_errors{ 0 };
+            bool d_failed = false; // Writer thread
+            gr::thread::thread d_thread;
+            std::mutex d_mutex;
+            std::condition_variable d_cond;
+            std::atomic<bool> d_idle{ false };
+            std::atomic<bool> d_stop{ false };
+            bool d_wake = false;
+
+            void run();
+            void write(const entry &e);
+            void failed(const char *what);
+        };
+
+        /*
+         * Reads a capture log record by record.
+         */
+        class capture_reader
+        {
+        public:
+            // Throws std::runtime_error if the file can't be read or is no
+            // capture log.
+            explicit capture_reader(const std::string &path);
+            ~capture_reader();
+
+            // Next record, false at the end of the log, a truncated record or
+            // one longer than CAPTURE_RECORD_MAX.
+            bool next(uint64_t &time, std::string &data);
+            uint64_t start() const { return d_header.start; }
+
+        private:
+            FILE *d_file;
+            capture_header d_header;
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_SESSION_CAPTURE_H */
@@ -0,0 +1,140 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_SHARD_MAP_H
+#define INCLUDED_AIS_SIMULATOR_SHARD_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <strings.h>
+#include <utility>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * MMSI to shard partition by consistent hashing.
+         *
+         * Every shard places vnodes points on a 64 bit hash ring, an MMSI
+         * belongs to the shard of the first point at or after its own hash.
+         * Points depend only on the shard index, so shards keep their index
+         * when more are added and adding one moves about 1/N of the MMSIs.
+         */
+        class shard_map
+        {
+        public:
+            shard_map(int shards, int vnodes = 64) : d_shards(shards)
+            {
+                d_ring.reserve((size_t)shards * vnodes);
+                for (int s = 0; s < shards; s++)
+                {
+                    for (int v = 0; v < vnodes; v++)
+                    {
+                        d_ring.emplace_back(mix((uint64_t)s << 32 | (uint32_t)v), s);
+                    }
+                }
+                std::sort(d_ring.begin(), d_ring.end());
+            }
+
+            int shards() const { return d_shards; }
+
+            int owner(uint32_t mmsi) const
+            {
+                if (d_ring.empty())
+                {
+                    return 0;
+                }
+                const uint64_t h = mix(mmsi);
+                auto it = std::lower_bound(
+                    d_ring.begin(), d_ring.end(), std::make_pair(h, 0));
+                return (it == d_ring.end() ? d_ring.front() : *it).second;
+            }
+
+            // splitmix64 finalizer, spreads sequential MMSIs over the ring.
+            static uint64_t mix(uint64_t x)
+            {
+                x ^= x >> 30;
+                x *= 0xbf58476d1ce4e5b9ull;
+                x ^= x >> 27;
+                x *= 0x94d049bb133111ebull;
+                return x ^ (x >> 31);
+            }
+
+        private:
+            int d_shards;
+            std::vector<std::pair<uint64_t, int>> d_ring;
+        };
+
+        /*
+         * MMSI of an AIS bit string, bits 8 to 37. False if the line is too
+         * short or holds anything but '0' and '1' there.
+         */
+        inline bool sentence_mmsi(const char *bits, size_t len, uint32_t &mmsi)
+        {
+            if (len < 38)
+            {
+                return false;
+            }
+            mmsi = 0;
+            for (int i = 0; i < 38; i++)
+            {
+                if (bits[i] != '0' && bits[i] != '1')
+                {
+                    return false;
+                }
+                if (i >= 8)
+                {
+                    mmsi = (mmsi << 1) | (bits[i] == '1');
+                }
+            }
+            return true;
+        }
+
+        // MMSI of a vessel state delta line, "MMSI <mmsi>: ...".
+        inline bool delta_mmsi(const char *line, size_t len, uint32_t &mmsi)
+        {
+            while (len > 0 && (*line == ' ' || *line == '\t'))
+            {
+                line++;
+                len--;
+            }
+            if (len < 6 || strncasecmp(line, "MMSI ", 5) != 0)
+            {
+                return false;
+            }
+            char *end;
+            const unsigned long v = std::strtoul(line + 5, &end, 10);
+            if (end == line + 5 || end > line + len || v == 0 || v > 999999999)
+            {
+                return false;
+            }
+            mmsi = (uint32_t)v;
+            return true;
+        }
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_SHARD_MAP_H */
@@ -0,0 +1,136 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_SPSC_RING_H
+#define INCLUDED_AIS_SIMULATOR_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * Lock-free single producer, single consumer ring buffer.
+         *
+         * Capacity is rounded up to a power of two. push() must only be called
+         * from one thread and pop() only from one other thread.
+         */
+        template <typename T>
+        class spsc_ring
+        {
+        private:
+            std::vector<T> d_items;
+            const size_t d_mask;
+            // Consumer and producer index on separate cache lines.
+            alignas(64) std::atomic<size_t> d_head{ 0 };
+            alignas(64) std::atomic<size_t> d_tail{ 0 };
+
+            static size_t round_up(size_t n)
+            {
+                size_t c = 1;
+                while (c < n)
+                {
+                    c <<= 1;
+                }
+                return c;
+            }
+
+        public:
+            explicit spsc_ring(size_t capacity)
+                : d_items(round_up(capacity)), d_mask(round_up(capacity) - 1)
+            {
+            }
+
+            size_t capacity() const { return d_mask + 1; }
+
+            // Number of items, exact for producer and consumer thread.
+            size_t size() const
+            {
+                return d_tail.load(std::memory_order_acquire) -
+                       d_head.load(std::memory_order_acquire);
+            }
+
+            bool empty() const { return size() == 0; }
+
+            // Producer side, false when full.
+            bool push(T &&item)
+            {
+                const size_t tail = d_tail.load(std::memory_order_relaxed);
+                if (tail - d_head.load(std::memory_order_acquire) > d_mask)
+                {
+                    return false;
+                }
+                d_items[tail & d_mask] = std::move(item);
+                d_tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            // Consumer side, false when empty.
+            bool pop(T &item)
+            {
+                const size_t head = d_head.load(std::memory_order_relaxed);
+                if (head == d_tail.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+                item = std::move(d_items[head & d_mask]);
+                d_head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+            /*
+             * Swapping variants of push() and pop(). The slot keeps what the
+             * caller held, so buffers with heap storage circulate between
+             * producer and consumer instead of being freed and reallocated.
+             */
+            bool push_swap(T &item)
+            {
+                const size_t tail = d_tail.load(std::memory_order_relaxed);
+                if (tail - d_head.load(std::memory_order_acquire) > d_mask)
+                {
+                    return false;
+                }
+                std::swap(d_items[tail & d_mask], item);
+                d_tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            bool pop_swap(T &item)
+            {
+                const size_t head = d_head.load(std::memory_order_relaxed);
+                if (head == d_tail.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+                std::swap(d_items[head & d_mask], item);
+                d_head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_SPSC_RING_H */
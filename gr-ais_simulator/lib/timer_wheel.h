@@ -0,0 +1,248 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_TIMER_WHEEL_H
+#define INCLUDED_AIS_SIMULATOR_TIMER_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * Hierarchical timer wheel, four levels of 256 slots.
+         *
+         * Time is counted in ticks. Level 0 holds entries expiring within the
+         * next 256 ticks, each higher level covers 256 times the range of the
+         * level below and cascades down when the lower level wraps. Insert and
+         * expiry are O(1) per entry, advance() skips ticks without work.
+         * Entries can be scheduled up to HORIZON ticks ahead. Not thread safe.
+         */
+        template <typename T>
+        class timer_wheel
+        {
+        public:
+            static constexpr int LEVELS = 4;
+            static constexpr int SLOT_BITS = 8;
+            static constexpr int SLOTS = 1 << SLOT_BITS;
+            static constexpr uint64_t HORIZON = (1ULL << (LEVELS * SLOT_BITS)) - 1;
+
+            explicit timer_wheel(uint64_t now = 0) : d_now(now) { clear(); }
+
+            uint64_t now() const { return d_now; }
+            size_t size() const { return d_size; }
+            bool empty() const { return d_size == 0; }
+
+            // Drop all entries.
+            void clear()
+            {
+                d_nodes.clear();
+                d_free = NIL;
+                d_size = 0;
+                for (auto &level : d_slots)
+                {
+                    for (auto &head : level)
+                    {
+                        head = NIL;
+                    }
+                }
+            }
+
+            /*
+             * Schedule value at given tick. Past ticks expire on the next
+             * advance, ticks beyond now() + HORIZON are clamped to it.
+             */
+            void insert(uint64_t expiry, T &&value)
+            {
+                uint32_t n;
+                if (d_free != NIL)
+                {
+                    n = d_free;
+                    d_free = d_nodes[n].next;
+                    d_nodes[n].value = std::move(value);
+                }
+                else
+                {
+                    n = (uint32_t)d_nodes.size();
+                    d_nodes.push_back(node{ 0, NIL, std::move(value) });
+                }
+                if (expiry > d_now && expiry - d_now > HORIZON)
+                {
+                    expiry = d_now + HORIZON;
+                }
+                d_nodes[n].expiry = expiry;
+                link(n, d_now + 1);
+                d_size++;
+            }
+
+            /*
+             * Advance to tick, call fire(expiry, value) for every expired
+             * entry. fire may insert new entries.
+             */
+            template <typename F>
+            void advance(uint64_t to, F &&fire)
+            {
+                while (d_now < to)
+                {
+                    // Skip ticks without expiry or cascade.
+                    uint64_t next;
+                    if (d_slots[0][slot(d_now + 1, 0)] == NIL && next_tick(next) && next > d_now + 1)
+                    {
+                        d_now = (next < to ? next : to) - 1;
+                    }
+                    d_now++;
+                    // Cascade higher levels first, their entries may land in the
+                    // lower level slot that is due now. Entries due now go into
+                    // the level 0 slot drained below.
+                    for (int level = LEVELS - 1; level > 0; level--)
+                    {
+                        const uint64_t mask = (1ULL << (level * SLOT_BITS)) - 1;
+                        if ((d_now & mask) == 0)
+                        {
+                            uint32_t n = take(level, slot(d_now, level));
+                            while (n != NIL)
+                            {
+                                const uint32_t next = d_nodes[n].next;
+                                link(n, d_now);
+                                n = next;
+                            }
+                        }
+                    }
+
+                    uint32_t n = take(0, slot(d_now, 0));
+                    while (n != NIL)
+                    {
+                        const uint32_t next = d_nodes[n].next;
+                        T value = std::move(d_nodes[n].value);
+                        const uint64_t expiry = d_nodes[n].expiry;
+                        d_nodes[n].next = d_free;
+                        d_free = n;
+                        d_size--;
+                        fire(expiry, std::move(value));
+                        n = next;
+                    }
+
+                    if (d_size == 0)
+                    {
+                        d_now = to;
+                    }
+                }
+            }
+
+            /*
+             * Earliest tick at which advance() has work, an expiry in level 0
+             * or a cascade of a higher level slot. Entries fire at or after
+             * it. Returns false when empty.
+             */
+            bool next_tick(uint64_t &tick) const
+            {
+                bool found = false;
+                uint64_t first = 0;
+                for (int level = 0; level < LEVELS; level++)
+                {
+                    const int shift = level * SLOT_BITS;
+                    const int cur = slot(d_now, level);
+                    for (int i = 1; i <= SLOTS; i++)
+                    {
+                        const int s = (cur + i) & (SLOTS - 1);
+                        if (d_slots[level][s] == NIL)
+                        {
+                            continue;
+                        }
+                        // Start of slot s in the next rotation of this level at
+                        // or after now. Only the top level holds entries of
+                        // the next rotation.
+                        const uint64_t span = 1ULL << (shift + SLOT_BITS);
+                        uint64_t t = (d_now & ~(span - 1)) + ((uint64_t)s << shift);
+                        if (cur + i >= SLOTS)
+                        {
+                            t += span;
+                        }
+                        if (!found || t < first)
+                        {
+                            first = t;
+                            found = true;
+                        }
+                        break;
+                    }
+                }
+                tick = first;
+                return found;
+            }
+
+        private:
+            static constexpr uint32_t NIL = ~0U;
+
+            struct node {
+                uint64_t expiry;
+                uint32_t next;
+                T value;
+            };
+
+            uint64_t d_now;
+            size_t d_size = 0;
+            std::vector<node> d_nodes;
+            uint32_t d_free = NIL;
+            uint32_t d_slots[LEVELS][SLOTS];
+
+            static int slot(uint64_t tick, int level)
+            {
+                return (int)((tick >> (level * SLOT_BITS)) & (SLOTS - 1));
+            }
+
+            uint32_t take(int level, int s)
+            {
+                const uint32_t n = d_slots[level][s];
+                d_slots[level][s] = NIL;
+                return n;
+            }
+
+            /*
+             * Put node into the lowest level whose range covers its expiry,
+             * earlier expiries are moved to earliest.
+             */
+            void link(uint32_t n, uint64_t earliest)
+            {
+                uint64_t expiry = d_nodes[n].expiry;
+                if (expiry < earliest)
+                {
+                    expiry = earliest;
+                }
+                const uint64_t diff = expiry ^ d_now;
+                int level = 0;
+                while (level < LEVELS - 1 && (diff >> ((level + 1) * SLOT_BITS)) != 0)
+                {
+                    level++;
+                }
+                uint32_t &head = d_slots[level][slot(expiry, level)];
+                d_nodes[n].next = head;
+                head = n;
+            }
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_TIMER_WHEEL_H */
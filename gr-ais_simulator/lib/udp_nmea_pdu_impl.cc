@@ -0,0 +1,248 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "sentence_pdu.h"
+#include "udp_nmea_pdu_impl.h"
+#include <netdb.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        udp_nmea_pdu::sptr
+        udp_nmea_pdu::make(std::string addr, std::string port, bool verify_checksum)
+        {
+            return gnuradio::get_initial_sptr(new udp_nmea_pdu_impl(addr, port, verify_checksum));
+        }
+
+        /*
+         * The private constructor
+         */
+        udp_nmea_pdu_impl::udp_nmea_pdu_impl(std::string addr, std::string port, bool verify_checksum)
+            : gr::block("udp_nmea_pdu",
+                        gr::io_signature::make(0, 0, 0),
+                        gr::io_signature::make(0, 0, 0)),
+              d_out_port(pmt::mp("out")),
+              d_assembler(verify_checksum),
+              d_pool(BATCH * DATAGRAM_SIZE),
+              d_msgs(BATCH),
+              d_iovecs(BATCH),
+              d_control(BATCH * CMSG_SPACE(sizeof(uint32_t)))
+        {
+            message_port_register_out(d_out_port);
+            try
+            {
+                open_socket(addr, port);
+            }
+            catch (...)
+            {
+                stop();
+                throw;
+            }
+
+            for (int i = 0; i < BATCH; i++)
+            {
+                d_iovecs[i].iov_base = &d_pool[i * DATAGRAM_SIZE];
+                d_iovecs[i].iov_len = DATAGRAM_SIZE;
+                d_msgs[i].msg_hdr.msg_iov = &d_iovecs[i];
+                d_msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            d_bits.reserve(1024);
+            d_thread = gr::thread::thread([this] { receive_loop(); });
+            d_started = true;
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        udp_nmea_pdu_impl::~udp_nmea_pdu_impl()
+        {
+            stop();
+        }
+
+        /*
+         * Stop receive thread when block stops.
+         */
+        bool udp_nmea_pdu_impl::stop()
+        {
+            if (d_started)
+            {
+                const uint64_t one = 1;
+                (void)!write(d_stop_fd, &one, sizeof(one));
+                d_thread.join();
+                d_started = false;
+            }
+            if (d_fd >= 0)
+            {
+                close(d_fd);
+                d_fd = -1;
+            }
+            if (d_stop_fd >= 0)
+            {
+                close(d_stop_fd);
+                d_stop_fd = -1;
+            }
+            return true;
+        }
+
+        /*
+         * Bind UDP socket with a large receive buffer. SO_RXQ_OVFL makes the
+         * kernel report its drop count with every datagram.
+         */
+        void udp_nmea_pdu_impl::open_socket(const std::string &addr, const std::string &port)
+        {
+            struct addrinfo hints;
+            struct addrinfo *res = nullptr;
+            memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_DGRAM;
+            hints.ai_flags = AI_PASSIVE;
+            const int rc = getaddrinfo(addr.empty() ? nullptr : addr.c_str(), port.c_str(), &hints, &res);
+            if (rc != 0)
+            {
+                throw std::invalid_argument("udp_nmea_pdu: Invalid address " + addr + ":" + port + ": " +
+                                            gai_strerror(rc));
+            }
+
+            d_stop_fd = eventfd(0, EFD_CLOEXEC);
+            d_fd = socket(res->ai_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+            const int one = 1;
+            const int rcvbuf = 8 << 20;
+            if (d_fd >= 0)
+            {
+                setsockopt(d_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+                setsockopt(d_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+                setsockopt(d_fd, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+            }
+            const bool ok = d_stop_fd >= 0 && d_fd >= 0 && bind(d_fd, res->ai_addr, res->ai_addrlen) == 0;
+            freeaddrinfo(res);
+            if (!ok)
+            {
+                throw std::runtime_error("udp_nmea_pdu: Failed to bind " + addr + ":" + port + ": " +
+                                         strerror(errno));
+            }
+        }
+
+        /*
+         * Drain the socket in batches, then wait for more.
+         */
+        void udp_nmea_pdu_impl::receive_loop()
+        {
+            struct pollfd fds[2] = { { d_stop_fd, POLLIN, 0 }, { d_fd, POLLIN, 0 } };
+            const size_t control_size = CMSG_SPACE(sizeof(uint32_t));
+
+            for (;;)
+            {
+                if (poll(fds, 2, -1) < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    std::cerr << "udp_nmea_pdu: poll: " << strerror(errno) << "\n";
+                    return;
+                }
+                if (fds[0].revents)
+                {
+                    return;
+                }
+
+                int n;
+                do
+                {
+                    for (int i = 0; i < BATCH; i++)
+                    {
+                        d_msgs[i].msg_hdr.msg_control = &d_control[i * control_size];
+                        d_msgs[i].msg_hdr.msg_controllen = control_size;
+                    }
+                    n = recvmmsg(d_fd, d_msgs.data(), BATCH, MSG_DONTWAIT, nullptr);
+                    for (int i = 0; i < n; i++)
+                    {
+                        struct msghdr &h = d_msgs[i].msg_hdr;
+                        for (struct cmsghdr *c = CMSG_FIRSTHDR(&h); c; c = CMSG_NXTHDR(&h, c))
+                        {
+                            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL)
+                            {
+                                uint32_t drops;
+                                memcpy(&drops, CMSG_DATA(c), sizeof(drops));
+                                d_dropped = drops;
+                            }
+                        }
+                        if (h.msg_flags & MSG_TRUNC)
+                        {
+                            d_errors++;
+                            continue;
+                        }
+                        // One bad datagram must not take the receive thread down.
+                        try
+                        {
+                            handle_datagram((const char *)d_iovecs[i].iov_base, d_msgs[i].msg_len);
+                        }
+                        catch (const std::exception &e)
+                        {
+                            std::cerr << "udp_nmea_pdu: Dropped datagram: " << e.what() << "\n";
+                            d_errors++;
+                        }
+                    }
+                } while (n == BATCH);
+            }
+        }
+
+        /*
+         * A datagram holds one or more sentences, one per line.
+         */
+        void udp_nmea_pdu_impl::handle_datagram(const char *p, size_t len)
+        {
+            for_each_sentence(p, len, [this](const char *s, size_t l) {
+                switch (d_assembler.feed(s, l, d_bits))
+                {
+                case nmea_assembler::COMPLETE:
+                    message_port_pub(d_out_port,
+                                     make_sentence_pdu(d_bits.data(),
+                                                       d_bits.size(),
+                                                       sentence_priority(d_bits.data(), d_bits.size())));
+                    d_sentences++;
+                    break;
+                case nmea_assembler::BAD_CHECKSUM:
+                case nmea_assembler::MALFORMED:
+                    d_errors++;
+                    break;
+                default:
+                    break;
+                }
+            });
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
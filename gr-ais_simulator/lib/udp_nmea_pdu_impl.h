@@ -0,0 +1,76 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_UDP_NMEA_PDU_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_UDP_NMEA_PDU_IMPL_H
+
+#include <gnuradio/ais_simulator/udp_nmea_pdu.h>
+#include <gnuradio/thread/thread.h>
+#include "nmea_assembler.h"
+#include <sys/socket.h>
+#include <atomic>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        class udp_nmea_pdu_impl : public udp_nmea_pdu
+        {
+        private:
+            // Datagrams per recvmmsg() call and largest datagram.
+            static const int BATCH = 64;
+            static const size_t DATAGRAM_SIZE = 4096;
+
+            const pmt::pmt_t d_out_port;
+            nmea_assembler d_assembler;
+            int d_fd = -1;
+            int d_stop_fd = -1;
+            // Preallocated receive buffers, reused for every batch.
+            std::vector<char> d_pool;
+            std::vector<struct mmsghdr> d_msgs;
+            std::vector<struct iovec> d_iovecs;
+            std::vector<char> d_control;
+            std::string d_bits;
+            std::atomic<uint64_t> d_sentences{ 0 };
+            std::atomic<uint64_t> d_dropped{ 0 };
+            std::atomic<uint64_t> d_errors{ 0 };
+            gr::thread::thread d_thread;
+            bool d_started = false;
+
+            void open_socket(const std::string &addr, const std::string &port);
+            void receive_loop();
+            void handle_datagram(const char *p, size_t len);
+
+        public:
+            udp_nmea_pdu_impl(std::string addr, std::string port, bool verify_checksum);
+            ~udp_nmea_pdu_impl();
+            bool stop();
+
+            uint64_t sentences() const { return d_sentences; }
+            uint64_t dropped() const { return d_dropped; }
+            uint64_t errors() const { return d_errors; }
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_UDP_NMEA_PDU_IMPL_H */
@@ -0,0 +1,233 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_VDL_LOAD_H
+#define INCLUDED_AIS_SIMULATOR_VDL_LOAD_H
+
+#include "frame_builder.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * Channel load over a sliding window of whole seconds.
+         *
+         * A ring holds one bucket of counters per second, the window totals
+         * are kept up to date as frames come in and buckets expire. Stations
+         * live in an open addressing table of fixed size, probing at most
+         * MAX_PROBE slots, with the second they were last heard. Each bucket
+         * counts the stations last heard in its second, so the number of
+         * stations within the window drops as buckets expire. Expired table
+         * entries are reused. Updates are O(1) per frame. Not thread safe.
+         */
+        class vdl_load
+        {
+        public:
+            static constexpr int SLOTS_MAX = 5;
+            static constexpr int SLOTS_PER_MINUTE = 2250;
+
+            struct counters {
+                uint64_t frames = 0;
+                uint64_t slots = 0;
+                uint64_t air_bits = 0; // Preamble to end mark, stuffing included
+                uint64_t stuffing_bits = 0;
+                uint64_t histogram[SLOTS_MAX] = {}; // Frames taking 1 to 5 slots
+            };
+
+            vdl_load(int window, int max_stations)
+                : d_window(std::max(window, 1)), d_buckets(d_window)
+            {
+                size_t size = 16;
+                d_shift = 28;
+                while (size < 2 * (size_t)std::max(max_stations, 1))
+                {
+                    size *= 2;
+                    d_shift--;
+                }
+                d_table.resize(size);
+            }
+
+            /*
+             * Slots taken by a frame with given payload length, one for up
+             * to 168 bits and one more for each further 256 bits.
+             */
+            static int slots(int payload_bits)
+            {
+                const int n = payload_bits <= framing::LEN_SLOT_PAYLOAD
+                                  ? 1
+                                  : 2 + (payload_bits - framing::LEN_SLOT_PAYLOAD - 1) /
+                                            framing::LEN_FRAME_MAX;
+                return std::min(n, (int)SLOTS_MAX);
+            }
+
+            /*
+             * Move the window end to second. Time going backwards keeps the
+             * current second.
+             */
+            void advance(int64_t second)
+            {
+                if (!d_started)
+                {
+                    d_started = true;
+                    d_first = d_now = second;
+                    return;
+                }
+                if (second <= d_now)
+                {
+                    return;
+                }
+                const int64_t steps = std::min<int64_t>(second - d_now, d_window);
+                for (int64_t s = second - steps + 1; s <= second; s++)
+                {
+                    expire(d_buckets[index(s)]);
+                }
+                d_now = second;
+            }
+
+            // Count a frame of given payload and stuffing bits, sent by mmsi.
+            void add(int64_t second, uint32_t mmsi, int payload_bits, int stuffing_bits)
+            {
+                advance(second);
+                bucket &b = d_buckets[index(d_now)];
+                const int n = slots(payload_bits);
+                const uint64_t bits = framing::LEN_PREAMBLE + 2 * framing::LEN_START +
+                                      payload_bits + framing::LEN_CRC + stuffing_bits;
+                for (counters *c : { static_cast<counters *>(&b), &d_totals })
+                {
+                    c->frames++;
+                    c->slots += n;
+                    c->air_bits += bits;
+                    c->stuffing_bits += stuffing_bits;
+                    c->histogram[n - 1]++;
+                }
+                heard(mmsi, b);
+            }
+
+            // Totals within the window.
+            const counters &totals() const { return d_totals; }
+            int window() const { return d_window; }
+            // Seconds the window covers so far, at most window().
+            int seconds() const
+            {
+                return d_started ? (int)std::min<int64_t>(d_now - d_first + 1, d_window) : 0;
+            }
+            int stations() const { return d_stations; }
+            uint64_t stations_dropped() const { return d_dropped; }
+
+        private:
+            static constexpr int MAX_PROBE = 16;
+
+            struct bucket : counters {
+                uint32_t last_heard = 0; // Stations last heard in this second
+            };
+            struct station {
+                uint32_t mmsi = 0; // 0 = empty, MMSI 0 is invalid
+                int64_t last = 0;  // Second last heard
+            };
+
+            const int d_window;
+            std::vector<bucket> d_buckets;
+            counters d_totals;
+            std::vector<station> d_table;
+            unsigned d_shift;
+            int d_stations = 0;
+            uint64_t d_dropped = 0;
+            bool d_started = false;
+            int64_t d_first = 0;
+            int64_t d_now = 0;
+
+            size_t index(int64_t second) const
+            {
+                const int64_t i = second % d_window;
+                return i < 0 ? i + d_window : i;
+            }
+
+            void expire(bucket &b)
+            {
+                d_totals.frames -= b.frames;
+                d_totals.slots -= b.slots;
+                d_totals.air_bits -= b.air_bits;
+                d_totals.stuffing_bits -= b.stuffing_bits;
+                for (int i = 0; i < SLOTS_MAX; i++)
+                {
+                    d_totals.histogram[i] -= b.histogram[i];
+                }
+                d_stations -= b.last_heard;
+                b = bucket();
+            }
+
+            void heard(uint32_t mmsi, bucket &b)
+            {
+                if (mmsi == 0)
+                {
+                    return;
+                }
+                const int64_t oldest = d_now - d_window; // Expired at or before
+                const size_t mask = d_table.size() - 1;
+                size_t i = (mmsi * 2654435761u) >> d_shift;
+                station *free = nullptr;
+                for (int p = 0; p < MAX_PROBE; p++, i = (i + 1) & mask)
+                {
+                    station &s = d_table[i];
+                    if (s.mmsi == mmsi)
+                    {
+                        if (s.last > oldest)
+                        {
+                            d_buckets[index(s.last)].last_heard--;
+                        }
+                        else
+                        {
+                            d_stations++;
+                        }
+                        s.last = d_now;
+                        b.last_heard++;
+                        return;
+                    }
+                    if (free == nullptr && (s.mmsi == 0 || s.last <= oldest))
+                    {
+                        free = &s;
+                    }
+                    if (s.mmsi == 0)
+                    {
+                        break;
+                    }
+                }
+                if (free == nullptr)
+                {
+                    d_dropped++;
+                    return;
+                }
+                free->mmsi = mmsi;
+                free->last = d_now;
+                d_stations++;
+                b.last_heard++;
+            }
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_VDL_LOAD_H */
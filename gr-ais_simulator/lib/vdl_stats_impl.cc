@@ -0,0 +1,239 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gnuradio/io_signature.h>
+#include "vdl_stats_impl.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        vdl_stats::sptr vdl_stats::make(bool enable_nrzi,
+                                        const std::string &len_tag_key,
+                                        char channel,
+                                        double baud_rate,
+                                        int window,
+                                        double report_interval,
+                                        int max_stations,
+                                        frame_format format)
+        {
+            return gnuradio::get_initial_sptr(new vdl_stats_impl(
+                enable_nrzi, len_tag_key, channel, baud_rate, window, report_interval, max_stations, format));
+        }
+
+        /*
+         * The private constructor
+         */
+        vdl_stats_impl::vdl_stats_impl(bool enable_nrzi,
+                                       const std::string &len_tag_key,
+                                       char channel,
+                                       double baud_rate,
+                                       int window,
+                                       double report_interval,
+                                       int max_stations,
+                                       frame_format format)
+            : gr::sync_block("vdl_stats",
+                             gr::io_signature::make(1, 1, sizeof(unsigned char)),
+                             gr::io_signature::make(0, 1, sizeof(unsigned char))),
+              d_stats_port(pmt::mp("stats")),
+              d_len_tag_key(pmt::mp(len_tag_key)),
+              d_time_key(pmt::mp("time")),
+              d_nrzi(enable_nrzi),
+              d_item_bits(format == FRAME_PACKED ? 8 : 1),
+              d_channel(channel),
+              d_baud_rate(baud_rate),
+              d_report_interval(report_interval),
+              d_load(window, max_stations)
+        {
+            if (baud_rate <= 0 || window < 1 || window > 3600 || report_interval < 0 ||
+                max_stations < 1 || (format != FRAME_PACKED && format != FRAME_UNPACKED))
+            {
+                throw std::invalid_argument(
+                    "vdl_stats: Invalid baud rate, window, report interval, station count or input format");
+            }
+            message_port_register_out(d_stats_port);
+        }
+
+        /*
+         * Our virtual destructor.
+         */
+        vdl_stats_impl::~vdl_stats_impl() {}
+
+        std::vector<uint64_t> vdl_stats_impl::slot_histogram() const
+        {
+            std::vector<uint64_t> h(vdl_load::SLOTS_MAX);
+            for (int i = 0; i < vdl_load::SLOTS_MAX; i++)
+            {
+                h[i] = d_histogram[i];
+            }
+            return h;
+        }
+
+        /*
+         * Count a deframed payload and update the getter snapshot.
+         */
+        void vdl_stats_impl::add_frame(const uint8_t *payload, int len)
+        {
+            d_decoded = true;
+            // MMSI is payload bits 8 to 37 for all message types.
+            const uint32_t mmsi =
+                len >= 5 ? (payload[1] << 22) | (payload[2] << 14) | (payload[3] << 6) | (payload[4] >> 2)
+                         : 0;
+            const int stuffing = framing::stuffing_bits(payload, len, framing::crc16(payload, len));
+            d_load.add((int64_t)std::floor(d_frame_time), mmsi, len * 8, stuffing);
+            d_frames++;
+
+            const vdl_load::counters &c = d_load.totals();
+            const int seconds = d_load.seconds();
+            d_slots_per_minute = c.slots * 60.0 / seconds;
+            d_air_time = c.air_bits / (seconds * d_baud_rate);
+            d_stations = d_load.stations();
+            d_stations_dropped = d_load.stations_dropped();
+            for (int i = 0; i < vdl_load::SLOTS_MAX; i++)
+            {
+                d_histogram[i].store(c.histogram[i], std::memory_order_relaxed);
+            }
+
+            if (d_report_interval > 0)
+            {
+                if (d_next_report < 0)
+                {
+                    d_next_report = d_frame_time + d_report_interval;
+                }
+                else if (d_frame_time >= d_next_report)
+                {
+                    report();
+                    d_next_report = d_frame_time + d_report_interval;
+                }
+            }
+        }
+
+        /*
+         * Publish window statistics on the "stats" port.
+         */
+        void vdl_stats_impl::report()
+        {
+            const vdl_load::counters &c = d_load.totals();
+            pmt::pmt_t meta = pmt::make_dict();
+            meta = pmt::dict_add(meta, pmt::mp("channel"), pmt::mp(std::string(1, d_channel)));
+            meta = pmt::dict_add(meta, pmt::mp("time"), pmt::from_double(d_frame_time));
+            meta = pmt::dict_add(meta, pmt::mp("window"), pmt::from_long(d_load.seconds()));
+            meta = pmt::dict_add(meta, pmt::mp("frames"), pmt::from_uint64(c.frames));
+            meta = pmt::dict_add(meta, pmt::mp("slots_per_minute"), pmt::from_double(slots_per_minute()));
+            meta = pmt::dict_add(meta, pmt::mp("slot_occupancy"), pmt::from_double(slot_occupancy()));
+            meta = pmt::dict_add(meta, pmt::mp("air_time"), pmt::from_double(air_time()));
+            meta = pmt::dict_add(meta, pmt::mp("stuffing_bits"), pmt::from_uint64(c.stuffing_bits));
+            meta = pmt::dict_add(meta, pmt::mp("stations"), pmt::from_long(d_load.stations()));
+            meta = pmt::dict_add(
+                meta, pmt::mp("stations_dropped"), pmt::from_uint64(d_load.stations_dropped()));
+            message_port_pub(d_stats_port,
+                             pmt::cons(meta, pmt::init_u64vector(vdl_load::SLOTS_MAX, c.histogram)));
+        }
+
+        /*
+         * Deframe each frame as it passes, at the frame end count it.
+         */
+        int vdl_stats_impl::work(int noutput_items,
+                                 gr_vector_const_void_star &input_items,
+                                 gr_vector_void_star &output_items)
+        {
+            const uint8_t *in = (const uint8_t *)input_items[0];
+            const uint64_t n0 = nitems_read(0);
+            if (!output_items.empty())
+            {
+                std::memcpy(output_items[0], in, noutput_items);
+            }
+
+            get_tags_in_range(d_tags, 0, n0, n0 + noutput_items, d_len_tag_key);
+            get_tags_in_range(d_time_tags, 0, n0, n0 + noutput_items, d_time_key);
+            size_t t = 0;
+            size_t tt = 0;
+            int i = 0;
+            while (i < noutput_items)
+            {
+                if (d_remaining == 0)
+                {
+                    // Skip to the next frame start.
+                    if (t == d_tags.size())
+                    {
+                        break;
+                    }
+                    const gr::tag_t &tag = d_tags[t++];
+                    const long len = pmt::to_long(tag.value);
+                    i = tag.offset - n0;
+                    if (len <= 0)
+                    {
+                        continue;
+                    }
+                    // Frames start with NRZI line state zero.
+                    d_deframer = framing::hdlc_deframer();
+                    d_level = 0;
+                    d_decoded = false;
+                    d_remaining = len;
+                    d_frame_time = std::chrono::duration<double>(
+                                       std::chrono::system_clock::now().time_since_epoch())
+                                       .count();
+                    while (tt < d_time_tags.size() && d_time_tags[tt].offset < tag.offset)
+                    {
+                        tt++;
+                    }
+                    if (tt < d_time_tags.size() && d_time_tags[tt].offset == tag.offset &&
+                        pmt::is_number(d_time_tags[tt].value))
+                    {
+                        d_frame_time = pmt::to_double(d_time_tags[tt].value);
+                    }
+                }
+
+                const int n = std::min(d_remaining, noutput_items - i);
+                for (int k = 0; k < n && !d_decoded; k++)
+                {
+                    for (int b = d_item_bits - 1; b >= 0; b--)
+                    {
+                        // Without NRZI the deframer gets the line levels NRZI would produce.
+                        const unsigned bit = (in[i + k] >> b) & 1;
+                        d_level = d_nrzi ? bit : d_level ^ !bit;
+                        d_deframer.push(d_level, [this](const uint8_t *payload, int len) {
+                            add_frame(payload, len);
+                        });
+                    }
+                }
+                d_remaining -= n;
+                i += n;
+                if (d_remaining == 0 && !d_decoded)
+                {
+                    d_errors++;
+                }
+            }
+
+            return noutput_items;
+        }
+
+    } /* namespace ais_simulator */
+} /* namespace gr */
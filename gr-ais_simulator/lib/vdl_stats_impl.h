@@ -0,0 +1,98 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef INCLUDED_AIS_SIMULATOR_VDL_STATS_IMPL_H
+#define INCLUDED_AIS_SIMULATOR_VDL_STATS_IMPL_H
+
+#include <gnuradio/ais_simulator/vdl_stats.h>
+#include "hdlc_deframer.h"
+#include "vdl_load.h"
+#include <atomic>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+
+        class vdl_stats_impl : public vdl_stats
+        {
+        private:
+            const pmt::pmt_t d_stats_port;
+            const pmt::pmt_t d_len_tag_key;
+            const pmt::pmt_t d_time_key;
+            const bool d_nrzi;
+            const int d_item_bits; // 8 packed, 1 unpacked
+            const char d_channel;
+            const double d_baud_rate;
+            const double d_report_interval;
+            std::vector<gr::tag_t> d_tags;
+            std::vector<gr::tag_t> d_time_tags;
+
+            // Frame being deframed, it may span several work() calls.
+            framing::hdlc_deframer d_deframer;
+            unsigned d_level = 0;
+            int d_remaining = 0;
+            bool d_decoded = false;
+            double d_frame_time = 0;
+
+            vdl_load d_load;
+            double d_next_report = -1;
+
+            // Snapshot for the getters, written by the stream thread only.
+            std::atomic<uint64_t> d_frames{ 0 };
+            std::atomic<uint64_t> d_errors{ 0 };
+            std::atomic<double> d_slots_per_minute{ 0 };
+            std::atomic<double> d_air_time{ 0 };
+            std::atomic<int> d_stations{ 0 };
+            std::atomic<uint64_t> d_stations_dropped{ 0 };
+            std::atomic<uint64_t> d_histogram[vdl_load::SLOTS_MAX] = {};
+
+            void add_frame(const uint8_t *payload, int len);
+            void report();
+
+        public:
+            vdl_stats_impl(bool enable_nrzi,
+                           const std::string &len_tag_key,
+                           char channel,
+                           double baud_rate,
+                           int window,
+                           double report_interval,
+                           int max_stations,
+                           frame_format format);
+            ~vdl_stats_impl();
+
+            uint64_t frames() const { return d_frames; }
+            uint64_t errors() const { return d_errors; }
+            double slots_per_minute() const { return d_slots_per_minute; }
+            double slot_occupancy() const { return d_slots_per_minute / vdl_load::SLOTS_PER_MINUTE; }
+            double air_time() const { return d_air_time; }
+            int stations() const { return d_stations; }
+            uint64_t stations_dropped() const { return d_stations_dropped; }
+            std::vector<uint64_t> slot_histogram() const;
+
+            int work(int noutput_items,
+                     gr_vector_const_void_star &input_items,
+                     gr_vector_void_star &output_items);
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_VDL_STATS_IMPL_H */
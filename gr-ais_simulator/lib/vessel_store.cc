@@ -0,0 +1,607 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "vessel_store.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        namespace
+        {
+            constexpr uint32_t bit(int type) { return 1u << type; }
+
+            // Messages carrying a field, marked dirty when it changes.
+            constexpr uint32_t MSGS_POSITION = bit(1) | bit(4) | bit(9) | bit(18) | bit(19) | bit(21) | bit(27);
+            constexpr uint32_t MSGS_MOTION = bit(1) | bit(9) | bit(18) | bit(19) | bit(27);
+            constexpr uint32_t MSGS_STATUS = bit(1) | bit(27);
+            constexpr uint32_t MSGS_NAME = bit(5) | bit(19) | bit(21) | bit(24);
+            constexpr uint32_t MSGS_CALLSIGN = bit(5) | bit(vessel_store::MSG_24B);
+            constexpr uint32_t MSGS_SHIP_TYPE = bit(5) | bit(19) | bit(vessel_store::MSG_24B);
+            constexpr uint32_t MSGS_SIZE = bit(5) | bit(19) | bit(21) | bit(vessel_store::MSG_24B);
+
+            const char SIXBIT[] = "@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^- !\"#$%&'()*+,-./0123456789:;<=>?";
+
+            // Append n bits of value, MSB first.
+            void put(std::string &bits, uint32_t value, int n)
+            {
+                while (n-- > 0)
+                {
+                    bits.push_back((value >> n) & 1 ? '1' : '0');
+                }
+            }
+
+            // Append text as six-bit characters, cut or padded with '@' to chars.
+            void put_text(std::string &bits, const std::string &text, size_t chars)
+            {
+                for (size_t i = 0; i < chars; i++)
+                {
+                    uint32_t c = 0;
+                    if (i < text.size())
+                    {
+                        const char *p = strchr(SIXBIT, toupper((unsigned char)text[i]));
+                        c = p && *p ? (uint32_t)(p - SIXBIT) : 0;
+                    }
+                    put(bits, c, 6);
+                }
+            }
+
+            void put_header(std::string &bits, int type, uint32_t mmsi)
+            {
+                put(bits, type, 6);
+                put(bits, 3, 2); // Repeat indicator, do not repeat
+                put(bits, mmsi, 30);
+            }
+
+            // Position in 1/10000 minutes.
+            void put_position(std::string &bits, const vessel_state &v)
+            {
+                put(bits, (uint32_t)std::lround(v.lon * 600000), 28);
+                put(bits, (uint32_t)std::lround(v.lat * 600000), 27);
+            }
+
+            // Position in 1/10 minutes.
+            void put_position_short(std::string &bits, const vessel_state &v)
+            {
+                put(bits, (uint32_t)std::lround(v.lon * 600), 18);
+                put(bits, (uint32_t)std::lround(v.lat * 600), 17);
+            }
+
+            // Speed over ground in 0.1 knots, 1023 = not available.
+            void put_speed(std::string &bits, const vessel_state &v)
+            {
+                uint32_t sog = 1023;
+                if (v.speed >= 0)
+                {
+                    sog = v.speed < 102.2 ? (uint32_t)std::lround(v.speed * 10) : 1022;
+                }
+                put(bits, sog, 10);
+            }
+
+            // Course over ground in 0.1 degrees, 3600 = not available.
+            void put_course(std::string &bits, const vessel_state &v)
+            {
+                put(bits, v.course >= 0 && v.course < 360 ? (uint32_t)std::lround(v.course * 10) : 3600, 12);
+            }
+
+            // Vessel dimensions, AIS antenna in the middle.
+            void put_size(std::string &bits, int length, int beam)
+            {
+                const uint32_t half_length = std::min((length + 1) / 2, 511);
+                const uint32_t half_beam = std::min((beam + 1) / 2, 63);
+                put(bits, half_length, 9);
+                put(bits, half_length, 9);
+                put(bits, half_beam, 6);
+                put(bits, half_beam, 6);
+            }
+
+            // Communication state, see ITU-R M1371-5 §4.2.2.5
+            void put_radio_status(std::string &bits) { put(bits, 0x60006, 19); }
+
+            bool key_is(const char *key, size_t len, const char *name)
+            {
+                return strlen(name) == len && strncasecmp(key, name, len) == 0;
+            }
+
+            bool parse_double(const std::string &value, double &d)
+            {
+                char *end;
+                d = strtod(value.c_str(), &end);
+                return !value.empty() && *end == '\0' && std::isfinite(d);
+            }
+
+            bool parse_int(const std::string &value, long lo, long hi, int &i)
+            {
+                char *end;
+                const long l = strtol(value.c_str(), &end, 10);
+                i = (int)l;
+                return !value.empty() && *end == '\0' && l >= lo && l <= hi;
+            }
+        } // namespace
+
+        vessel_store::vessel_store() : d_slots(64, slot{ 0, 0 }), d_shift(32 - 6) {}
+
+        /*
+         * Fibonacci hashing, MMSIs of one fleet are often sequential.
+         */
+        size_t vessel_store::home(uint32_t mmsi) const
+        {
+            return (uint32_t)(mmsi * 2654435769u) >> d_shift;
+        }
+
+        vessel_state *vessel_store::find(uint32_t mmsi)
+        {
+            const size_t mask = d_slots.size() - 1;
+            for (size_t i = home(mmsi); d_slots[i].mmsi; i = (i + 1) & mask)
+            {
+                if (d_slots[i].mmsi == mmsi)
+                {
+                    return &d_vessels[d_slots[i].index];
+                }
+            }
+            return nullptr;
+        }
+
+        vessel_state &vessel_store::insert(uint32_t mmsi)
+        {
+            if ((d_vessels.size() + 1) * 2 > d_slots.size())
+            {
+                grow();
+            }
+            const size_t mask = d_slots.size() - 1;
+            size_t i = home(mmsi);
+            for (; d_slots[i].mmsi; i = (i + 1) & mask)
+            {
+                if (d_slots[i].mmsi == mmsi)
+                {
+                    return d_vessels[d_slots[i].index];
+                }
+            }
+            d_slots[i] = slot{ mmsi, (uint32_t)d_vessels.size() };
+            d_vessels.emplace_back();
+            d_vessels.back().mmsi = mmsi;
+            return d_vessels.back();
+        }
+
+        /*
+         * Remove with backward shift, no tombstones. The last vessel moves
+         * into the freed index to keep the state vector dense.
+         */
+        bool vessel_store::erase(uint32_t mmsi)
+        {
+            const size_t mask = d_slots.size() - 1;
+            size_t i = home(mmsi);
+            for (; d_slots[i].mmsi != mmsi; i = (i + 1) & mask)
+            {
+                if (!d_slots[i].mmsi)
+                {
+                    return false;
+                }
+            }
+
+            const uint32_t index = d_slots[i].index;
+            if (index + 1 != d_vessels.size())
+            {
+                d_vessels[index] = std::move(d_vessels.back());
+                size_t j = home(d_vessels[index].mmsi);
+                while (d_slots[j].mmsi != d_vessels[index].mmsi)
+                {
+                    j = (j + 1) & mask;
+                }
+                d_slots[j].index = index;
+            }
+            d_vessels.pop_back();
+
+            for (size_t j = (i + 1) & mask; d_slots[j].mmsi; j = (j + 1) & mask)
+            {
+                // Move entries whose home is not cyclically within (i, j].
+                const size_t k = home(d_slots[j].mmsi);
+                if ((i < j) ? (k <= i || k > j) : (k <= i && k > j))
+                {
+                    d_slots[i] = d_slots[j];
+                    i = j;
+                }
+            }
+            d_slots[i].mmsi = 0;
+            return true;
+        }
+
+        void vessel_store::grow()
+        {
+            std::vector<slot> old(d_slots.size() * 2, slot{ 0, 0 });
+            old.swap(d_slots);
+            d_shift--;
+            const size_t mask = d_slots.size() - 1;
+            for (const slot &s : old)
+            {
+                if (s.mmsi)
+                {
+                    size_t i = home(s.mmsi);
+                    while (d_slots[i].mmsi)
+                    {
+                        i = (i + 1) & mask;
+                    }
+                    d_slots[i] = s;
+                }
+            }
+        }
+
+        /*
+         * Parse "MMSI <mmsi>: <field>=<value>, ..." into a copy of the vessel
+         * state, so a malformed line leaves the store untouched. Fields:
+         *   TYPES=1/5/24  enabled messages, also marks them dirty
+         *   STATUS, SOG, COG, LAT, LON, ALT, SHIPTYPE, LENGTH, BEAM, DRAUGHT,
+         *   ETA=MM-DD HH:MM, NAME, CALLSIGN, DEST, AIDTYPE, VIRTUAL=0/1
+         *   SEND          marks all enabled messages dirty
+         *   DELETE        removes the vessel
+         */
+        vessel_state *vessel_store::apply(const char *begin, const char *end, std::string &error)
+        {
+            while (begin < end && isspace((unsigned char)*begin))
+            {
+                begin++;
+            }
+            if (begin == end)
+            {
+                return nullptr;
+            }
+            const char *colon = (const char *)memchr(begin, ':', end - begin);
+            if (end - begin < 5 || strncasecmp(begin, "MMSI ", 5) != 0 || !colon)
+            {
+                error = "expected MMSI <mmsi>:";
+                return nullptr;
+            }
+            int mmsi;
+            if (!parse_int(std::string(begin + 5, colon), 1, 999999999, mmsi))
+            {
+                error = "invalid MMSI";
+                return nullptr;
+            }
+
+            const vessel_state *current = find(mmsi);
+            vessel_state v = current ? *current : vessel_state();
+            v.mmsi = mmsi;
+            if (!current)
+            {
+                v.dirty = v.types;
+            }
+
+            for (const char *p = colon + 1; p < end;)
+            {
+                const char *field_end = (const char *)memchr(p, ',', end - p);
+                field_end = field_end ? field_end : end;
+                const char *eq = (const char *)memchr(p, '=', field_end - p);
+                const char *key_end = eq ? eq : field_end;
+                while (p < key_end && isspace((unsigned char)*p))
+                {
+                    p++;
+                }
+                const char *key = p;
+                size_t key_len = key_end - key;
+                while (key_len && isspace((unsigned char)key[key_len - 1]))
+                {
+                    key_len--;
+                }
+                std::string value;
+                if (eq)
+                {
+                    const char *vb = eq + 1;
+                    const char *ve = field_end;
+                    while (vb < ve && isspace((unsigned char)*vb))
+                    {
+                        vb++;
+                    }
+                    while (ve > vb && isspace((unsigned char)ve[-1]))
+                    {
+                        ve--;
+                    }
+                    value.assign(vb, ve);
+                }
+                p = field_end + 1;
+
+                bool ok = true;
+                uint32_t dirty = 0;
+                double d;
+                if (key_len == 0)
+                {
+                    continue;
+                }
+                else if (key_is(key, key_len, "DELETE") && !eq)
+                {
+                    erase(mmsi);
+                    return nullptr;
+                }
+                else if (key_is(key, key_len, "SEND") && !eq)
+                {
+                    dirty = v.types;
+                }
+                else if (key_is(key, key_len, "TYPES"))
+                {
+                    uint32_t types = 0;
+                    for (const char *t = value.c_str(); ok && *t;)
+                    {
+                        char *te;
+                        const long type = strtol(t, &te, 10);
+                        ok = te != t && type > 0 && type < 32 && (SUPPORTED & bit(type));
+                        types |= ok ? bit(type) : 0;
+                        types |= type == 24 ? bit(MSG_24B) : 0;
+                        t = *te == '/' ? te + 1 : te;
+                        ok = ok && (*te == '/' || *te == '\0');
+                    }
+                    ok = ok && types;
+                    dirty = types & ~v.types;
+                    v.types = ok ? types : v.types;
+                }
+                else if (key_is(key, key_len, "STATUS"))
+                {
+                    ok = parse_int(value, 0, 15, v.status);
+                    dirty = MSGS_STATUS;
+                }
+                else if (key_is(key, key_len, "SOG"))
+                {
+                    ok = parse_double(value, v.speed);
+                    dirty = MSGS_MOTION;
+                }
+                else if (key_is(key, key_len, "COG"))
+                {
+                    ok = parse_double(value, v.course);
+                    dirty = MSGS_MOTION;
+                }
+                else if (key_is(key, key_len, "LAT"))
+                {
+                    ok = parse_double(value, d) && d >= -90 && d <= 91;
+                    v.lat = ok ? d : v.lat;
+                    dirty = MSGS_POSITION;
+                }
+                else if (key_is(key, key_len, "LON"))
+                {
+                    ok = parse_double(value, d) && d >= -180 && d <= 181;
+                    v.lon = ok ? d : v.lon;
+                    dirty = MSGS_POSITION;
+                }
+                else if (key_is(key, key_len, "ALT"))
+                {
+                    ok = parse_int(value, 0, 4095, v.altitude);
+                    dirty = bit(9);
+                }
+                else if (key_is(key, key_len, "SHIPTYPE"))
+                {
+                    ok = parse_int(value, 0, 255, v.ship_type);
+                    dirty = MSGS_SHIP_TYPE;
+                }
+                else if (key_is(key, key_len, "LENGTH"))
+                {
+                    ok = parse_int(value, 0, 1022, v.length);
+                    dirty = MSGS_SIZE;
+                }
+                else if (key_is(key, key_len, "BEAM"))
+                {
+                    ok = parse_int(value, 0, 126, v.beam);
+                    dirty = MSGS_SIZE;
+                }
+                else if (key_is(key, key_len, "DRAUGHT"))
+                {
+                    ok = parse_double(value, d) && d >= 0 && d <= 25.5;
+                    v.draught = ok ? d : v.draught;
+                    dirty = bit(5);
+                }
+                else if (key_is(key, key_len, "ETA"))
+                {
+                    int n = 0;
+                    ok = sscanf(value.c_str(), "%d-%d %d:%d%n", &v.eta_month, &v.eta_day, &v.eta_hour, &v.eta_minute, &n) == 4 &&
+                         (size_t)n == value.size() && v.eta_month >= 0 && v.eta_month <= 12 && v.eta_day >= 0 &&
+                         v.eta_day <= 31 && v.eta_hour >= 0 && v.eta_hour <= 24 && v.eta_minute >= 0 && v.eta_minute <= 60;
+                    dirty = bit(5);
+                }
+                else if (key_is(key, key_len, "NAME"))
+                {
+                    v.name = value;
+                    dirty = MSGS_NAME;
+                }
+                else if (key_is(key, key_len, "CALLSIGN"))
+                {
+                    v.callsign = value;
+                    dirty = MSGS_CALLSIGN;
+                }
+                else if (key_is(key, key_len, "DEST"))
+                {
+                    v.destination = value;
+                    dirty = bit(5);
+                }
+                else if (key_is(key, key_len, "AIDTYPE"))
+                {
+                    ok = parse_int(value, 0, 31, v.aid_type);
+                    dirty = bit(21);
+                }
+                else if (key_is(key, key_len, "VIRTUAL"))
+                {
+                    int virtual_aid;
+                    ok = parse_int(value, 0, 1, virtual_aid);
+                    v.virtual_aid = virtual_aid;
+                    dirty = bit(21);
+                }
+                else
+                {
+                    error = "unknown field " + std::string(key, key_len);
+                    return nullptr;
+                }
+
+                if (!ok)
+                {
+                    error = "invalid value for " + std::string(key, key_len);
+                    return nullptr;
+                }
+                v.dirty |= dirty;
+            }
+            v.dirty &= v.types;
+
+            vessel_state &stored = insert(mmsi);
+            stored = std::move(v);
+            return &stored;
+        }
+
+        /*
+         * Encode message type as bit string, field layout as in ITU-R M.1371-5
+         * and the web app encoder.
+         */
+        void vessel_store::encode(const vessel_state &v, int type, std::string &bits)
+        {
+            const time_t now = time(nullptr);
+            struct tm utc;
+            gmtime_r(&now, &utc);
+
+            bits.clear();
+            bits.reserve(424);
+            put_header(bits, type == MSG_24B ? 24 : type, v.mmsi);
+            switch (type)
+            {
+            case 1: // Position report class A
+                put(bits, v.status, 4);
+                put(bits, 128, 8); // Rate of turn not available
+                put_speed(bits, v);
+                put(bits, 0, 1); // Accuracy > 10m
+                put_position(bits, v);
+                put_course(bits, v);
+                put(bits, 511, 9); // True heading not available
+                put(bits, utc.tm_sec, 6);
+                put(bits, 0, 6); // Maneuver, spare, RAIM
+                put_radio_status(bits);
+                break;
+            case 4: // Base station report
+                put(bits, utc.tm_year + 1900, 14);
+                put(bits, utc.tm_mon + 1, 4);
+                put(bits, utc.tm_mday, 5);
+                put(bits, utc.tm_hour, 5);
+                put(bits, utc.tm_min, 6);
+                put(bits, utc.tm_sec, 6);
+                put(bits, 0, 1); // Accuracy > 10m
+                put_position(bits, v);
+                put(bits, 15, 4); // Internal GNSS
+                put(bits, 0, 11); // Spare, RAIM
+                put_radio_status(bits);
+                break;
+            case 5: // Static and voyage related data
+                put(bits, 2, 2); // AIS version ITU M1371-5
+                put(bits, 0, 30); // IMO
+                put_text(bits, v.callsign, 7);
+                put_text(bits, v.name, 20);
+                put(bits, v.ship_type, 8);
+                put_size(bits, v.length, v.beam);
+                put(bits, 15, 4); // Internal GNSS
+                put(bits, v.eta_month, 4);
+                put(bits, v.eta_day, 5);
+                put(bits, v.eta_hour, 5);
+                put(bits, v.eta_minute, 6);
+                put(bits, (uint32_t)std::lround(v.draught * 10), 8);
+                put_text(bits, v.destination, 20);
+                put(bits, 0, 2); // DTE, spare
+                break;
+            case 9: // SAR aircraft position report
+                put(bits, v.altitude, 12);
+                put_speed(bits, v);
+                put(bits, 0, 1); // Accuracy > 10m
+                put_position(bits, v);
+                put_course(bits, v);
+                put(bits, utc.tm_sec, 6);
+                put(bits, 1, 15); // GNSS altitude, DTE, autonomous, no RAIM, ITDMA
+                put_radio_status(bits);
+                break;
+            case 18: // Class B CS position report
+                put(bits, 0, 8);
+                put_speed(bits, v);
+                put(bits, 0, 1); // Accuracy > 10m
+                put_position(bits, v);
+                put_course(bits, v);
+                put(bits, 511, 9); // True heading not available
+                put(bits, utc.tm_sec, 6);
+                put(bits, 0xc1, 10); // CS unit, autonomous, no RAIM, ITDMA
+                put_radio_status(bits);
+                break;
+            case 19: // Extended class B CS position report
+                put(bits, 0, 8);
+                put_speed(bits, v);
+                put(bits, 0, 1); // Accuracy > 10m
+                put_position(bits, v);
+                put_course(bits, v);
+                put(bits, 511, 9); // True heading not available
+                put(bits, utc.tm_sec, 6);
+                put(bits, 0, 4); // Regional reserved
+                put_text(bits, v.name, 20);
+                put(bits, v.ship_type, 8);
+                put_size(bits, v.length, v.beam);
+                put(bits, 0x7a0, 11); // Internal GNSS, DTE, autonomous
+                break;
+            case 21: // Aid-to-navigation report
+                put(bits, v.aid_type, 5);
+                put_text(bits, v.name, 20);
+                put(bits, 0, 1); // Accuracy > 10m
+                put_position(bits, v);
+                put_size(bits, v.virtual_aid ? 0 : v.length, v.virtual_aid ? 0 : v.beam);
+                put(bits, 15, 4); // Internal GNSS
+                put(bits, utc.tm_sec, 6);
+                put(bits, 0, 10); // On position, reserved, RAIM
+                put(bits, v.virtual_aid, 1);
+                put(bits, 0, 2); // Autonomous, spare
+                if (v.name.size() > 20)
+                {
+                    // Name extension, up to 14 characters padded to a byte.
+                    const size_t ext = std::min<size_t>(v.name.size() - 20, 14);
+                    put_text(bits, v.name.substr(20), ext);
+                    put(bits, 0, (8 - bits.size() % 8) % 8);
+                }
+                break;
+            case 24: // Static data report part A
+                put(bits, 0, 2);
+                put_text(bits, v.name, 20);
+                put(bits, 0, 8);
+                break;
+            case MSG_24B: // Static data report part B
+                put(bits, 1, 2);
+                put(bits, v.ship_type, 8);
+                put(bits, 0, 42); // Vendor ID
+                put_text(bits, v.callsign, 7);
+                put_size(bits, v.length, v.beam);
+                put(bits, 0x3c, 6); // Internal GNSS, spare
+                break;
+            case 27: // Long range broadcast
+                put(bits, 0, 2); // Accuracy > 10m, no RAIM
+                put(bits, v.status, 4);
+                put_position_short(bits, v);
+                put(bits, v.speed >= 0 && v.speed < 63 ? (uint32_t)v.speed : 63, 6);
+                put(bits, v.course >= 0 && v.course < 360 ? (uint32_t)v.course : 511, 9);
+                put(bits, 0, 2); // Latency < 5s, spare
+                break;
+            }
+        }
+
+    } // namespace ais_simulator
+} // namespace gr
@@ -0,0 +1,141 @@
+/* -*- c++ -*- */
+/*
+ * Copyright 2020 Michael Wolf, Mictronics.
+ *
+ * This is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this software; see the file COPYING.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street,
+ * Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef INCLUDED_AIS_SIMULATOR_VESSEL_STORE_H
+#define INCLUDED_AIS_SIMULATOR_VESSEL_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gr
+{
+    namespace ais_simulator
+    {
+        /*
+         * State of one simulated station. Unset values encode as "not
+         * available" in AIS messages.
+         */
+        struct vessel_state {
+            uint32_t mmsi = 0;
+            uint32_t types = 1u << 1; // Enabled message types, bit n for type n
+            uint32_t dirty = 0;       // Messages in need of encoding
+            int status = 15;          // Navigation status, 15 = undefined
+            double speed = -1;        // Knots
+            double course = -1;       // Degrees
+            double lat = 91;
+            double lon = 181;
+            int altitude = 4095;      // Meters, SAR aircraft
+            int ship_type = 0;
+            int length = 0;           // Meters
+            int beam = 0;             // Meters
+            double draught = 0;       // Meters
+            int eta_month = 0;
+            int eta_day = 0;
+            int eta_hour = 24;
+            int eta_minute = 60;
+            int aid_type = 0;         // Aid-to-navigation type
+            bool virtual_aid = false;
+            std::string name;
+            std::string callsign;
+            std::string destination;
+        };
+
+        /*
+         * Vessel state store keyed by MMSI, with server side AIS payload
+         * encoding for messages 1, 4, 5, 9, 18, 19, 21, 24 and 27.
+         *
+         * States live in a dense vector, an open addressing hash table with
+         * linear probing maps MMSI to index. Updates come as text deltas:
+         *
+         *   MMSI 247320162: SOG=12.3, COG=85
+         *
+         * Each field marks only the enabled messages carrying it as dirty,
+         * flush() encodes those into bit strings. Not thread safe.
+         */
+        class vessel_store
+        {
+        public:
+            // Type 0 does not exist, its bit stands for part B of message 24.
+            static constexpr int MSG_24B = 0;
+            static constexpr uint32_t SUPPORTED = (1u << 1) | (1u << 4) | (1u << 5) | (1u << 9) |
+                                                  (1u << 18) | (1u << 19) | (1u << 21) |
+                                                  (1u << 24) | (1u << MSG_24B) | (1u << 27);
+
+            vessel_store();
+
+            size_t size() const { return d_vessels.size(); }
+            vessel_state *find(uint32_t mmsi);
+            // Find or add, new vessels send message 1 until told otherwise.
+            vessel_state &insert(uint32_t mmsi);
+            bool erase(uint32_t mmsi);
+
+            /*
+             * Apply one delta line. Returns the updated vessel, or nullptr
+             * after DELETE or a blank line, and with error set on malformed
+             * input.
+             */
+            vessel_state *apply(const char *begin, const char *end, std::string &error);
+
+            /*
+             * Encode dirty messages of v, emit(bits) returns false when the
+             * message could not be taken. Those stay dirty for the next flush.
+             * Returns the number of messages taken.
+             */
+            template <typename F>
+            int flush(vessel_state &v, F emit)
+            {
+                int taken = 0;
+                std::string bits;
+                for (uint32_t dirty = v.dirty & v.types; dirty; dirty &= dirty - 1)
+                {
+                    const int type = __builtin_ctz(dirty);
+                    encode(v, type, bits);
+                    if (emit(std::move(bits)))
+                    {
+                        v.dirty &= ~(1u << type);
+                        taken++;
+                    }
+                }
+                return taken;
+            }
+
+            // Encode message type for v as bit string.
+            static void encode(const vessel_state &v, int type, std::string &bits);
+
+        private:
+            struct slot {
+                uint32_t mmsi; // 0 = empty, MMSI 0 is invalid
+                uint32_t index;
+            };
+            std::vector<slot> d_slots;
+            std::vector<vessel_state> d_vessels;
+            unsigned d_shift;
+
+            size_t home(uint32_t mmsi) const;
+            void grow();
+        };
+
+    } // namespace ais_simulator
+} // namespace gr
+
+#endif /* INCLUDED_AIS_SIMULATOR_VESSEL_STORE_H */
@@ -25,12 +25,34 @@
 #include <gnuradio/io_signature.h>
 #include <gnuradio/pdu.h>
 #include "websocket_pdu_impl.h"
+#include "sentence_pdu.h"
+#include "probes.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <future>
 
 namespace gr
 {
     namespace ais_simulator
     {
 
+        /*
+         * Session class constructor.
+         */
+        session::session(tcp::socket &&socket, websocket_pdu_impl *wsi)
+            : d_ws(std::move(socket)),
+              d_wsi{wsi},
+              d_ring(wsi->add_ring()),
+              d_retry_timer(d_ws.get_executor())
+        {
+        }
+
+        session::~session()
+        {
+            d_wsi->remove_ring(d_ring);
+        }
+
         /*
          * Get on correct executor.
          */
@@ -72,6 +94,8 @@ namespace gr
                 [](websocket::response_type &res) {
                     res.set(http::field::server, "ais-websocket-server");
                 }));
+            // Offer compression if enabled
+            d_ws.set_option(d_wsi->deflate());
             // Accept the websocket handshake
             d_ws.async_accept(
                 beast::bind_front_handler(
@@ -101,9 +125,10 @@ namespace gr
             // Read a message into our buffer
             d_ws.async_read(
                 d_buffer,
-                beast::bind_front_handler(
-                    &session::on_read,
-                    shared_from_this()));
+                recycle(d_read_memory,
+                        beast::bind_front_handler(
+                            &session::on_read,
+                            shared_from_this())));
         }
 
         /*
@@ -122,34 +147,143 @@ namespace gr
                 std::cerr << "read: " << ec.message() << "\n";
                 return;
             }
-            // Send websocket data via PDU message, clear buffer and read new data.
-            d_wsi->set_string_msg(beast::buffers_to_string(d_buffer.data()), bytes_transferred);
+            AIS_PROBE(ws_read, bytes_transferred);
+            // Hand websocket data over to message delivery, clear buffer and read new data.
+            // d_parked holds a buffer recycled through the ring, no allocation
+            // once it has grown to the message size.
+            const net::const_buffer data = d_buffer.data();
+            d_parked.assign(static_cast<const char *>(data.data()), data.size());
             d_buffer.consume(d_buffer.size());
+            d_wsi->capture(d_parked);
+            if (websocket_pdu_impl::is_schedule(d_parked))
+            {
+                // Timed scenario upload, reply with status.
+                write(d_wsi->schedule(d_parked));
+                read();
+                return;
+            }
+            if (websocket_pdu_impl::is_vessel_delta(d_parked))
+            {
+                // Vessel state update, reply on error only.
+                std::string reply = d_wsi->vessel_delta(d_parked);
+                if (!reply.empty())
+                {
+                    write(reply);
+                }
+                read();
+                return;
+            }
+            enqueue();
+        }
+
+        /*
+         * Push received message into the delivery ring. When the ring is full
+         * pause reading and retry shortly, the I/O thread never blocks.
+         */
+        void session::enqueue()
+        {
+            if (!d_ring->push_swap(d_parked))
+            {
+                d_retry_timer.expires_after(std::chrono::milliseconds(1));
+                d_retry_timer.async_wait(
+                    recycle(d_retry_memory,
+                            beast::bind_front_handler(
+                                &session::on_retry,
+                                shared_from_this())));
+                return;
+            }
+            d_wsi->notify_delivery();
+            // Stop reading while downstream is saturated.
+            if (d_wsi->throttled() && d_wsi->pause(shared_from_this()))
+            {
+                return;
+            }
             read();
         }
 
         /*
-         * Write string async to websocket.
+         * Resume reading after pause, get on the session's strand first.
+         */
+        void session::resume()
+        {
+            net::dispatch(d_ws.get_executor(),
+                          beast::bind_front_handler(
+                              &session::read,
+                              shared_from_this()));
+        }
+
+        /*
+         * Retry timer handler.
+         */
+        void session::on_retry(beast::error_code ec)
+        {
+            if (ec)
+            {
+                return;
+            }
+            enqueue();
+        }
+
+        /*
+         * Write data async to websocket, as binary frame or as text frame
+         * in the mode of the client. The data is copied into a buffer kept
+         * from an earlier message.
          */
-        void session::write(std::string s)
+        void session::write(const char *data, size_t len, bool binary)
         {
             //  Always add to queue.
-            d_queue.push_back(std::make_shared<std::string const>(s));
+            d_queue.emplace_back();
+            outgoing &o = d_queue.back();
+            if (!d_free.empty())
+            {
+                o.data = std::move(d_free.back());
+                d_free.pop_back();
+            }
+            o.data.assign(data, len);
+            o.binary = binary;
+            AIS_PROBE(ws_write_queue, len, (int)binary, d_queue.size() - d_queue_head + d_writing);
 
             // Are we already writing?
-            if (d_queue.size() > 1)
+            if (d_writing)
             {
                 return;
             }
             // Currently not writing, so send immediately.
-            d_ws.text(d_ws.got_text());
+            write_front();
+        }
+
+        /*
+         * Start writing the message at the queue front.
+         */
+        void session::write_front()
+        {
+            d_sending = std::move(d_queue[d_queue_head++]);
+            if (d_queue_head == d_queue.size())
+            {
+                d_queue.clear();
+                d_queue_head = 0;
+            }
+            else if (d_queue_head >= QUEUE_COMPACT && d_queue_head * 2 >= d_queue.size())
+            {
+                d_queue.erase(d_queue.begin(), d_queue.begin() + d_queue_head);
+                d_queue_head = 0;
+            }
+            d_writing = true;
+
+            if (d_sending.binary)
+            {
+                d_ws.binary(true);
+            }
+            else
+            {
+                d_ws.text(d_ws.got_text());
+            }
             d_ws.async_write(
-                net::buffer(*d_queue.front()),
-                net::bind_executor(
-                    d_ws.get_executor(),
-                    beast::bind_front_handler(
-                        &session::on_write,
-                        shared_from_this())));
+                net::buffer(d_sending.data),
+                recycle(d_write_memory,
+                        beast::bind_front_handler(
+                            &session::on_write,
+                            shared_from_this())));
         }
 
         /*
@@ -158,24 +292,22 @@ namespace gr
         void session::on_write(beast::error_code ec, std::size_t bytes_transferred)
         {
             boost::ignore_unused(bytes_transferred);
+            AIS_PROBE(ws_write, bytes_transferred, d_queue.size() - d_queue_head);
 
             if (ec)
             {
                 std::cerr << "write: " << ec.message() << "\n";
             }
-            // Remove sent string from queue.
-            d_queue.erase(d_queue.begin());
-            // Send next string if any.
-            if (!d_queue.empty())
+            // Keep the sent buffer for a later message.
+            d_writing = false;
+            if (d_free.size() < POOL_MAX)
             {
-                d_ws.text(d_ws.got_text());
-                d_ws.async_write(
-                    net::buffer(*d_queue.front()),
-                    net::bind_executor(
-                        d_ws.get_executor(),
-                        beast::bind_front_handler(
-                            &session::on_write,
-                            this)));
+                d_free.push_back(std::move(d_sending.data));
+            }
+            // Send next message if any.
+            if (d_queue_head < d_queue.size())
+            {
+                write_front();
             }
         }
 
@@ -230,11 +362,11 @@ namespace gr
         /*
          * Send string to client session.
          */
-        void listener::send(std::string s)
+        void listener::send(const std::string &s, bool binary)
         {
             if (d_session != nullptr)
             { // Needs a connection/session to send stuff
-                d_session->write(s);
+                d_session->write(s, binary);
             }
         }
 
@@ -256,6 +388,7 @@ namespace gr
          */
         void listener::on_accept(beast::error_code ec, tcp::socket socket)
         {
+            AIS_PROBE(ws_accept, ec.value());
             // Close an already existing session.
             // We accept only one client connection.
             if (d_session != nullptr)
@@ -279,27 +412,101 @@ namespace gr
         }
 
         websocket_pdu::sptr
-        websocket_pdu::make(std::string addr, std::string port)
+        websocket_pdu::make(std::string addr,
+                            std::string port,
+                            int high_watermark,
+                            int low_watermark,
+                            bool report_credit,
+                            int deflate_window_bits,
+                            int deflate_mem_level,
+                            int max_in_flight,
+                            int starvation_limit,
+                            std::string capture_file,
+                            std::string replay_file,
+                            double replay_speed)
         {
-            return gnuradio::get_initial_sptr(new websocket_pdu_impl(addr, port));
+            return gnuradio::get_initial_sptr(new websocket_pdu_impl(addr,
+                                                                     port,
+                                                                     high_watermark,
+                                                                     low_watermark,
+                                                                     report_credit,
+                                                                     deflate_window_bits,
+                                                                     deflate_mem_level,
+                                                                     max_in_flight,
+                                                                     starvation_limit,
+                                                                     capture_file,
+                                                                     replay_file,
+                                                                     replay_speed));
         }
 
         /*
          * The private constructor
          */
-        websocket_pdu_impl::websocket_pdu_impl(std::string addr, std::string port)
+        websocket_pdu_impl::websocket_pdu_impl(std::string addr,
+                                               std::string port,
+                                               int high_watermark,
+                                               int low_watermark,
+                                               bool report_credit,
+                                               int deflate_window_bits,
+                                               int deflate_mem_level,
+                                               int max_in_flight,
+                                               int starvation_limit,
+                                               std::string capture_file,
+                                               std::string replay_file,
+                                               double replay_speed)
             : gr::block("websocket_pdu",
                         gr::io_signature::make(0, 0, 0),
                         gr::io_signature::make(0, 0, 0)),
               d_out_port(pmt::mp("out")),
               d_in_port(pmt::mp("in")),
-              d_send_port(pmt::mp("send"))
+              d_send_port(pmt::mp("send")),
+              d_credit_port(pmt::mp("credit")),
+              d_high_watermark(high_watermark),
+              d_low_watermark(low_watermark < high_watermark ? low_watermark : high_watermark / 2),
+              d_report_credit(report_credit),
+              d_max_in_flight(max_in_flight),
+              d_lanes(starvation_limit),
+              d_wheel_start(std::chrono::steady_clock::now()),
+              d_replay_speed(replay_speed)
         {
+            if (high_watermark < 0 || low_watermark < 0 || max_in_flight < 0 || starvation_limit < 0)
+            {
+                throw std::invalid_argument(
+                    "websocked_pdu: Invalid flow control watermark or priority lane limit");
+            }
+            if (!(replay_speed >= 0))
+            {
+                throw std::invalid_argument("websocked_pdu: Invalid replay speed");
+            }
+            if (!replay_file.empty())
+            {
+                d_replay = std::make_unique<capture_reader>(replay_file);
+            }
+            if (!capture_file.empty())
+            {
+                d_capture = std::make_unique<capture_writer>(capture_file);
+            }
+            if (deflate_window_bits != 0)
+            {
+                if (deflate_window_bits < 9 || deflate_window_bits > 15 ||
+                    deflate_mem_level < 1 || deflate_mem_level > 9)
+                {
+                    throw std::invalid_argument(
+                        "websocked_pdu: Invalid deflate window bits or memory level");
+                }
+                d_deflate.server_enable = true;
+                d_deflate.server_max_window_bits = deflate_window_bits;
+                d_deflate.client_max_window_bits = deflate_window_bits;
+                d_deflate.memLevel = deflate_mem_level;
+            }
             message_port_register_in(d_in_port);
             message_port_register_in(d_send_port);
+            message_port_register_in(d_credit_port);
             message_port_register_out(d_out_port);
             set_msg_handler(d_in_port, [this](pmt::pmt_t msg) { this->set_msg(msg); });
             set_msg_handler(d_send_port, [this](pmt::pmt_t msg) { this->ws_send_msg(msg); });
+            set_msg_handler(d_credit_port, [this](pmt::pmt_t msg) { this->set_credit(msg); });
+            d_local_ring = add_ring();
 
             const unsigned short port_ = static_cast<unsigned short>(std::atoi(port.c_str()));
             tcp::endpoint tcp_ep;
@@ -324,6 +531,8 @@ namespace gr
             d_listener->run();
             // Run the I/O service on thread
             d_thread = gr::thread::thread(boost::bind(&websocket_pdu_impl::ioc_run, this));
+            // Publish received messages from a separate thread
+            d_delivery_thread = gr::thread::thread(boost::bind(&websocket_pdu_impl::deliver, this));
             d_started = true;
         }
 
@@ -332,6 +541,26 @@ namespace gr
          */
         websocket_pdu_impl::~websocket_pdu_impl()
         {
+            stop();
+        }
+
+        void websocket_pdu_impl::ioc_run()
+        {
+            gr::thread::set_thread_name(gr::thread::get_current_thread_id(), "ws_io");
+            d_ioc.run();
+        }
+
+        /*
+         * Start the replay with the flow graph, so no message is published
+         * before downstream is connected.
+         */
+        bool websocket_pdu_impl::start()
+        {
+            if (d_replay && !d_replay_thread.joinable())
+            {
+                d_replay_thread = gr::thread::thread(boost::bind(&websocket_pdu_impl::replay, this));
+            }
+            return true;
         }
 
         /*
@@ -339,60 +568,778 @@ namespace gr
          */
         bool websocket_pdu_impl::stop()
         {
+            if (d_replay_thread.joinable())
+            {
+                // Before the I/O thread, the replay may wait for it.
+                {
+                    std::lock_guard<std::mutex> lock(d_replay_mutex);
+                    d_replay_stop = true;
+                }
+                d_replay_cond.notify_one();
+                d_replay_thread.join();
+            }
             if (d_started)
             {
                 d_ioc.stop();
                 d_thread.interrupt();
                 d_thread.join();
+                {
+                    std::lock_guard<std::mutex> lock(d_delivery_mutex);
+                    d_delivery_stop = true;
+                }
+                d_delivery_cond.notify_one();
+                d_delivery_thread.join();
             }
             d_started = false;
             return true;
         }
 
         /*
-         * Set internal message from PDU IN port and send.
+         * Set internal message from PDU IN port and send. Counted for flow
+         * control like client messages, downstream credits both.
          */
         void websocket_pdu_impl::set_msg(pmt::pmt_t msg)
         {
-            std::string s = pmt::symbol_to_string(msg);
-            set_string_msg(s, s.length());
+            published(set_batch_msg(pmt::symbol_to_string(msg)));
         }
 
         /*
          * Create and send PDU message from websocket string.
          */
-        void websocket_pdu_impl::set_string_msg(std::string s, std::size_t l)
+        void websocket_pdu_impl::set_string_msg(const char *s, std::size_t l, priority_class c)
+        {
+            AIS_PROBE(ws_message, s, l);
+            message_port_pub(d_out_port, make_sentence_pdu(s, l, c));
+            d_sent++;
+        }
+
+        /*
+         * Publish each newline separated sentence of a batch as its own PDU,
+         * straight from the batch buffer. Returns the number of PDUs.
+         */
+        long websocket_pdu_impl::set_batch_msg(const std::string &s)
+        {
+            return for_each_batch_sentence(
+                s.data(), s.size(), [this](const char *q, size_t l, priority_class c) { set_string_msg(q, l, c); });
+        }
+
+        /*
+         * Sort the sentences of a batch into the priority lanes, delivery
+         * thread only. The lanes refer to the batch, which is kept and s
+         * handed a recycled buffer. Returns the number of sentences.
+         */
+        long websocket_pdu_impl::enqueue_batch(std::string &s)
+        {
+            const uint64_t batch = d_batches_first + d_batches.size();
+            const char *base = s.data();
+            const long n = for_each_batch_sentence(
+                s.data(), s.size(), [this, batch, base](const char *q, size_t l, priority_class c) {
+                    d_lanes.push(c, lane_sentence{ batch, (uint32_t)(q - base), (uint32_t)l });
+                });
+            if (n > 0)
+            {
+                d_batches.push_back(held_batch{ std::string(), n });
+                d_batches.back().data.swap(s);
+                if (!d_free_batches.empty())
+                {
+                    s.swap(d_free_batches.back());
+                    d_free_batches.pop_back();
+                }
+            }
+            return n;
+        }
+
+        /*
+         * Lanes hold a message that may be published now.
+         */
+        bool websocket_pdu_impl::lanes_ready() const
+        {
+            return d_lanes.size(PRIORITY_URGENT) > 0 ||
+                   (!d_lanes.empty() &&
+                    (d_max_in_flight == 0 || d_sent - d_credited < d_max_in_flight));
+        }
+
+        /*
+         * Publish from the lanes in priority order while downstream has
+         * room, urgent messages always. Delivery thread only.
+         */
+        void websocket_pdu_impl::publish_lanes()
+        {
+            while (lanes_ready())
+            {
+                const priority_class c = d_max_in_flight == 0 || d_sent - d_credited < d_max_in_flight
+                                             ? d_lanes.next()
+                                             : PRIORITY_URGENT;
+                d_lanes.pop(d_sentence, c);
+                held_batch &b = d_batches[d_sentence.batch - d_batches_first];
+                set_string_msg(b.data.data() + d_sentence.offset, d_sentence.len, c);
+                b.pending--;
+                // Release fully published batches in order, recycling buffers.
+                while (!d_batches.empty() && d_batches.front().pending == 0)
+                {
+                    if (d_free_batches.size() < RING_CAPACITY)
+                    {
+                        d_free_batches.push_back(std::move(d_batches.front().data));
+                    }
+                    d_batches.pop_front();
+                    d_batches_first++;
+                }
+            }
+        }
+
+        /*
+         * Create message ring for a new session.
+         */
+        std::shared_ptr<msg_ring> websocket_pdu_impl::add_ring()
+        {
+            auto ring = std::make_shared<msg_ring>(RING_CAPACITY);
+            std::lock_guard<std::mutex> lock(d_rings_mutex);
+            d_rings.push_back(ring);
+            d_rings_version++;
+            return ring;
+        }
+
+        /*
+         * Drop message ring of a closed session.
+         */
+        void websocket_pdu_impl::remove_ring(const std::shared_ptr<msg_ring> &ring)
+        {
+            std::lock_guard<std::mutex> lock(d_rings_mutex);
+            d_rings.erase(std::remove(d_rings.begin(), d_rings.end(), ring), d_rings.end());
+            d_rings_version++;
+        }
+
+        /*
+         * Wake up delivery thread after a push, only when it is idle.
+         */
+        void websocket_pdu_impl::notify_delivery()
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (d_delivery_idle.load())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(d_delivery_mutex);
+                    d_delivery_wake = true;
+                }
+                d_delivery_cond.notify_one();
+            }
+        }
+
+        /*
+         * Delivery thread. Drains all session rings in batches into the
+         * priority lanes and publishes from there as PDU, so the I/O thread
+         * never takes GNU Radio's message queue locks.
+         */
+        void websocket_pdu_impl::deliver()
+        {
+            gr::thread::set_thread_name(gr::thread::get_current_thread_id(), "ws_deliver");
+            std::vector<std::shared_ptr<msg_ring>> rings;
+            unsigned version = d_rings_version.load() - 1;
+            // Swapped with the ring slots, the buffers go back to the sessions.
+            std::string s;
+
+            while (!d_delivery_stop)
+            {
+                bool any = false;
+                for (auto &ring : rings)
+                {
+                    for (int i = 0; i < DELIVERY_BATCH && ring->pop_swap(s); i++)
+                    {
+                        published(enqueue_batch(s));
+                        any = true;
+                    }
+                }
+                publish_lanes();
+
+                if (version != d_rings_version.load())
+                {
+                    // Drain rings of closed sessions before dropping them.
+                    for (auto &ring : rings)
+                    {
+                        while (ring->pop_swap(s))
+                        {
+                            published(enqueue_batch(s));
+                        }
+                    }
+                    std::lock_guard<std::mutex> lock(d_rings_mutex);
+                    rings = d_rings;
+                    version = d_rings_version.load();
+                    continue;
+                }
+
+                if (any)
+                {
+                    continue;
+                }
+
+                // Announce idle, then check once more for a push that missed it.
+                d_delivery_idle = true;
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                bool pending = version != d_rings_version.load() || lanes_ready();
+                for (auto &ring : rings)
+                {
+                    pending |= !ring->empty();
+                }
+                if (!pending)
+                {
+                    std::unique_lock<std::mutex> lock(d_delivery_mutex);
+                    d_delivery_cond.wait_for(lock, std::chrono::milliseconds(100), [this] {
+                        return d_delivery_wake || d_delivery_stop;
+                    });
+                    d_delivery_wake = false;
+                }
+                d_delivery_idle = false;
+            }
+        }
+
+        /*
+         * Statistics PDU, a dict with u64vector histogram as from vdl_stats,
+         * as text "stats:<key>=<value>,...,histogram=<n>/<n>/...". Returns
+         * false for other messages.
+         */
+        bool websocket_pdu_impl::stats_text(pmt::pmt_t msg, std::string &text)
         {
-            d_msg_buffer.resize(l);
-            memcpy(&d_msg_buffer[0], s.c_str(), l);
-            // Store sentence as vector data
-            pmt::pmt_t v = pmt::init_u8vector(l, (const uint8_t *)&d_msg_buffer[0]);
-            // Store length of sentence in message meta data
-            // This propagated via tag in tagged stream.
-            pmt::pmt_t d = pmt::make_dict();
-            d = pmt::dict_add(d, pmt::string_to_symbol("length"), pmt::from_long(l));
-            // Combine meta and vector data
-            d_msg = pmt::cons(d, v);
-            // Send message
-            message_port_pub(d_out_port, d_msg);
+            if (!pmt::is_pair(msg) || !pmt::is_dict(pmt::car(msg)) || !pmt::is_u64vector(pmt::cdr(msg)))
+            {
+                return false;
+            }
+            text = "stats:";
+            char value[32];
+            for (pmt::pmt_t items = pmt::dict_items(pmt::car(msg)); pmt::is_pair(items);
+                 items = pmt::cdr(items))
+            {
+                const pmt::pmt_t item = pmt::car(items);
+                const pmt::pmt_t v = pmt::cdr(item);
+                if (pmt::is_symbol(v))
+                {
+                    text += pmt::symbol_to_string(pmt::car(item)) + "=" + pmt::symbol_to_string(v) + ",";
+                    continue;
+                }
+                if (pmt::is_uint64(v))
+                {
+                    snprintf(value, sizeof(value), "%llu", (unsigned long long)pmt::to_uint64(v));
+                }
+                else if (pmt::is_integer(v))
+                {
+                    snprintf(value, sizeof(value), "%ld", pmt::to_long(v));
+                }
+                else if (pmt::is_real(v))
+                {
+                    snprintf(value, sizeof(value), "%.15g", pmt::to_double(v));
+                }
+                else
+                {
+                    continue;
+                }
+                text += pmt::symbol_to_string(pmt::car(item)) + "=" + value + ",";
+            }
+            text += "histogram=";
+            size_t len;
+            const uint64_t *histogram = pmt::u64vector_elements(pmt::cdr(msg), len);
+            for (size_t i = 0; i < len; i++)
+            {
+                snprintf(value, sizeof(value), i ? "/%llu" : "%llu", (unsigned long long)histogram[i]);
+                text += value;
+            }
+            return true;
         }
 
         /*
-         * Send PDU message via websocket.
+         * Send PDU message via websocket. Symbols go out as text frames,
+         * u8vectors, bare or as PDU, as binary frames. Statistics PDUs go
+         * out as text, see stats_text(). Anything else is dropped.
+         *
+         * The message is copied into a recycled buffer and handed to the I/O
+         * thread through the send ring, without allocation in steady state.
+         * While the ring is full messages are dropped and counted, the block
+         * thread never waits for the I/O thread.
          */
         void websocket_pdu_impl::ws_send_msg(pmt::pmt_t msg)
         {
-            // Handle only symbol(string) messages so far.
-            if (msg->is_symbol())
+            send_msg &m = d_send_scratch;
+            if (pmt::is_symbol(msg))
             {
-                // Dispatch work into I/O context thread.
-                net::dispatch(
-                    d_ioc.get_executor(),
-                    beast::bind_front_handler(
-                        &listener::send,
-                        d_listener->shared_from_this(),
-                        pmt::symbol_to_string(msg)));
+                m.data = pmt::symbol_to_string(msg);
+                m.binary = false;
+            }
+            else
+            {
+                const pmt::pmt_t data = pmt::is_pair(msg) ? pmt::cdr(msg) : msg;
+                if (pmt::is_u8vector(data))
+                {
+                    size_t len;
+                    const uint8_t *bytes = pmt::u8vector_elements(data, len);
+                    m.data.assign((const char *)bytes, len);
+                    m.binary = true;
+                }
+                else if (stats_text(msg, m.data))
+                {
+                    m.binary = false;
+                }
+                else
+                {
+                    return;
+                }
+            }
+            if (!d_send_ring.push_swap(m))
+            {
+                d_send_dropped++;
+                return;
+            }
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!d_send_pending.exchange(true))
+            {
+                net::post(d_ioc, recycle(d_send_memory, [this] { drain_send(); }));
+            }
+        }
+
+        /*
+         * Pass queued messages to the session, I/O thread.
+         */
+        void websocket_pdu_impl::drain_send()
+        {
+            d_send_pending = false;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while (d_send_ring.pop_swap(d_send_buf))
+            {
+                d_listener->send(d_send_buf.data, d_send_buf.binary);
+            }
+        }
+
+        /*
+         * Count messages published from websocket or the in port, pause
+         * reading from clients at the high watermark.
+         */
+        void websocket_pdu_impl::published(long n)
+        {
+            if (d_high_watermark == 0)
+            {
+                return;
+            }
+            const long outstanding = (d_published += n) - d_credited;
+            if (outstanding >= d_high_watermark && !d_throttled.exchange(true))
+            {
+                report_credit();
+            }
+        }
+
+        /*
+         * Credit from downstream, an integer counts that many messages, any
+         * other message one. Resume reading at the low watermark.
+         */
+        void websocket_pdu_impl::set_credit(pmt::pmt_t msg)
+        {
+            const long n = pmt::is_integer(msg) ? pmt::to_long(msg) : 1;
+            const long outstanding = d_published - (d_credited += n);
+            if (d_max_in_flight > 0)
+            {
+                // Room downstream for messages waiting in the lanes.
+                notify_delivery();
+            }
+            if (outstanding <= d_low_watermark && d_throttled.exchange(false))
+            {
+                net::post(d_ioc, [this] { resume_sessions(); });
+                report_credit();
+            }
+        }
+
+        /*
+         * Park a session while throttled. Runs on the I/O thread, same as
+         * resume_sessions(), so a resume can't get lost in between.
+         */
+        bool websocket_pdu_impl::pause(std::shared_ptr<session> s)
+        {
+            if (!d_throttled)
+            {
+                return false;
+            }
+            d_paused.push_back(s);
+            return true;
+        }
+
+        void websocket_pdu_impl::resume_sessions()
+        {
+            std::vector<std::weak_ptr<session>> paused;
+            paused.swap(d_paused);
+            for (auto &p : paused)
+            {
+                if (auto s = p.lock())
+                {
+                    s->resume();
+                }
+            }
+        }
+
+        /*
+         * Tell clients how many messages they may send before reading pauses.
+         */
+        void websocket_pdu_impl::report_credit()
+        {
+            if (!d_report_credit)
+            {
+                return;
+            }
+            const long outstanding = d_published - d_credited;
+            const long credit = outstanding < d_high_watermark ? d_high_watermark - outstanding : 0;
+            net::post(
+                d_ioc.get_executor(),
+                beast::bind_front_handler(
+                    &listener::send,
+                    d_listener->shared_from_this(),
+                    "credit:" + std::to_string(credit),
+                    false));
+        }
+
+        /*
+         * Scheduled uploads start with "@schedule" on the first line.
+         */
+        bool websocket_pdu_impl::is_schedule(const std::string &s)
+        {
+            return s.compare(0, 9, "@schedule") == 0;
+        }
+
+        /*
+         * Vessel state deltas start with "MMSI ".
+         */
+        bool websocket_pdu_impl::is_vessel_delta(const std::string &s)
+        {
+            return s.size() > 5 && strncasecmp(s.c_str(), "MMSI ", 5) == 0;
+        }
+
+        /*
+         * Update vessel state and publish the messages affected by the delta,
+         * I/O thread only. Messages not taken by a full ring stay dirty and go
+         * out with the next delta for that vessel. With direct they are
+         * appended there instead, in the order of the deltas, for the caller
+         * to publish from its own thread.
+         *
+         * Returns an error reply for the client, empty on success.
+         */
+        std::string websocket_pdu_impl::vessel_delta(const std::string &delta,
+                                                     std::vector<std::string> *direct)
+        {
+            std::string reply;
+            bool taken = false;
+            const char *p = delta.data();
+            const char *end = p + delta.size();
+            // One delta per line when batched.
+            while (p < end)
+            {
+                const char *eol = (const char *)memchr(p, '\n', end - p);
+                eol = eol ? eol : end;
+                std::string error;
+                vessel_state *v = d_vessels.apply(p, eol, error);
+                p = eol + 1;
+                if (!v)
+                {
+                    if (!error.empty() && reply.empty())
+                    {
+                        reply = "vessel:error=" + error;
+                    }
+                    continue;
+                }
+                taken |= d_vessels.flush(*v, [this, direct](std::string &&bits) {
+                    if (direct)
+                    {
+                        direct->push_back(std::move(bits));
+                        return true;
+                    }
+                    return d_local_ring->push(std::move(bits));
+                }) > 0;
+                if (v->dirty && reply.empty())
+                {
+                    reply = "vessel:error=busy,mmsi=" + std::to_string(v->mmsi);
+                }
+            }
+            if (taken && !direct)
+            {
+                notify_delivery();
+            }
+            return reply;
+        }
+
+        uint64_t websocket_pdu_impl::wheel_tick() const
+        {
+            return std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - d_wheel_start)
+                .count();
+        }
+
+        /*
+         * Insert a timed scenario upload into the timer wheel, I/O thread only.
+         *
+         * Format, one message per line after the "@schedule" line:
+         *   <time> <repeat> <bit string>
+         * Time is seconds relative to now when prefixed by '+', otherwise
+         * absolute UNIX time in seconds. Repeat is the interval in seconds,
+         * zero sends once. "@schedule clear" drops all pending messages first.
+         *
+         * Returns the status reply for the client.
+         */
+        std::string websocket_pdu_impl::schedule(const std::string &upload)
+        {
+            const double unix_now =
+                std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch())
+                    .count();
+            std::string status = schedule(upload, d_wheel, d_horizon, wheel_tick(), unix_now);
+            arm_wheel();
+            return status;
+        }
+
+        /*
+         * Same into the given wheel at tick now, which is UNIX time unix_now
+         * in seconds. The replay passes capture time here.
+         */
+        std::string websocket_pdu_impl::schedule(const std::string &upload,
+                                                 timer_wheel<scheduled_msg> &wheel,
+                                                 uint64_t &horizon,
+                                                 uint64_t now,
+                                                 double unix_now)
+        {
+            const char *p = upload.c_str();
+            const char *end = p + upload.size();
+            const char *eol = std::find(p, end, '\n');
+
+            if (std::string(p, eol).find("clear") != std::string::npos)
+            {
+                wheel.clear();
+                horizon = now;
+            }
+            if (wheel.empty())
+            {
+                // Skip idle time without ticking through it.
+                wheel.advance(now, [](uint64_t, scheduled_msg &&) {});
+            }
+
+            long accepted = 0;
+            long rejected = 0;
+            for (p = eol; p < end; p = eol)
+            {
+                p++;
+                eol = std::find(p, end, '\n');
+                const char *last = eol;
+                while (last > p && (last[-1] == '\r' || last[-1] == ' '))
+                {
+                    last--;
+                }
+                if (last == p)
+                {
+                    continue;
+                }
+
+                char *q;
+                const bool relative = *p == '+';
+                double t = std::strtod(relative ? p + 1 : p, &q);
+                const double repeat = std::strtod(q, &q);
+                while (q < last && *q == ' ')
+                {
+                    q++;
+                }
+                if (!relative)
+                {
+                    t -= unix_now;
+                }
+                const bool bits = q < last && std::all_of((const char *)q, last, [](char c) {
+                                      return c == '0' || c == '1';
+                                  });
+                if (!bits || !(t > -1e9 && t * 1000 < timer_wheel<scheduled_msg>::HORIZON) ||
+                    !(repeat >= 0 && repeat * 1000 < timer_wheel<scheduled_msg>::HORIZON))
+                {
+                    rejected++;
+                    continue;
+                }
+
+                const uint64_t expiry = t > 0 ? now + (uint64_t)(t * 1000) : now;
+                wheel.insert(expiry, scheduled_msg{ std::string((const char *)q, last), (uint64_t)(repeat * 1000) });
+                horizon = expiry > horizon ? expiry : horizon;
+                accepted++;
+            }
+
+            char status[128];
+            snprintf(status,
+                     sizeof(status),
+                     "scheduled:accepted=%ld,rejected=%ld,pending=%zu,horizon=%.3f",
+                     accepted,
+                     rejected,
+                     wheel.size(),
+                     horizon > now ? (horizon - now) / 1000.0 : 0.0);
+            return status;
+        }
+
+        /*
+         * Arm the timer for the next tick with work in the timer wheel, an
+         * expiry or a cascade. Stop it when the wheel is empty.
+         */
+        void websocket_pdu_impl::arm_wheel()
+        {
+            uint64_t next;
+            if (!d_wheel.next_tick(next))
+            {
+                if (d_wheel_armed)
+                {
+                    d_wheel_timer.cancel();
+                    d_wheel_armed = false;
+                }
+                return;
+            }
+            if (d_wheel_armed && d_wheel_due <= next)
+            {
+                return;
+            }
+            // Rearming cancels a later wait, its handler sees operation_aborted.
+            d_wheel_armed = true;
+            d_wheel_due = next;
+            d_wheel_timer.expires_at(d_wheel_start + std::chrono::milliseconds(next));
+            d_wheel_timer.async_wait([this](beast::error_code ec) { on_wheel_timer(ec); });
+        }
+
+        /*
+         * Hand due messages over to message delivery, reschedule repeats.
+         */
+        void websocket_pdu_impl::on_wheel_timer(beast::error_code ec)
+        {
+            if (ec == net::error::operation_aborted)
+            {
+                // Rearmed or stopped, armed state is up to date.
+                return;
+            }
+            d_wheel_armed = false;
+            if (ec)
+            {
+                return;
+            }
+
+            bool fired = false;
+            d_wheel.advance(wheel_tick(), [this, &fired](uint64_t expiry, scheduled_msg &&m) {
+                std::string s = m.repeat ? m.msg : std::move(m.msg);
+                if (!d_local_ring->push(std::move(s)))
+                {
+                    // Delivery is behind, try again next tick.
+                    if (!m.repeat)
+                    {
+                        m.msg = std::move(s);
+                    }
+                    d_wheel.insert(d_wheel.now() + 1, std::move(m));
+                    return;
+                }
+                fired = true;
+                if (m.repeat)
+                {
+                    d_wheel.insert(expiry + m.repeat, std::move(m));
+                }
+            });
+
+            if (fired)
+            {
+                notify_delivery();
+            }
+            arm_wheel();
+        }
+
+        /*
+         * Replay thread. Feeds the capture in order through the paths of
+         * client messages, paced by the capture time stamps. Each message is
+         * handled before the next one is read and sentences are published
+         * from this thread, bypassing rings and priority lanes, so every run
+         * publishes the same PDUs in the same order. Scheduled uploads go
+         * into a timer wheel of their own, run on capture time. Waits while
+         * downstream is throttled, like a paused client.
+         */
+        void websocket_pdu_impl::replay()
+        {
+            gr::thread::set_thread_name(gr::thread::get_current_thread_id(), "ws_replay");
+            const auto start = std::chrono::steady_clock::now();
+            uint64_t time = 0;
+            bool more = d_replay->next(time, d_replay_msg);
+            const uint64_t first = time;
+            long count = 0;
+            std::unique_lock<std::mutex> lock(d_replay_mutex);
+            while (!d_replay_stop)
+            {
+                // Next event in capture time, a record or a scheduled message
+                // before it. Repeats keep firing after the last record, unless
+                // that is as fast as possible.
+                uint64_t tick;
+                const bool timer = d_replay_wheel.next_tick(tick);
+                if (!more && (!timer || d_replay_speed == 0))
+                {
+                    break;
+                }
+                const bool record = more && (!timer || time / 1000000 < tick);
+                const uint64_t at = record ? time : std::max(tick * 1000000, first);
+                if (d_replay_speed > 0)
+                {
+                    const auto due =
+                        start + std::chrono::nanoseconds((uint64_t)((at - first) / d_replay_speed));
+                    d_replay_cond.wait_until(lock, due, [this] { return d_replay_stop; });
+                }
+                while (d_throttled && !d_replay_stop)
+                {
+                    d_replay_cond.wait_for(lock, std::chrono::milliseconds(1));
+                }
+                if (d_replay_stop)
+                {
+                    break;
+                }
+                lock.unlock();
+                replay_schedule(at / 1000000);
+                if (record)
+                {
+                    replay_msg(d_replay_msg, time);
+                    count++;
+                    more = d_replay->next(time, d_replay_msg);
+                }
+                lock.lock();
+            }
+            GR_LOG_INFO(d_logger, "Replayed " + std::to_string(count) + " messages");
+        }
+
+        /*
+         * Publish the replayed scheduled messages due by capture time now in
+         * milliseconds, reschedule repeats. Replay thread only.
+         */
+        void websocket_pdu_impl::replay_schedule(uint64_t now)
+        {
+            d_replay_wheel.advance(now, [this](uint64_t expiry, scheduled_msg &&m) {
+                set_string_msg(m.msg.data(), m.msg.size(), sentence_priority(m.msg.data(), m.msg.size()));
+                published(1);
+                if (m.repeat)
+                {
+                    d_replay_wheel.insert(expiry + m.repeat, std::move(m));
+                }
+            });
+        }
+
+        /*
+         * Handle one replayed message captured at time, waits until it is
+         * published.
+         */
+        void websocket_pdu_impl::replay_msg(const std::string &s, uint64_t time)
+        {
+            if (is_schedule(s))
+            {
+                const double unix_now = (d_replay->start() + time) / 1e9;
+                schedule(s, d_replay_wheel, d_replay_horizon, d_replay_wheel.now(), unix_now);
+                return;
+            }
+            if (is_vessel_delta(s))
+            {
+                // Vessel states belong to the I/O thread, publishing does not.
+                std::vector<std::string> msgs;
+                std::promise<void> done;
+                net::post(d_ioc, [this, &s, &msgs, &done] {
+                    vessel_delta(s, &msgs);
+                    done.set_value();
+                });
+                done.get_future().wait();
+                for (const auto &bits : msgs)
+                {
+                    set_string_msg(bits.data(), bits.size(), sentence_priority(bits.data(), bits.size()));
+                }
+                published(msgs.size());
+                return;
             }
+            published(set_batch_msg(s));
         }
 
     } /* namespace ais_simulator */
@@ -24,11 +24,24 @@
 #include <boost/beast/core.hpp>
 #include <boost/beast/websocket.hpp>
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <boost/asio/strand.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <thread>
 #include <vector>
 
 #include <gnuradio/ais_simulator/websocket_pdu.h>
+#include <gnuradio/thread/thread.h>
+#include "handler_memory.h"
+#include "priority_lanes.h"
+#include "session_capture.h"
+#include "spsc_ring.h"
+#include "timer_wheel.h"
+#include "vessel_store.h"
 
 namespace beast = boost::beast;         // From <boost/beast.hpp>
 namespace http = beast::http;           // From <boost/beast/http.hpp>
@@ -41,28 +54,169 @@ namespace gr
     namespace ais_simulator
     {
         class listener;
+        class session;
+        typedef spsc_ring<std::string> msg_ring;
+
         class websocket_pdu_impl : public websocket_pdu
         {
         private:
-            std::vector<uint8_t> d_msg_buffer;
-            pmt::pmt_t d_msg;
+            // Messages per session ring and per ring in one delivery batch.
+            static const size_t RING_CAPACITY = 1024;
+            static const int DELIVERY_BATCH = 64;
+
             const pmt::pmt_t d_out_port;
             const pmt::pmt_t d_in_port;
             const pmt::pmt_t d_send_port;
+            const pmt::pmt_t d_credit_port;
+            // Flow control, published messages not yet credited downstream.
+            const long d_high_watermark;
+            const long d_low_watermark;
+            const bool d_report_credit;
+            websocket::permessage_deflate d_deflate;
+            std::atomic<long> d_published{ 0 };
+            std::atomic<long> d_credited{ 0 };
+            // Messages wait in priority lanes until fewer than this many are
+            // published downstream and not yet credited. Delivery thread only.
+            const long d_max_in_flight;
+            std::atomic<long> d_sent{ 0 };
+            // Lanes hold sentences as offsets into the batch they came in, a
+            // batch is kept until all of its sentences are published.
+            struct lane_sentence {
+                uint64_t batch;
+                uint32_t offset;
+                uint32_t len;
+            };
+            struct held_batch {
+                std::string data;
+                long pending;
+            };
+            priority_lanes<lane_sentence> d_lanes;
+            lane_sentence d_sentence;
+            std::deque<held_batch> d_batches;
+            uint64_t d_batches_first = 0; // Number of d_batches.front()
+            std::vector<std::string> d_free_batches;
+            std::atomic<bool> d_throttled{ false };
+            // Sessions waiting to read again, I/O thread only.
+            std::vector<std::weak_ptr<session>> d_paused;
+            // Scheduled messages, the timer wheel runs on the I/O thread and
+            // ticks in milliseconds.
+            struct scheduled_msg {
+                std::string msg;
+                uint64_t repeat; // Ticks, zero sends once
+            };
+            timer_wheel<scheduled_msg> d_wheel;
+            // Vessel states updated by deltas, I/O thread only.
+            vessel_store d_vessels;
+            // Messages generated on the I/O thread.
+            std::shared_ptr<msg_ring> d_local_ring;
+            const std::chrono::steady_clock::time_point d_wheel_start;
+            uint64_t d_horizon = 0;
+            bool d_wheel_armed = false;
+            uint64_t d_wheel_due = 0; // Tick the timer is armed for
             gr::thread::thread d_thread;
+            gr::thread::thread d_delivery_thread;
             bool d_started;
+            // Session rings, consumed by the delivery thread.
+            std::mutex d_rings_mutex;
+            std::vector<std::shared_ptr<msg_ring>> d_rings;
+            std::atomic<unsigned> d_rings_version{ 0 };
+            // Delivery thread wake up.
+            std::mutex d_delivery_mutex;
+            std::condition_variable d_delivery_cond;
+            std::atomic<bool> d_delivery_idle{ false };
+            std::atomic<bool> d_delivery_stop{ false };
+            bool d_delivery_wake = false;
+            // Messages to clients, from the block thread to the I/O thread.
+            // One posted drain_send() at a time empties the ring.
+            struct send_msg {
+                std::string data;
+                bool binary = false;
+            };
+            spsc_ring<send_msg> d_send_ring{ RING_CAPACITY };
+            send_msg d_send_scratch; // Block thread
+            send_msg d_send_buf;     // I/O thread
+            std::atomic<bool> d_send_pending{ false };
+            std::atomic<uint64_t> d_send_dropped{ 0 };
+            handler_memory d_send_memory;
             std::shared_ptr<gr::ais_simulator::listener> d_listener = nullptr;
             // The io_context is required for all I/O
             net::io_context d_ioc{1};
-            void ioc_run() { d_ioc.run(); };
+            net::steady_timer d_wheel_timer{ d_ioc };
+            // Capture of client messages, written by its own thread.
+            std::unique_ptr<capture_writer> d_capture;
+            // Replay of a capture, from its own thread while the flow graph runs.
+            std::unique_ptr<capture_reader> d_replay;
+            const double d_replay_speed;
+            std::string d_replay_msg;
+            // Scheduled uploads of the replay, on capture time in milliseconds.
+            timer_wheel<scheduled_msg> d_replay_wheel;
+            uint64_t d_replay_horizon = 0;
+            gr::thread::thread d_replay_thread;
+            std::mutex d_replay_mutex;
+            std::condition_variable d_replay_cond;
+            bool d_replay_stop = false;
+            void ioc_run();
+            void deliver();
+            void drain_send();
+            void published(long n);
+            long enqueue_batch(std::string &s);
+            bool lanes_ready() const;
+            void publish_lanes();
+            void resume_sessions();
+            void report_credit();
+            uint64_t wheel_tick() const;
+            void arm_wheel();
+            void on_wheel_timer(beast::error_code ec);
+            void replay();
+            void replay_schedule(uint64_t now);
+            void replay_msg(const std::string &s, uint64_t time);
+            std::string schedule(const std::string &upload,
+                                 timer_wheel<scheduled_msg> &wheel,
+                                 uint64_t &horizon,
+                                 uint64_t now,
+                                 double unix_now);
 
         public:
-            websocket_pdu_impl(std::string addr, std::string port);
+            websocket_pdu_impl(std::string addr,
+                               std::string port,
+                               int high_watermark,
+                               int low_watermark,
+                               bool report_credit,
+                               int deflate_window_bits,
+                               int deflate_mem_level,
+                               int max_in_flight,
+                               int starvation_limit,
+                               std::string capture_file,
+                               std::string replay_file,
+                               double replay_speed);
             ~websocket_pdu_impl();
             void set_msg(pmt::pmt_t msg);
-            pmt::pmt_t msg() const { return d_msg; }
-            void set_string_msg(std::string s, std::size_t l);
+            void set_string_msg(const char *s, std::size_t l, priority_class c);
+            long set_batch_msg(const std::string &s);
+            const websocket::permessage_deflate &deflate() const { return d_deflate; }
             void ws_send_msg(pmt::pmt_t msg);
+            uint64_t send_dropped() const { return d_send_dropped; }
+            static bool stats_text(pmt::pmt_t msg, std::string &text);
+            void set_credit(pmt::pmt_t msg);
+            bool throttled() const { return d_throttled; }
+            bool pause(std::shared_ptr<session> s);
+            static bool is_schedule(const std::string &s);
+            std::string schedule(const std::string &upload);
+            static bool is_vessel_delta(const std::string &s);
+            std::string vessel_delta(const std::string &delta,
+                                     std::vector<std::string> *direct = nullptr);
+            // Record a client message, I/O thread only.
+            void capture(const std::string &s)
+            {
+                if (d_capture)
+                {
+                    d_capture->record(s.data(), s.size());
+                }
+            }
+            std::shared_ptr<msg_ring> add_ring();
+            void remove_ring(const std::shared_ptr<msg_ring> &ring);
+            void notify_delivery();
+            bool start();
             bool stop();
         };
 
@@ -72,16 +226,43 @@ namespace gr
             websocket::stream<beast::tcp_stream> d_ws;
             beast::flat_buffer d_buffer;
             websocket_pdu_impl *d_wsi;
-            std::vector<std::shared_ptr<std::string const>> d_queue;
+            // Sent buffers kept for reuse, at most this many.
+            static const size_t POOL_MAX = 64;
+            // Consumed queue entries are dropped from the front in steps of this.
+            static const size_t QUEUE_COMPACT = 64;
+            struct outgoing {
+                std::string data;
+                bool binary = false;
+            };
+            // Pending writes from d_queue_head on, the one in flight in d_sending.
+            std::vector<outgoing> d_queue;
+            size_t d_queue_head = 0;
+            outgoing d_sending;
+            bool d_writing = false;
+            std::vector<std::string> d_free;
+            // Recycled handler storage, one per kind of operation.
+            handler_memory d_read_memory;
+            handler_memory d_write_memory;
+            handler_memory d_retry_memory;
+            // Handoff to message delivery, filled on this session's strand only.
+            std::shared_ptr<msg_ring> d_ring;
+            std::string d_parked;
+            net::steady_timer d_retry_timer;
+            void enqueue();
+            void on_retry(beast::error_code ec);
+            void write_front();
 
         public:
-            explicit session(tcp::socket &&socket, websocket_pdu_impl *wsi) : d_ws(std::move(socket)), d_wsi{wsi} {}
+            explicit session(tcp::socket &&socket, websocket_pdu_impl *wsi);
+            ~session();
             void run();
             void close();
             void on_run();
             void on_accept(beast::error_code ec);
             void read();
-            void write(std::string s);
+            void write(const char *data, size_t len, bool binary = false);
+            void write(const std::string &s, bool binary = false) { write(s.data(), s.size(), binary); }
+            void resume();
             void on_read(beast::error_code ec, std::size_t bytes_transferred);
             void on_write(beast::error_code ec, std::size_t bytes_transferred);
         };
@@ -99,7 +280,7 @@ namespace gr
         public:
             listener(net::io_context &ioc, tcp::endpoint endpoint, websocket_pdu_impl *wsi);
             void run();
-            void send(std::string s);
+            void send(const std::string &s, bool binary);
         };
 
     } // namespace ais_simulator
@@ -14,10 +14,11 @@
 /* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
 /* BINDTOOL_USE_PYGCCXML(0)                                                        */
 /* BINDTOOL_HEADER_FILE(bitstring_to_frame.h)                                        */
-/* BINDTOOL_HEADER_FILE_HASH(4da6eda4379ae0ba187ce170bbbdcfc6)                     */
+/* BINDTOOL_HEADER_FILE_HASH(845354d9b417010fac325eacb0242632)                     */
 /***********************************************************************************/
 
 #include <pybind11/complex.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -43,8 +44,76 @@ void bind_bitstring_to_frame(py::module& m)
         .def(py::init(&bitstring_to_frame::make),
              py::arg("enable_nrzi"),
              py::arg("len_tag_key"),
+             py::arg("threads") = 0,
+             py::arg("format") = ::gr::ais_simulator::FRAME_PACKED,
+             py::arg("priority") = false,
+             py::arg("starvation_limit") = 8,
              D(bitstring_to_frame, make))
 
 
         ;
+
+    py::enum_<::gr::ais_simulator::frame_format>(m, "frame_format")
+        .value("FRAME_PACKED", ::gr::ais_simulator::FRAME_PACKED)     // 0
+        .value("FRAME_UNPACKED", ::gr::ais_simulator::FRAME_UNPACKED) // 1
+        .value("FRAME_NRZ", ::gr::ais_simulator::FRAME_NRZ)           // 2
+        .export_values();
+
+    py::implicitly_convertible<int, ::gr::ais_simulator::frame_format>();
+
+    m.def("max_frame_bytes",
+          &::gr::ais_simulator::max_frame_bytes,
+          py::arg("len_bits"),
+          D(max_frame_bytes));
+
+    // Arrays are used in place, rows may be strided but bytes within a row
+    // must be contiguous. Output arrays are never converted, a converted
+    // copy would silently drop the result.
+    m.def(
+        "encode_frames",
+        [](py::array_t<uint8_t> bits,
+           py::array_t<int32_t, py::array::c_style | py::array::forcecast> lengths,
+           py::array_t<uint8_t> out,
+           py::array_t<int32_t> out_lengths,
+           bool enable_nrzi,
+           int threads) {
+            if (bits.ndim() != 2 || out.ndim() != 2 || lengths.ndim() != 1 ||
+                out_lengths.ndim() != 1) {
+                throw std::invalid_argument(
+                    "encode_frames: bits and out must be 2-D, lengths 1-D");
+            }
+            const py::ssize_t n = bits.shape(0);
+            if (lengths.shape(0) != n || out.shape(0) < n || out_lengths.shape(0) < n) {
+                throw std::invalid_argument("encode_frames: Row counts differ");
+            }
+            if ((bits.shape(1) > 1 && bits.strides(1) != 1) ||
+                (out.shape(1) > 1 && out.strides(1) != 1) ||
+                (n > 1 && out_lengths.strides(0) != sizeof(int32_t))) {
+                throw std::invalid_argument("encode_frames: Rows must be contiguous");
+            }
+            const int32_t* len = lengths.data();
+            for (py::ssize_t i = 0; i < n; i++) {
+                if (len[i] > bits.shape(1)) {
+                    throw std::invalid_argument("encode_frames: Length exceeds bits row");
+                }
+                if (::gr::ais_simulator::max_frame_bytes(len[i]) > out.shape(1)) {
+                    throw std::invalid_argument("encode_frames: Output rows too short");
+                }
+            }
+            const uint8_t* in = bits.data();
+            uint8_t* o = out.mutable_data();
+            int32_t* ol = out_lengths.mutable_data();
+            const long bits_stride = bits.strides(0);
+            const long out_stride = out.strides(0);
+            py::gil_scoped_release release;
+            ::gr::ais_simulator::encode_frames(
+                in, bits_stride, len, n, enable_nrzi, o, out_stride, ol, threads);
+        },
+        py::arg("bits").noconvert(),
+        py::arg("lengths"),
+        py::arg("out").noconvert(),
+        py::arg("out_lengths").noconvert(),
+        py::arg("enable_nrzi") = true,
+        py::arg("threads") = 0,
+        D(encode_frames));
 }
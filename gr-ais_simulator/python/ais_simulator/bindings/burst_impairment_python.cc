@@ -0,0 +1,52 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(burst_impairment.h)                                     */
+/* BINDTOOL_HEADER_FILE_HASH(5b9f199ce4c01a978f2c95c095689ded)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/ais_simulator/burst_impairment.h>
+// pydoc.h is automatically generated in the build directory
+#include <burst_impairment_pydoc.h>
+
+void bind_burst_impairment(py::module& m)
+{
+
+    using burst_impairment = ::gr::ais_simulator::burst_impairment;
+
+
+    py::class_<burst_impairment, gr::block, gr::basic_block, std::shared_ptr<burst_impairment>>(
+        m, "burst_impairment", D(burst_impairment))
+
+        .def(py::init(&burst_impairment::make),
+             py::arg("samp_rate"),
+             py::arg("carrier_freq") = 162e6,
+             py::arg("ref_range") = 1000,
+             py::arg("ref_snr_db") = 30,
+             py::arg("two_ray") = false,
+             py::arg("tx_height") = 10,
+             py::arg("rx_height") = 10,
+             py::arg("seed") = 0,
+             D(burst_impairment, make))
+
+
+        ;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(burst_mixer.h)                                          */
+/* BINDTOOL_HEADER_FILE_HASH(0fd75e1dac2b540f34ffdd1195a892da)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/ais_simulator/burst_mixer.h>
+// pydoc.h is automatically generated in the build directory
+#include <burst_mixer_pydoc.h>
+
+void bind_burst_mixer(py::module& m)
+{
+
+    using burst_mixer = ::gr::ais_simulator::burst_mixer;
+
+
+    py::class_<burst_mixer, gr::sync_block, gr::block, gr::basic_block, std::shared_ptr<burst_mixer>>(
+        m, "burst_mixer", D(burst_mixer))
+
+        .def(py::init(&burst_mixer::make),
+             py::arg("samp_rate"),
+             py::arg("power_min_db") = 0,
+             py::arg("power_max_db") = 0,
+             py::arg("freq_offset_max") = 0,
+             py::arg("delay_max") = 0,
+             py::arg("max_active") = 64,
+             py::arg("seed") = 0,
+             D(burst_mixer, make))
+
+        .def("dropped", &burst_mixer::dropped, D(burst_mixer, dropped))
+
+
+        ;
+}
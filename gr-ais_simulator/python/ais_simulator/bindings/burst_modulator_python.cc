@@ -0,0 +1,53 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(burst_modulator.h)                                         */
+/* BINDTOOL_HEADER_FILE_HASH(1624c332d830a42af02f19f1c1a36f70)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/ais_simulator/burst_modulator.h>
+// pydoc.h is automatically generated in the build directory
+#include <burst_modulator_pydoc.h>
+
+void bind_burst_modulator(py::module& m)
+{
+
+    using burst_modulator = ::gr::ais_simulator::burst_modulator;
+
+
+    py::class_<burst_modulator, gr::block, gr::basic_block, std::shared_ptr<burst_modulator>>(
+        m, "burst_modulator", D(burst_modulator))
+
+        .def(py::init(&burst_modulator::make),
+             py::arg("samples_per_symbol"),
+             py::arg("bt") = 0.4,
+             py::arg("format") = ::gr::ais_simulator::FRAME_PACKED,
+             py::arg("cache_mb") = 64,
+             py::arg("len_tag_key") = "packet_len",
+             D(burst_modulator, make))
+
+        .def("hits", &burst_modulator::hits, D(burst_modulator, hits))
+        .def("misses", &burst_modulator::misses, D(burst_modulator, misses))
+        .def("cached_bytes", &burst_modulator::cached_bytes, D(burst_modulator, cached_bytes))
+
+
+        ;
+}
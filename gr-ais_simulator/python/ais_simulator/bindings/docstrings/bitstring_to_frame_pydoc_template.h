@@ -23,3 +23,9 @@ static const char* __doc_gr_ais_simulator_bitstring_to_frame_bitstring_to_frame
 
 
 static const char* __doc_gr_ais_simulator_bitstring_to_frame_make = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_max_frame_bytes = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_encode_frames = R"doc()doc";
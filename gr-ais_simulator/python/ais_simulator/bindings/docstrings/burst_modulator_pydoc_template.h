@@ -0,0 +1,33 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+#include "pydoc_macros.h"
+#define D(...) DOC(gr, ais_simulator, __VA_ARGS__)
+/*
+  This file contains placeholders for docstrings for the Python bindings.
+  Do not edit! These were automatically extracted during the binding process
+  and will be overwritten during the build process
+ */
+
+
+static const char* __doc_gr_ais_simulator_burst_modulator = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_burst_modulator_burst_modulator = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_burst_modulator_make = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_burst_modulator_hits = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_burst_modulator_misses = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_burst_modulator_cached_bytes = R"doc()doc";
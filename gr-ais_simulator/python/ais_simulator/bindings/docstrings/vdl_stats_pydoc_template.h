@@ -0,0 +1,48 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+#include "pydoc_macros.h"
+#define D(...) DOC(gr, ais_simulator, __VA_ARGS__)
+/*
+  This file contains placeholders for docstrings for the Python bindings.
+  Do not edit! These were automatically extracted during the binding process
+  and will be overwritten during the build process
+ */
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats_vdl_stats = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats_make = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats_frames = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats_errors = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats_slots_per_minute = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats_slot_occupancy = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats_air_time = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats_stations = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats_stations_dropped = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_vdl_stats_slot_histogram = R"doc()doc";
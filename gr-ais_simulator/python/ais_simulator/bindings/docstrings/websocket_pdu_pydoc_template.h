@@ -22,3 +22,6 @@ static const char* __doc_gr_ais_simulator_websocket_pdu_websocket_pdu = R"doc()d
 
 
 static const char* __doc_gr_ais_simulator_websocket_pdu_make = R"doc()doc";
+
+
+static const char* __doc_gr_ais_simulator_websocket_pdu_send_dropped = R"doc()doc";
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(frame_decoder.h)                                        */
+/* BINDTOOL_HEADER_FILE_HASH(492eb6c1366e720e81499e93a30e90b4)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/ais_simulator/frame_decoder.h>
+// pydoc.h is automatically generated in the build directory
+#include <frame_decoder_pydoc.h>
+
+void bind_frame_decoder(py::module& m)
+{
+
+    using frame_decoder = ::gr::ais_simulator::frame_decoder;
+
+
+    py::class_<frame_decoder, gr::sync_block, gr::block, gr::basic_block, std::shared_ptr<frame_decoder>>(
+        m, "frame_decoder", D(frame_decoder))
+
+        .def(py::init(&frame_decoder::make),
+             py::arg("samp_rate"),
+             py::arg("baud_rate") = 9600,
+             D(frame_decoder, make))
+
+        .def("frames", &frame_decoder::frames, D(frame_decoder, frames))
+        .def("crc_errors", &frame_decoder::crc_errors, D(frame_decoder, crc_errors))
+
+
+        ;
+}
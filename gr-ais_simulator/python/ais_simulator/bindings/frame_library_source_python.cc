@@ -0,0 +1,55 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(frame_library_source.h)                                    */
+/* BINDTOOL_HEADER_FILE_HASH(fc0b755eb0d03f32ab8273cf62d66a3c)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/ais_simulator/frame_library_source.h>
+// pydoc.h is automatically generated in the build directory
+#include <frame_library_source_pydoc.h>
+
+void bind_frame_library_source(py::module& m)
+{
+
+    using frame_library_source = ::gr::ais_simulator::frame_library_source;
+
+
+    py::class_<frame_library_source,
+               gr::sync_block,
+               gr::block,
+               gr::basic_block,
+               std::shared_ptr<frame_library_source>>(
+        m, "frame_library_source", D(frame_library_source))
+
+        .def(py::init(&frame_library_source::make),
+             py::arg("filename"),
+             py::arg("len_tag_key") = "packet_len",
+             py::arg("repeat") = false,
+             py::arg("format") = ::gr::ais_simulator::FRAME_PACKED,
+             D(frame_library_source, make))
+
+        .def("frames", &frame_library_source::frames, D(frame_library_source, frames))
+        .def("sent", &frame_library_source::sent, D(frame_library_source, sent))
+
+
+        ;
+}
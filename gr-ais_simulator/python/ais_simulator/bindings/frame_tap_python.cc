@@ -0,0 +1,53 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(frame_tap.h)                                               */
+/* BINDTOOL_HEADER_FILE_HASH(305c84718369f9639c318fe837407880)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/ais_simulator/frame_tap.h>
+// pydoc.h is automatically generated in the build directory
+#include <frame_tap_pydoc.h>
+
+void bind_frame_tap(py::module& m)
+{
+
+    using frame_tap = ::gr::ais_simulator::frame_tap;
+
+
+    py::class_<frame_tap, gr::sync_block, gr::block, gr::basic_block, std::shared_ptr<frame_tap>>(
+        m, "frame_tap", D(frame_tap))
+
+        .def(py::init(&frame_tap::make),
+             py::arg("enable_nrzi"),
+             py::arg("len_tag_key"),
+             py::arg("baud_rate") = 9600,
+             py::arg("channel") = 'A',
+             py::arg("queue_size") = 1024,
+             py::arg("format") = ::gr::ais_simulator::FRAME_PACKED,
+             D(frame_tap, make))
+
+        .def("frames", &frame_tap::frames, D(frame_tap, frames))
+        .def("dropped", &frame_tap::dropped, D(frame_tap, dropped))
+
+
+        ;
+}
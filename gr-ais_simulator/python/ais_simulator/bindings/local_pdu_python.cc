@@ -0,0 +1,47 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(local_pdu.h)                                            */
+/* BINDTOOL_HEADER_FILE_HASH(d2d6bf2573dc7e7d9ef104847d0d74ae)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/ais_simulator/local_pdu.h>
+// pydoc.h is automatically generated in the build directory
+#include <local_pdu_pydoc.h>
+
+void bind_local_pdu(py::module& m)
+{
+
+    using local_pdu = ::gr::ais_simulator::local_pdu;
+
+
+    py::class_<local_pdu, gr::block, gr::basic_block, std::shared_ptr<local_pdu>>(
+        m, "local_pdu", D(local_pdu))
+
+        .def(py::init(&local_pdu::make),
+             py::arg("socket_path"),
+             py::arg("shm_name"),
+             py::arg("shm_size") = 1 << 20,
+             D(local_pdu, make))
+
+
+        ;
+}
@@ -22,6 +22,15 @@ namespace py = pybind11;
 /**************************************/
 // BINDING_FUNCTION_PROTOTYPES(
 void bind_bitstring_to_frame(py::module& m);
+void bind_burst_impairment(py::module& m);
+void bind_burst_mixer(py::module& m);
+void bind_burst_modulator(py::module& m);
+void bind_frame_decoder(py::module& m);
+void bind_frame_library_source(py::module& m);
+void bind_frame_tap(py::module& m);
+void bind_local_pdu(py::module& m);
+void bind_udp_nmea_pdu(py::module& m);
+void bind_vdl_stats(py::module& m);
 void bind_websocket_pdu(py::module& m);
 // ) END BINDING_FUNCTION_PROTOTYPES
 
@@ -52,6 +61,15 @@ PYBIND11_MODULE(ais_simulator_python, m)
     /**************************************/
     // BINDING_FUNCTION_CALLS(
     bind_bitstring_to_frame(m);
+    bind_burst_impairment(m);
+    bind_burst_mixer(m);
+    bind_burst_modulator(m);
+    bind_frame_decoder(m);
+    bind_frame_library_source(m);
+    bind_frame_tap(m);
+    bind_local_pdu(m);
+    bind_udp_nmea_pdu(m);
+    bind_vdl_stats(m);
     bind_websocket_pdu(m);
     // ) END BINDING_FUNCTION_CALLS
 }
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(udp_nmea_pdu.h)                                         */
+/* BINDTOOL_HEADER_FILE_HASH(5132d316384aca13a9651bc27dc43bf5)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/ais_simulator/udp_nmea_pdu.h>
+// pydoc.h is automatically generated in the build directory
+#include <udp_nmea_pdu_pydoc.h>
+
+void bind_udp_nmea_pdu(py::module& m)
+{
+
+    using udp_nmea_pdu = ::gr::ais_simulator::udp_nmea_pdu;
+
+
+    py::class_<udp_nmea_pdu, gr::block, gr::basic_block, std::shared_ptr<udp_nmea_pdu>>(
+        m, "udp_nmea_pdu", D(udp_nmea_pdu))
+
+        .def(py::init(&udp_nmea_pdu::make),
+             py::arg("addr"),
+             py::arg("port"),
+             py::arg("verify_checksum") = true,
+             D(udp_nmea_pdu, make))
+
+        .def("sentences", &udp_nmea_pdu::sentences, D(udp_nmea_pdu, sentences))
+        .def("dropped", &udp_nmea_pdu::dropped, D(udp_nmea_pdu, dropped))
+        .def("errors", &udp_nmea_pdu::errors, D(udp_nmea_pdu, errors))
+
+
+        ;
+}
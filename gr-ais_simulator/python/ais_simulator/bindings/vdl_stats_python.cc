@@ -0,0 +1,61 @@
+/*
+ * Copyright 2022 Free Software Foundation, Inc.
+ *
+ * This file is part of GNU Radio
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ */
+
+/***********************************************************************************/
+/* This file is automatically generated using bindtool and can be manually edited  */
+/* The following lines can be configured to regenerate this file during cmake      */
+/* If manual edits are made, the following tags should be modified accordingly.    */
+/* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
+/* BINDTOOL_USE_PYGCCXML(0)                                                        */
+/* BINDTOOL_HEADER_FILE(vdl_stats.h)                                               */
+/* BINDTOOL_HEADER_FILE_HASH(68c82e77cd6a0ccf9f5198f87c8cb7f8)                     */
+/***********************************************************************************/
+
+#include <pybind11/complex.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+
+#include <gnuradio/ais_simulator/vdl_stats.h>
+// pydoc.h is automatically generated in the build directory
+#include <vdl_stats_pydoc.h>
+
+void bind_vdl_stats(py::module& m)
+{
+
+    using vdl_stats = ::gr::ais_simulator::vdl_stats;
+
+
+    py::class_<vdl_stats, gr::sync_block, gr::block, gr::basic_block, std::shared_ptr<vdl_stats>>(
+        m, "vdl_stats", D(vdl_stats))
+
+        .def(py::init(&vdl_stats::make),
+             py::arg("enable_nrzi"),
+             py::arg("len_tag_key"),
+             py::arg("channel") = 'A',
+             py::arg("baud_rate") = 9600,
+             py::arg("window") = 60,
+             py::arg("report_interval") = 10,
+             py::arg("max_stations") = 4096,
+             py::arg("format") = ::gr::ais_simulator::FRAME_PACKED,
+             D(vdl_stats, make))
+
+        .def("frames", &vdl_stats::frames, D(vdl_stats, frames))
+        .def("errors", &vdl_stats::errors, D(vdl_stats, errors))
+        .def("slots_per_minute", &vdl_stats::slots_per_minute, D(vdl_stats, slots_per_minute))
+        .def("slot_occupancy", &vdl_stats::slot_occupancy, D(vdl_stats, slot_occupancy))
+        .def("air_time", &vdl_stats::air_time, D(vdl_stats, air_time))
+        .def("stations", &vdl_stats::stations, D(vdl_stats, stations))
+        .def("stations_dropped", &vdl_stats::stations_dropped, D(vdl_stats, stations_dropped))
+        .def("slot_histogram", &vdl_stats::slot_histogram, D(vdl_stats, slot_histogram))
+
+
+        ;
+}
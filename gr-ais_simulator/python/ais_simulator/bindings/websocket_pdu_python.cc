@@ -14,7 +14,7 @@
 /* BINDTOOL_GEN_AUTOMATIC(0)                                                       */
 /* BINDTOOL_USE_PYGCCXML(0)                                                        */
 /* BINDTOOL_HEADER_FILE(websocket_pdu.h)                                        */
-/* BINDTOOL_HEADER_FILE_HASH(ab3c68eddcef6fda1cac2437b1bfac11)                     */
+/* BINDTOOL_HEADER_FILE_HASH(a5b2459734ec2503837613dbe272bd83)                     */
 /***********************************************************************************/
 
 #include <pybind11/complex.h>
@@ -39,8 +39,20 @@ void bind_websocket_pdu(py::module& m)
         .def(py::init(&websocket_pdu::make),
              py::arg("addr"),
              py::arg("port"),
+             py::arg("high_watermark") = 0,
+             py::arg("low_watermark") = 0,
+             py::arg("report_credit") = false,
+             py::arg("deflate_window_bits") = 0,
+             py::arg("deflate_mem_level") = 8,
+             py::arg("max_in_flight") = 0,
+             py::arg("starvation_limit") = 8,
+             py::arg("capture_file") = "",
+             py::arg("replay_file") = "",
+             py::arg("replay_speed") = 1.0,
              D(websocket_pdu, make))
 
+        .def("send_dropped", &websocket_pdu::send_dropped, D(websocket_pdu, send_dropped))
+
 
         ;
 }